@@ -0,0 +1,927 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//HeadlessOrbiter.cpp
+//Implementation of the oapi* functions and VESSEL members declared in
+//include/, plus the point-mass integrator behind HeadlessSim.
+//
+//==========================================
+
+#include "HeadlessOrbiter.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static double g_simt = 0.0;
+static double g_simdt = 0.0;
+static char g_debugstr[256];
+static std::map<std::string, HeadlessMesh *> g_global_meshes;
+static HeadlessVessel *g_camera_target = 0;
+static double g_camera_dist = 0.0;
+static int g_texture_count = 0;
+static size_t g_texture_bytes = 0;
+
+static const double EARTH_RADIUS = 6.371e6;
+static const double EARTH_G0 = 9.80665;
+
+///////////////Helpers
+
+static HeadlessVessel *HV(OBJHANDLE h){
+    return (HeadlessVessel *)h;
+}
+
+static std::string Trim(const std::string &s){
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if(b == std::string::npos) return std::string();
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return s.substr(b, e - b + 1);
+}
+
+void HeadlessAtmosphere(double alt, double &rho, double &p, double &T){
+    //US Standard Atmosphere 1976, geopotential layers up to 86 km.
+    static const double hb[8] = {0, 11000, 20000, 32000, 47000, 51000, 71000, 84852};
+    static const double lb[7] = {-6.5e-3, 0.0, 1.0e-3, 2.8e-3, 0.0, -2.8e-3, -2.0e-3};
+    const double R = 287.053;
+    double h = std::max(0.0, alt * EARTH_RADIUS / (EARTH_RADIUS + alt));
+    double Tb = 288.15, pb = 101325.0;
+    int i;
+    for(i = 0; i < 7 && h > hb[i + 1]; i++){
+        double dh = hb[i + 1] - hb[i];
+        double Tn = Tb + lb[i] * dh;
+        pb = (lb[i] == 0.0) ? pb * exp(-EARTH_G0 * dh / (R * Tb)) : pb * pow(Tn / Tb, -EARTH_G0 / (lb[i] * R));
+        Tb = Tn;
+    }
+    if(i == 7){
+        rho = p = 0.0;
+        T = Tb;
+        return;
+    }
+    double dh = h - hb[i];
+    T = Tb + lb[i] * dh;
+    p = (lb[i] == 0.0) ? pb * exp(-EARTH_G0 * dh / (R * Tb)) : pb * pow(T / Tb, -EARTH_G0 / (lb[i] * R));
+    rho = p / (R * T);
+}
+
+///////////////Mesh files
+
+bool HeadlessMesh::LoadMsh(const char *path){
+    std::ifstream f(path);
+    if(!f) return false;
+    std::string tok;
+    f >> tok;
+    if(tok != "MSHX1") return false;
+    int ngrp = 0;
+    f >> tok >> ngrp;
+    groups.resize(ngrp);
+    for(int g = 0; g < ngrp; g++){
+        HeadlessMeshGroup &grp = groups[g];
+        int nv = 0, nt = 0;
+        while(f >> tok){
+            if(tok == "GEOM"){
+                f >> nv >> nt;
+                break;
+            } else if(tok == "LABEL"){
+                std::getline(f, grp.label);
+                grp.label = Trim(grp.label);
+            } else if(tok == "MATERIAL"){
+                f >> grp.material;
+            } else if(tok == "TEXTURE"){
+                f >> grp.texture;
+            } else {
+                std::string rest;
+                std::getline(f, rest);
+            }
+        }
+        std::string line;
+        std::getline(f, line);
+        grp.vtx.assign((size_t)nv * 8, 0.0f);
+        for(int i = 0; i < nv; i++){
+            std::getline(f, line);
+            const char *s = line.c_str();
+            char *e;
+            for(int k = 0; k < 8; k++){
+                float v = strtof(s, &e);
+                if(e == s) break;
+                grp.vtx[i * 8 + k] = v;
+                s = e;
+            }
+        }
+        grp.idx.resize((size_t)nt * 3);
+        for(int i = 0; i < nt * 3; i++){
+            int v;
+            f >> v;
+            grp.idx[i] = (WORD)v;
+        }
+    }
+    int n = 0;
+    if(f >> tok && tok == "MATERIALS" && f >> n){
+        materials.resize(n);
+        for(int i = 0; i < n; i++) f >> materials[i];
+        for(int i = 0; i < n; i++){
+            std::string line;
+            f >> tok >> tok;
+            std::getline(f, line);
+            for(int k = 0; k < 4; k++) std::getline(f, line);
+        }
+    }
+    if(f >> tok && tok == "TEXTURES" && f >> n){
+        textures.resize(n);
+        for(int i = 0; i < n; i++) f >> textures[i];
+    }
+    return true;
+}
+
+size_t HeadlessMesh::Bytes() const{
+    size_t n = sizeof(*this) + groups.capacity() * sizeof(HeadlessMeshGroup);
+    for(const HeadlessMeshGroup &g : groups)
+        n += g.label.capacity() + g.vtx.capacity() * sizeof(float) + g.idx.capacity() * sizeof(WORD);
+    for(const std::string &m : materials) n += sizeof(m) + m.capacity();
+    for(const std::string &t : textures) n += sizeof(t) + t.capacity();
+    return n;
+}
+
+size_t HeadlessMesh::Triangles() const{
+    size_t n = 0;
+    for(const HeadlessMeshGroup &g : groups) n += g.idx.size() / 3;
+    return n;
+}
+
+MESHHANDLE oapiLoadMesh(const char *fname){
+    HeadlessMesh *mesh = new HeadlessMesh;
+    std::string path = HeadlessSim::ResolvePath("Meshes", fname, ".msh");
+    if(!mesh->LoadMsh(path.c_str())){
+        fprintf(stderr, "headless: cannot load mesh %s\n", path.c_str());
+        delete mesh;
+        return 0;
+    }
+    return (MESHHANDLE)mesh;
+}
+
+MESHHANDLE oapiLoadMeshGlobal(const char *fname){
+    HeadlessMesh *&mesh = g_global_meshes[fname];
+    if(!mesh) mesh = (HeadlessMesh *)oapiLoadMesh(fname);
+    return (MESHHANDLE)mesh;
+}
+
+void oapiDeleteMesh(MESHHANDLE hMesh){
+    delete (HeadlessMesh *)hMesh;
+}
+
+DWORD oapiMeshGroupCount(MESHHANDLE hMesh){
+    return hMesh ? (DWORD)((HeadlessMesh *)hMesh)->groups.size() : 0;
+}
+
+//Copies the group data, as the Orbiter core does.
+MESHHANDLE oapiCreateMesh(DWORD ngrp, MESHGROUP *grp){
+    HeadlessMesh *mesh = new HeadlessMesh;
+    mesh->groups.resize(ngrp);
+    for(DWORD g = 0; g < ngrp; g++){
+        HeadlessMeshGroup &hg = mesh->groups[g];
+        hg.material = grp[g].MtrlIdx;
+        hg.texture = grp[g].TexIdx;
+        hg.vtx.assign((const float *)grp[g].Vtx, (const float *)(grp[g].Vtx + grp[g].nVtx));
+        hg.idx.assign(grp[g].Idx, grp[g].Idx + grp[g].nIdx);
+    }
+    return (MESHHANDLE)mesh;
+}
+
+int oapiAddMaterial(MESHHANDLE hMesh, MATERIAL *mtrl){
+    HeadlessMesh *mesh = (HeadlessMesh *)hMesh;
+    mesh->materials.push_back(std::string());
+    return (int)mesh->materials.size() - 1;
+}
+
+//Textures are not decoded; only their file sizes are kept, as the memory
+//the client would give them.
+SURFHANDLE oapiLoadTexture(const char *fname, bool dynamic){
+    std::string path = HeadlessSim::ResolvePath("Textures", fname, ".dds");
+    struct stat st;
+    if(stat(path.c_str(), &st)) return 0;
+    HeadlessTexture *tex = new HeadlessTexture;
+    tex->path = path;
+    tex->bytes = (size_t)st.st_size;
+    std::string norm = path.substr(0, path.size() - 4) + "_norm.dds";
+    if(!stat(norm.c_str(), &st)) tex->bytes += (size_t)st.st_size;
+    g_texture_count++;
+    g_texture_bytes += tex->bytes;
+    return (SURFHANDLE)tex;
+}
+
+void oapiReleaseTexture(SURFHANDLE hTex){
+    HeadlessTexture *tex = (HeadlessTexture *)hTex;
+    if(!tex) return;
+    g_texture_count--;
+    g_texture_bytes -= tex->bytes;
+    delete tex;
+}
+
+bool oapiSetTexture(MESHHANDLE hMesh, DWORD texidx, SURFHANDLE tex){
+    HeadlessMesh *mesh = (HeadlessMesh *)hMesh;
+    if(!mesh || texidx < 1) return false;
+    if(mesh->textures.size() < texidx) mesh->textures.resize(texidx);
+    if(mesh->surfaces.size() < texidx) mesh->surfaces.resize(texidx);
+    mesh->surfaces[texidx - 1] = tex;
+    return true;
+}
+
+bool oapiSetTexture(DEVMESHHANDLE hMesh, DWORD texidx, SURFHANDLE tex){
+    HeadlessDevMesh *dm = (HeadlessDevMesh *)(MESHHANDLE)hMesh;
+    if(!dm || texidx < 1) return false;
+    if(dm->surfaces.size() < texidx) dm->surfaces.resize(texidx);
+    dm->surfaces[texidx - 1] = tex;
+    dm->stats->set_texture++;
+    return true;
+}
+
+SURFHANDLE oapiRegisterExhaustTexture(const char *name){
+    return 0;
+}
+
+///////////////Camera: a 1920x1080 viewport with a 20 degree half aperture
+
+void oapiCameraGlobalPos(VECTOR3 *gpos){
+    VECTOR3 p = {0, 0, 0};
+    if(g_camera_target) p = _V(g_camera_target->x, g_camera_target->alt, -g_camera_dist);
+    *gpos = p;
+}
+
+double oapiCameraAperture(void){
+    return 20.0 * RAD;
+}
+
+void oapiGetViewportSize(DWORD *w, DWORD *h, DWORD *bpp){
+    *w = 1920;
+    *h = 1080;
+    if(bpp) *bpp = 32;
+}
+
+///////////////Aerodynamics helpers (same closed forms as Orbiter)
+
+double oapiGetInducedDrag(double cl, double A, double e){
+    return cl * cl / (PI * A * e);
+}
+
+double oapiGetWaveDrag(double M, double M1, double M2, double M3, double cmax){
+    if(M < M1) return 0.0;
+    else if(M < M2) return cmax * (M - M1) / (M2 - M1);
+    else if(M < M3) return cmax;
+    else return cmax * sqrt((M3 * M3 - 1.0) / (M * M - 1.0));
+}
+
+///////////////Scenario files
+
+HeadlessFile *HeadlessFile::OpenScenarioShip(const char *scnpath, const char *shipname){
+    std::ifstream f(scnpath);
+    if(!f) return 0;
+    HeadlessFile *file = new HeadlessFile;
+    std::string line;
+    bool inships = false, inblock = false;
+    size_t nlen = strlen(shipname);
+    while(std::getline(f, line)){
+        std::string t = Trim(line);
+        if(!inships){
+            inships = (t == "BEGIN_SHIPS");
+        } else if(!inblock){
+            if(t == "END_SHIPS") break;
+            inblock = (t.compare(0, nlen, shipname) == 0 && t.size() > nlen && t[nlen] == ':');
+        } else {
+            file->lines.push_back(line);
+            if(t == "END") break;
+        }
+    }
+    return file;
+}
+
+HeadlessFile *HeadlessFile::FromText(const std::string &text){
+    HeadlessFile *file = new HeadlessFile;
+    std::istringstream ss(text);
+    std::string line;
+    while(std::getline(ss, line)) file->lines.push_back(line);
+    file->lines.push_back("END");
+    return file;
+}
+
+HeadlessFile *HeadlessFile::ForWriting(){
+    return new HeadlessFile;
+}
+
+//"item = value" lines, as in a vessel class .cfg.
+static bool ReadItem(FILEHANDLE f, const char *item, std::string &val){
+    HeadlessFile *file = (HeadlessFile *)f;
+    size_t n = strlen(item);
+    for(const std::string &line : file->lines){
+        std::string l = Trim(line);
+        if(strncasecmp(l.c_str(), item, n) || (l.size() > n && l[n] != ' ' && l[n] != '\t' && l[n] != '=')) continue;
+        size_t eq = l.find('=', n);
+        if(eq == std::string::npos) continue;
+        size_t semi = l.find(';', eq);
+        val = Trim(l.substr(eq + 1, semi == std::string::npos ? std::string::npos : semi - eq - 1));
+        return true;
+    }
+    return false;
+}
+
+bool oapiReadItem_bool(FILEHANDLE f, const char *item, bool &val){
+    std::string v;
+    if(!ReadItem(f, item, v)) return false;
+    if(!strcasecmp(v.c_str(), "TRUE")) val = true;
+    else if(!strcasecmp(v.c_str(), "FALSE")) val = false;
+    else return false;
+    return true;
+}
+
+bool oapiReadItem_float(FILEHANDLE f, const char *item, double &val){
+    std::string v;
+    return ReadItem(f, item, v) && sscanf(v.c_str(), "%lf", &val) == 1;
+}
+
+bool oapiReadItem_vec(FILEHANDLE f, const char *item, VECTOR3 &val){
+    std::string v;
+    VECTOR3 r;
+    if(!ReadItem(f, item, v) || sscanf(v.c_str(), "%lf%lf%lf", &r.x, &r.y, &r.z) != 3) return false;
+    val = r;
+    return true;
+}
+
+bool oapiReadItem_int(FILEHANDLE f, const char *item, int &val){
+    std::string v;
+    return ReadItem(f, item, v) && sscanf(v.c_str(), "%d", &val) == 1;
+}
+
+//Like Orbiter, no length: the caller's buffer holds any config line, up to
+//1024 bytes with the NUL. Longer values are cut there.
+bool oapiReadItem_string(FILEHANDLE f, const char *item, char *string){
+    std::string v;
+    if(!ReadItem(f, item, v)) return false;
+    snprintf(string, 1024, "%s", v.c_str());
+    return true;
+}
+
+bool oapiReadScenario_nextline(FILEHANDLE scn, char *&line){
+    HeadlessFile *file = (HeadlessFile *)scn;
+    if(file->next >= file->lines.size()) return false;
+    const std::string &l = file->lines[file->next++];
+    size_t b = l.find_first_not_of(" \t");
+    file->cur = (b == std::string::npos) ? std::string() : l.substr(b);
+    if(!file->cur.compare(0, 3, "END") && (file->cur.size() == 3 || isspace((unsigned char)file->cur[3])))
+        return false;
+    if(file->stats) file->stats->scenario_lines_read++;
+    line = &file->cur[0];
+    return true;
+}
+
+void oapiWriteLine(FILEHANDLE file, const char *line){
+    HeadlessFile *f = (HeadlessFile *)file;
+    f->out += line;
+    f->out += '\n';
+    if(f->stats) f->stats->scenario_lines_written++;
+}
+
+void oapiWriteScenario_string(FILEHANDLE scn, const char *item, const char *string){
+    HeadlessFile *f = (HeadlessFile *)scn;
+    f->out += "  ";
+    f->out += item;
+    f->out += ' ';
+    f->out += string;
+    f->out += '\n';
+    if(f->stats) f->stats->scenario_lines_written++;
+}
+
+void oapiWriteScenario_int(FILEHANDLE scn, const char *item, int i){
+    char cbuf[32];
+    sprintf(cbuf, "%d", i);
+    oapiWriteScenario_string(scn, item, cbuf);
+}
+
+void oapiWriteScenario_float(FILEHANDLE scn, const char *item, double d){
+    char cbuf[64];
+    sprintf(cbuf, "%g", d);
+    oapiWriteScenario_string(scn, item, cbuf);
+}
+
+void oapiWriteScenario_vec(FILEHANDLE scn, const char *item, const VECTOR3 &vec){
+    char cbuf[128];
+    sprintf(cbuf, "%g %g %g", vec.x, vec.y, vec.z);
+    oapiWriteScenario_string(scn, item, cbuf);
+}
+
+///////////////Simulation state
+
+double oapiGetSimTime(void){
+    return g_simt;
+}
+
+double oapiGetSimStep(void){
+    return g_simdt;
+}
+
+char *oapiDebugString(void){
+    return g_debugstr;
+}
+
+void oapiWriteLog(const char *line){
+    fprintf(stderr, "%s\n", line);
+}
+
+void oapiWriteLogV(const char *format, ...){
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+///////////////VESSEL
+
+HeadlessVessel::HeadlessVessel(const char *_name, const char *_classname) :
+    name(_name), classname(_classname), thgroups(THGROUP_USER + 1){
+}
+
+double HeadlessVessel::Mass() const{
+    double m = empty_mass;
+    for(const HeadlessPropellant &p : propellants) m += p.mass;
+    return m;
+}
+
+VESSEL::VESSEL(OBJHANDLE hVessel, int fmodel) : hObj(hVessel), hv(HV(hVessel)){
+    hv->vessel = this;
+}
+
+VESSEL::~VESSEL(){
+}
+
+const char *VESSEL::GetName() const {return hv->name.c_str();}
+const char *VESSEL::GetClassName() const {return hv->classname.c_str();}
+
+void VESSEL::SetSize(double size) const {hv->size = size;}
+void VESSEL::SetEmptyMass(double m) const {hv->empty_mass = m;}
+void VESSEL::SetCrossSections(const VECTOR3 &cs) const {hv->cs = cs;}
+void VESSEL::SetPMI(const VECTOR3 &pmi) const {hv->pmi = pmi;}
+void VESSEL::SetMaxWheelbrakeForce(double f) const {hv->wheelbrake = f;}
+void VESSEL::ShiftCentreOfMass(const VECTOR3 &shift) {hv->cg_shift = hv->cg_shift + shift;}
+void VESSEL::ShiftCG(const VECTOR3 &shift) {hv->cg_shift = hv->cg_shift + shift;}
+void VESSEL::SetWingEffectiveness(double eff) const {hv->wing_eff = eff;}
+void VESSEL::SetRotDrag(const VECTOR3 &rd) const {hv->rotdrag = rd;}
+void VESSEL::SetNosewheelSteering(bool activate) const {hv->nosewheel_steering = activate;}
+
+void VESSEL::SetTouchdownPoints(const TOUCHDOWNVTX *tdvtx, DWORD ntdvtx) const{
+    hv->tdvtx.assign(tdvtx, tdvtx + ntdvtx);
+    hv->stats.set_touchdown++;
+}
+
+PROPELLANT_HANDLE VESSEL::CreatePropellantResource(double maxmass, double mass, double efficiency) const{
+    HeadlessPropellant p = {maxmass, mass < 0.0 ? maxmass : mass};
+    hv->propellants.push_back(p);
+    return (PROPELLANT_HANDLE)(intptr_t)hv->propellants.size();
+}
+
+double VESSEL::GetPropellantMass(PROPELLANT_HANDLE ph) const{
+    return ph ? hv->propellants[(intptr_t)ph - 1].mass : 0.0;
+}
+
+double VESSEL::GetFuelMass() const{
+    return hv->propellants.empty() ? 0.0 : hv->propellants[0].mass;
+}
+
+double VESSEL::GetPropellantMaxMass(PROPELLANT_HANDLE ph) const{
+    return ph ? hv->propellants[(intptr_t)ph - 1].maxmass : 0.0;
+}
+
+THRUSTER_HANDLE VESSEL::CreateThruster(const VECTOR3 &pos, const VECTOR3 &dir, double maxth0,
+    PROPELLANT_HANDLE hp, double isp0, double isp_ref, double p_ref) const{
+    HeadlessThruster th;
+    th.pos = pos;
+    th.dir = dir;
+    th.maxth0 = maxth0;
+    th.prop = hp ? (int)(intptr_t)hp - 1 : -1;
+    th.isp0 = isp0;
+    hv->thrusters.push_back(th);
+    return hv->ThrusterHandle((int)hv->thrusters.size() - 1);
+}
+
+THGROUP_HANDLE VESSEL::CreateThrusterGroup(THRUSTER_HANDLE *th, int nth, THGROUP_TYPE thgt) const{
+    std::vector<int> &grp = hv->thgroups[thgt];
+    for(int i = 0; i < nth; i++) grp.push_back(hv->ThrusterIndex(th[i]));
+    return (THGROUP_HANDLE)(intptr_t)(thgt + 1);
+}
+
+double VESSEL::GetThrusterLevel(THRUSTER_HANDLE th) const{
+    return hv->thrusters[hv->ThrusterIndex(th)].level;
+}
+
+double VESSEL::GetThrusterMax0(THRUSTER_HANDLE th) const{
+    return hv->thrusters[hv->ThrusterIndex(th)].maxth0;
+}
+
+void VESSEL::SetThrusterMax0(THRUSTER_HANDLE th, double maxth0) const{
+    hv->thrusters[hv->ThrusterIndex(th)].maxth0 = maxth0;
+    hv->stats.set_thruster++;
+}
+
+double VESSEL::GetThrusterIsp0(THRUSTER_HANDLE th) const{
+    return hv->thrusters[hv->ThrusterIndex(th)].isp0;
+}
+
+void VESSEL::SetThrusterIsp(THRUSTER_HANDLE th, double isp) const{
+    hv->thrusters[hv->ThrusterIndex(th)].isp0 = isp;
+    hv->stats.set_thruster++;
+}
+
+double VESSEL::GetThrusterGroupLevel(THGROUP_TYPE thgt) const{
+    const std::vector<int> &grp = hv->thgroups[thgt];
+    double lvl = 0.0;
+    for(int i : grp) lvl += hv->thrusters[i].level;
+    return grp.empty() ? 0.0 : lvl / grp.size();
+}
+
+void VESSEL::SetThrusterGroupLevel(THGROUP_TYPE thgt, double level) const{
+    for(int i : hv->thgroups[thgt]) hv->thrusters[i].level = level;
+}
+
+UINT VESSEL::AddExhaust(THRUSTER_HANDLE th, double lscale, double wscale, const VECTOR3 &pos,
+    const VECTOR3 &dir, SURFHANDLE tex) const{
+    return 0;
+}
+
+PSTREAM_HANDLE VESSEL::AddParticleStream(PARTICLESTREAMSPEC *pss, const VECTOR3 &pos, const VECTOR3 &dir, double *lvl) const{
+    hv->particle_levels.push_back(lvl);
+    return (PSTREAM_HANDLE)(intptr_t)hv->particle_levels.size();
+}
+
+AIRFOILHANDLE VESSEL::CreateAirfoil3(AIRFOIL_ORIENTATION align, const VECTOR3 &ref, AirfoilCoeffFuncEx cf,
+    void *context, double c, double S, double A) const{
+    HeadlessAirfoil af = {align, ref, cf, context, c, S, A};
+    hv->airfoils.push_back(af);
+    return (AIRFOILHANDLE)(intptr_t)hv->airfoils.size();
+}
+
+CTRLSURFHANDLE VESSEL::CreateControlSurface3(AIRCTRL_TYPE type, double area, double dCl, const VECTOR3 &ref,
+    int axis, double delay, UINT anim) const{
+    HeadlessCtrlSurface cs;
+    cs.type = type;
+    cs.area = area;
+    cs.dCl = dCl;
+    cs.ref = ref;
+    cs.axis = axis;
+    cs.anim = anim;
+    hv->ctrlsurfs.push_back(cs);
+    return (CTRLSURFHANDLE)(intptr_t)hv->ctrlsurfs.size();
+}
+
+double VESSEL::GetControlSurfaceLevel(AIRCTRL_TYPE type) const{
+    for(const HeadlessCtrlSurface &cs : hv->ctrlsurfs)
+        if(cs.type == type) return cs.level;
+    return 0.0;
+}
+
+void VESSEL::SetControlSurfaceLevel(AIRCTRL_TYPE type, double level) const{
+    for(HeadlessCtrlSurface &cs : hv->ctrlsurfs)
+        if(cs.type == type) cs.level = level;
+}
+
+double VESSEL::GetMachNumber() const {return hv->mach;}
+double VESSEL::GetAltitude() const {return hv->alt;}
+double VESSEL::GetAirspeed() const {return hv->airspeed;}
+double VESSEL::GetDynPressure() const {return hv->dynp;}
+double VESSEL::GetAtmDensity() const {return hv->rho;}
+double VESSEL::GetAtmPressure() const {return hv->pressure;}
+double VESSEL::GetAOA() const {return hv->aoa;}
+double VESSEL::GetSlipAngle() const {return hv->beta;}
+double VESSEL::GetPitch() const {return hv->gamma + hv->aoa;}
+double VESSEL::GetBank() const {return 0.0;}
+double VESSEL::GetMass() const {return hv->Mass();}
+
+//Global frame: x downrange, y up, z across track.
+void VESSEL::GetGlobalPos(VECTOR3 &pos) const{
+    pos = _V(hv->x, hv->alt, 0.0);
+}
+
+UINT VESSEL::AddMesh(MESHHANDLE hMesh, const VECTOR3 *ofs) const{
+    hv->meshes.push_back((const HeadlessMesh *)hMesh);
+    hv->mesh_vis.push_back(MESHVIS_EXTERNAL);
+    return (UINT)hv->meshes.size() - 1;
+}
+
+void VESSEL::SetMeshVisibilityMode(UINT idx, WORD mode) const{
+    hv->stats.set_meshvis++;
+    if(idx < hv->mesh_vis.size()) hv->mesh_vis[idx] = mode;
+}
+
+DEVMESHHANDLE VESSEL::GetDevMesh(VISHANDLE vis, UINT idx) const{
+    HeadlessVessel *v = (HeadlessVessel *)vis;
+    if(!v || idx >= v->visual.size()) return DEVMESHHANDLE();
+    return DEVMESHHANDLE((MESHHANDLE)&v->visual[idx]);
+}
+
+UINT VESSEL::AddMesh(const char *meshname, const VECTOR3 *ofs) const{
+    return AddMesh(oapiLoadMeshGlobal(meshname), ofs);
+}
+
+UINT VESSEL::CreateAnimation(double initial_state) const{
+    HeadlessAnimation anim;
+    anim.state = initial_state;
+    hv->anims.push_back(anim);
+    return (UINT)hv->anims.size() - 1;
+}
+
+ANIMATIONCOMPONENT_HANDLE VESSEL::AddAnimationComponent(UINT anim, double state0, double state1,
+    MGROUP_TRANSFORM *trans, ANIMATIONCOMPONENT_HANDLE parent) const{
+    HeadlessAnimComponent comp = {state0, state1, trans};
+    hv->anims[anim].comps.push_back(comp);
+    return (ANIMATIONCOMPONENT_HANDLE)trans;
+}
+
+bool VESSEL::SetAnimation(UINT anim, double state) const{
+    hv->stats.set_animation++;
+    if(anim >= hv->anims.size()) return false;
+    hv->anims[anim].state = state;
+    return true;
+}
+
+void VESSEL::SaveDefaultState(FILEHANDLE scn) const{
+    HeadlessFile *f = (HeadlessFile *)scn;
+    char cbuf[256];
+    sprintf(cbuf, "%s Earth", hv->alt > 0.0 ? "Orbiting" : "Landed");
+    oapiWriteScenario_string(scn, "STATUS", cbuf);
+    sprintf(cbuf, "%0.3f", hv->alt);
+    oapiWriteScenario_string(scn, "ALT", cbuf);
+    std::string prp = "";
+    for(size_t i = 0; i < hv->propellants.size(); i++){
+        sprintf(cbuf, "%s%d:%0.6f", i ? " " : "", (int)i,
+            hv->propellants[i].maxmass > 0.0 ? hv->propellants[i].mass / hv->propellants[i].maxmass : 0.0);
+        prp += cbuf;
+    }
+    if(!prp.empty()) oapiWriteScenario_string(scn, "PRPLEVEL", prp.c_str());
+    for(const std::string &l : hv->default_state)
+        if(l.compare(0, 6, "STATUS") && l.compare(0, 3, "ALT") && l.compare(0, 8, "PRPLEVEL"))
+            oapiWriteLine(f, ("  " + l).c_str());
+}
+
+void VESSEL::ParseScenarioLineEx(char *line, void *status) const{
+    if(!strncasecmp(line, "ALT", 3)){
+        hv->alt = atof(line + 3);
+    } else if(!strncasecmp(line, "PRPLEVEL", 8)){
+        const char *s = line + 8;
+        char *e;
+        for(;;){
+            long i = strtol(s, &e, 10);
+            if(e == s || *e != ':') break;
+            double lvl = strtod(e + 1, &e);
+            if(i >= 0 && i < (long)hv->propellants.size())
+                hv->propellants[i].mass = lvl * hv->propellants[i].maxmass;
+            s = e;
+        }
+    }
+    hv->default_state.push_back(line);
+}
+
+///////////////HeadlessSim
+
+HeadlessSim::HeadlessSim(const char *root){
+    //Orbiter runs modules from its installation directory; the module opens
+    //Config/... paths relative to it.
+    if(root && chdir(root))
+        fprintf(stderr, "headless: cannot change to %s\n", root);
+    g_simt = 0.0;
+    g_simdt = 0.0;
+    InitModule(0);
+}
+
+HeadlessSim::~HeadlessSim(){
+    while(!vessels.empty()) DeleteVessel(vessels.back());
+    ExitModule(0);
+    for(auto &m : g_global_meshes) delete m.second;
+    g_global_meshes.clear();
+}
+
+std::string HeadlessSim::ResolvePath(const char *subdir, const char *name, const char *ext){
+    std::string path = std::string(subdir) + "/" + name;
+    size_t n = strlen(ext);
+    if(path.size() < n || path.compare(path.size() - n, n, ext)) path += ext;
+    return path;
+}
+
+VESSEL *HeadlessSim::CreateVessel(const char *name, const char *classname, const char *scnpath){
+    HeadlessVessel *hv = new HeadlessVessel(name, classname);
+    if(!g_camera_target) g_camera_target = hv;
+    VESSEL *v = ovcInit((OBJHANDLE)hv, 1);
+    VESSEL2 *v2 = (VESSEL2 *)v;
+
+    HeadlessFile *cfg = new HeadlessFile;
+    std::string cfgpath = ResolvePath("Config/Vessels", classname, ".cfg");
+    std::ifstream f(cfgpath.c_str());
+    std::string line;
+    while(std::getline(f, line)) cfg->lines.push_back(line);
+    v2->clbkSetClassCaps((FILEHANDLE)cfg);
+    delete cfg;
+
+    if(scnpath){
+        HeadlessFile *scn = HeadlessFile::OpenScenarioShip(scnpath, name);
+        if(scn){
+            scn->stats = &hv->stats;
+            v2->clbkLoadStateEx((FILEHANDLE)scn, 0);
+            delete scn;
+        } else {
+            fprintf(stderr, "headless: cannot open scenario %s\n", scnpath);
+        }
+    }
+
+    //Catch animation components that refer to groups the mesh does not have.
+    for(size_t a = 0; a < hv->anims.size(); a++){
+        for(const HeadlessAnimComponent &c : hv->anims[a].comps){
+            if(c.trans->mesh >= hv->meshes.size() || !hv->meshes[c.trans->mesh]) continue;
+            size_t ngrp = hv->meshes[c.trans->mesh]->groups.size();
+            for(UINT i = 0; i < c.trans->ngrp; i++)
+                if(c.trans->grp[i] >= ngrp)
+                    fprintf(stderr, "headless: animation %d references group %u, mesh has %d groups\n",
+                        (int)a, c.trans->grp[i], (int)ngrp);
+        }
+    }
+
+    //The visual: each mesh instance starts with its template's textures.
+    for(const HeadlessMesh *m : hv->meshes){
+        HeadlessDevMesh dm = {m, m ? m->surfaces : std::vector<SURFHANDLE>(), &hv->stats};
+        hv->visual.push_back(dm);
+    }
+    v2->clbkVisualCreated((VISHANDLE)hv, 1);
+
+    vessels.push_back(v);
+    return v;
+}
+
+void HeadlessSim::DeleteVessel(VESSEL *v){
+    HeadlessVessel *hv = v->Headless();
+    vessels.erase(std::remove(vessels.begin(), vessels.end(), v), vessels.end());
+    ((VESSEL2 *)v)->clbkVisualDestroyed((VISHANDLE)hv, 1);
+    hv->visual.clear();
+    ovcExit(v);
+    if(g_camera_target == hv){
+        g_camera_target = vessels.empty() ? 0 : vessels[0]->Headless();
+        g_camera_dist = 0.0;
+    }
+    delete hv;
+}
+
+void HeadlessSim::SetCamera(VESSEL *target, double dist){
+    g_camera_target = target ? target->Headless() : 0;
+    g_camera_dist = dist;
+}
+
+void HeadlessSim::SetFlightState(VESSEL *v, double alt, double airspeed, double gamma, double aoa){
+    HeadlessVessel *hv = v->Headless();
+    hv->alt = alt;
+    hv->airspeed = airspeed;
+    hv->gamma = gamma;
+    hv->aoa = aoa;
+}
+
+void HeadlessSim::SetThrottle(VESSEL *v, double level){
+    v->SetThrusterGroupLevel(THGROUP_MAIN, level);
+}
+
+double HeadlessSim::SimT() const{
+    return g_simt;
+}
+
+int HeadlessSim::TextureCount(){
+    return g_texture_count;
+}
+
+size_t HeadlessSim::TextureBytes(){
+    return g_texture_bytes;
+}
+
+bool HeadlessSim::PressKey(VESSEL *v, int key){
+    char kstate[256] = {0};
+    return ((VESSEL2 *)v)->clbkConsumeBufferedKey(key, true, kstate) != 0;
+}
+
+std::string HeadlessSim::SaveState(VESSEL *v){
+    HeadlessFile *f = HeadlessFile::ForWriting();
+    f->stats = &v->Headless()->stats;
+    ((VESSEL2 *)v)->clbkSaveState((FILEHANDLE)f);
+    std::string out = f->out;
+    delete f;
+    return out;
+}
+
+void HeadlessSim::LoadState(VESSEL *v, const std::string &text){
+    HeadlessFile *f = HeadlessFile::FromText(text);
+    f->stats = &v->Headless()->stats;
+    v->Headless()->default_state.clear();
+    ((VESSEL2 *)v)->clbkLoadStateEx((FILEHANDLE)f, 0);
+    delete f;
+}
+
+//Point-mass step in the vertical plane: aerodynamic forces come from the
+//module's airfoil callbacks, thrust from the main thruster group.
+static void IntegrateVessel(HeadlessVessel *hv, double dt){
+    double T;
+    HeadlessAtmosphere(hv->alt, hv->rho, hv->pressure, T);
+    hv->sound_speed = sqrt(1.4 * 287.053 * T);
+    double V = hv->airspeed;
+    hv->mach = V / hv->sound_speed;
+    hv->dynp = 0.5 * hv->rho * V * V;
+    double mu = 1.458e-6 * T * sqrt(T) / (T + 110.4);
+
+    double lift = 0.0, drag = 0.0;
+    for(const HeadlessAirfoil &af : hv->airfoils){
+        double cl, cm, cd;
+        double Re = hv->rho * V * af.c / mu;
+        double angle = (af.align == LIFT_VERTICAL) ? hv->aoa : hv->beta;
+        af.cf(hv->vessel, angle, hv->mach, Re, af.context, &cl, &cm, &cd);
+        hv->stats.airfoil_calls++;
+        if(af.align == LIFT_VERTICAL) lift += hv->dynp * af.S * cl;
+        drag += hv->dynp * af.S * cd;
+    }
+
+    double thrust = 0.0;
+    for(HeadlessThruster &th : hv->thrusters){
+        if(th.level <= 0.0) continue;
+        if(th.prop >= 0){
+            HeadlessPropellant &p = hv->propellants[th.prop];
+            if(p.mass <= 0.0) continue;
+            double f = th.level * th.maxth0;
+            if(th.isp0 > 0.0) p.mass = std::max(0.0, p.mass - f / th.isp0 * dt);
+            thrust += f * th.dir.z;
+        }
+    }
+
+    double m = hv->Mass();
+    double r = EARTH_RADIUS + hv->alt;
+    double g = EARTH_G0 * (EARTH_RADIUS / r) * (EARTH_RADIUS / r);
+    double ca = cos(hv->aoa), sa = sin(hv->aoa);
+    double cg = cos(hv->gamma), sg = sin(hv->gamma);
+
+    double at = (thrust * ca - drag) / m - g * sg;
+    double an = (lift + thrust * sa) / m - (g - V * V / r) * cg;
+
+    bool onground = (hv->alt <= 0.0);
+    if(onground){
+        //Ground roll: the runway carries the weight until lift exceeds it.
+        at = (thrust - drag) / m - 0.02 * g;
+        if(an < 0.0) an = 0.0;
+        if(hv->gamma < 0.0) hv->gamma = 0.0;
+    }
+
+    hv->airspeed = std::max(0.0, V + at * dt);
+    if(hv->airspeed > 1.0) hv->gamma += an / hv->airspeed * dt;
+    hv->gamma = std::max(-PI05, std::min(PI05, hv->gamma));
+    hv->x += V * cos(hv->gamma) * dt;
+    hv->alt += V * sin(hv->gamma) * dt;
+    if(hv->alt < 0.0){
+        hv->alt = 0.0;
+        if(hv->gamma < 0.0) hv->gamma = 0.0;
+    }
+}
+
+double HeadlessTrimAoA(VESSEL *v, double gamma_cmd, double tau){
+    HeadlessVessel *hv = v->Headless();
+    double V = std::max(hv->airspeed, 1.0);
+    double r = EARTH_RADIUS + hv->alt;
+    double g = EARTH_G0 * (EARTH_RADIUS / r) * (EARTH_RADIUS / r);
+    double T;
+    HeadlessAtmosphere(hv->alt, hv->rho, hv->pressure, T);
+    double q = 0.5 * hv->rho * V * V;
+    double mu = 1.458e-6 * T * sqrt(T) / (T + 110.4);
+    double M = V / sqrt(1.4 * 287.053 * T);
+    double lreq = hv->Mass() * ((g - V * V / r) * cos(hv->gamma) + V * (gamma_cmd - hv->gamma) / tau);
+
+    //Lift is monotonic in AoA over the bracket; bisect.
+    double lo = -10.0 * RAD, hi = 20.0 * RAD;
+    for(int it = 0; it < 40; it++){
+        double aoa = 0.5 * (lo + hi), lift = 0.0;
+        for(const HeadlessAirfoil &af : hv->airfoils){
+            if(af.align != LIFT_VERTICAL) continue;
+            double cl, cm, cd;
+            af.cf(v, aoa, M, hv->rho * V * af.c / mu, af.context, &cl, &cm, &cd);
+            lift += q * af.S * cl;
+        }
+        if(lift < lreq) lo = aoa;
+        else hi = aoa;
+    }
+    return 0.5 * (lo + hi);
+}
+
+void HeadlessSim::Step(double dt){
+    g_simdt = dt;
+    for(VESSEL *v : vessels){
+        HeadlessVessel *hv = v->Headless();
+        ((VESSEL2 *)v)->clbkPreStep(g_simt, dt, 0.0);
+        IntegrateVessel(hv, dt);
+        hv->stats.steps++;
+    }
+    g_simt += dt;
+    for(VESSEL *v : vessels)
+        ((VESSEL2 *)v)->clbkPostStep(g_simt, dt, 51982.0 + g_simt / 86400.0);
+}
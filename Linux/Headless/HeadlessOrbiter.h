@@ -0,0 +1,225 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//HeadlessOrbiter.h
+//Host side of the headless stand-in: vessel state behind the VESSEL
+//interface, scenario file handles, mesh loading and a fixed-rate point-mass
+//integrator that drives the airfoil callbacks and clbkPostStep the way
+//Orbiter does. Used to build, run and benchmark the module on plain Linux.
+//
+//==========================================
+
+#ifndef __HEADLESSORBITER_H
+#define __HEADLESSORBITER_H
+
+#include "OrbiterAPI.h"
+#include "VesselAPI.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Module entry points, defined by the vessel module linked into the host.
+DLLCLBK void InitModule(MODULEHANDLE hModule);
+DLLCLBK void ExitModule(MODULEHANDLE *hModule);
+DLLCLBK VESSEL *ovcInit(OBJHANDLE hvessel, int flightmodel);
+DLLCLBK void ovcExit(VESSEL *vessel);
+
+//Call counters for the API entry points that matter for performance work.
+struct HeadlessStats{
+    uint64_t steps = 0;
+    uint64_t airfoil_calls = 0;
+    uint64_t set_animation = 0;
+    uint64_t set_touchdown = 0;
+    uint64_t set_thruster = 0;          //SetThrusterMax0 and SetThrusterIsp calls
+    uint64_t set_meshvis = 0;
+    uint64_t set_texture = 0;           //Texture changes on the visual
+    uint64_t scenario_lines_read = 0;
+    uint64_t scenario_lines_written = 0;
+};
+
+//Parsed .msh file (Orbiter MSHX1 text format).
+struct HeadlessMeshGroup{
+    std::string label;
+    DWORD material = 0;
+    DWORD texture = 0;
+    std::vector<float> vtx;     //8 floats per vertex: x y z nx ny nz tu tv
+    std::vector<WORD> idx;
+};
+
+struct HeadlessMesh{
+    std::vector<HeadlessMeshGroup> groups;
+    std::vector<std::string> materials;
+    std::vector<std::string> textures;
+    std::vector<SURFHANDLE> surfaces;   //Set by oapiSetTexture, by texture index - 1
+    bool LoadMsh(const char *path);
+    size_t Triangles() const;
+    size_t Bytes() const;       //Heap footprint of the group, material and texture data
+};
+
+//Texture loaded by oapiLoadTexture. bytes includes the <name>_norm.dds
+//companion, which the D3D9 client loads along with the texture.
+struct HeadlessTexture{
+    std::string path;
+    size_t bytes;
+};
+
+//Mesh instance in a vessel's visual (DEVMESHHANDLE): the template plus its
+//own texture table.
+struct HeadlessDevMesh{
+    const HeadlessMesh *tmpl;
+    std::vector<SURFHANDLE> surfaces;
+    HeadlessStats *stats;
+};
+
+//Scenario or configuration file handle (FILEHANDLE).
+class HeadlessFile{
+    public:
+        //Lines of the given vessel's block in a .scn file (ship "name:class").
+        static HeadlessFile *OpenScenarioShip(const char *scnpath, const char *shipname);
+        //Lines given directly, e.g. produced by a previous save.
+        static HeadlessFile *FromText(const std::string &text);
+        //Empty handle for writing.
+        static HeadlessFile *ForWriting();
+
+        std::vector<std::string> lines;
+        size_t next = 0;
+        std::string cur;
+        std::string out;
+        HeadlessStats *stats = 0;
+};
+
+struct HeadlessAirfoil{
+    AIRFOIL_ORIENTATION align;
+    VECTOR3 ref;
+    AirfoilCoeffFuncEx cf;
+    void *context;
+    double c, S, A;
+};
+
+struct HeadlessCtrlSurface{
+    AIRCTRL_TYPE type;
+    double area, dCl;
+    VECTOR3 ref;
+    int axis;
+    UINT anim;
+    double level = 0.0;
+};
+
+struct HeadlessPropellant{
+    double maxmass;
+    double mass;
+};
+
+struct HeadlessThruster{
+    VECTOR3 pos, dir;
+    double maxth0;
+    int prop;                   //Index into propellants, -1 if none
+    double isp0;
+    double level = 0.0;
+};
+
+struct HeadlessAnimComponent{
+    double state0, state1;
+    MGROUP_TRANSFORM *trans;
+};
+
+struct HeadlessAnimation{
+    double state;
+    std::vector<HeadlessAnimComponent> comps;
+};
+
+//Vessel state behind the VESSEL interface. OBJHANDLE points at this object.
+class HeadlessVessel{
+    public:
+        HeadlessVessel(const char *name, const char *classname);
+
+        std::string name;
+        std::string classname;
+        VESSEL *vessel = 0;
+
+        //Class caps
+        double size = 1.0, empty_mass = 0.0, wheelbrake = 0.0, wing_eff = 1.0;
+        VECTOR3 cs = {0, 0, 0}, pmi = {0, 0, 0}, rotdrag = {0, 0, 0}, cg_shift = {0, 0, 0};
+        bool nosewheel_steering = false;
+        std::vector<TOUCHDOWNVTX> tdvtx;           //Copied, as the core does
+        std::vector<HeadlessPropellant> propellants;
+        std::vector<HeadlessThruster> thrusters;
+        std::vector<std::vector<int> > thgroups;   //Indexed by THGROUP_TYPE
+        std::vector<HeadlessAirfoil> airfoils;
+        std::vector<HeadlessCtrlSurface> ctrlsurfs;
+        std::vector<HeadlessAnimation> anims;
+        std::vector<const HeadlessMesh *> meshes;
+        std::vector<WORD> mesh_vis;                //Visibility mode per mesh
+        std::vector<HeadlessDevMesh> visual;       //One per mesh, once the visual exists
+        std::vector<double *> particle_levels;
+        std::vector<std::string> default_state;    //Unparsed default scenario lines
+
+        //Flight state: point mass in the vertical plane.
+        double x = 0.0;             //Downrange [m]
+        double alt = 0.0;           //Altitude [m]
+        double airspeed = 0.0;      //[m/s]
+        double gamma = 0.0;         //Flight path angle [rad]
+        double aoa = 0.0;           //Commanded angle of attack [rad]
+        double beta = 0.0;          //Commanded sideslip [rad]
+
+        //Derived once per step.
+        double rho = 0.0, pressure = 0.0, sound_speed = 340.0, mach = 0.0, dynp = 0.0;
+
+        HeadlessStats stats;
+
+        double Mass() const;
+        THRUSTER_HANDLE ThrusterHandle(int i) const {return (THRUSTER_HANDLE)(intptr_t)(i + 1);}
+        int ThrusterIndex(THRUSTER_HANDLE th) const {return (int)(intptr_t)th - 1;}
+};
+
+//Fixed-rate headless simulation of one or more vessels.
+class HeadlessSim{
+    public:
+        //root: directory holding Config/, Meshes/ and Scenarios/ (the repository
+        //root). It becomes the working directory, as Orbiter's root does.
+        explicit HeadlessSim(const char *root);
+        ~HeadlessSim();
+
+        //Creates a vessel through ovcInit and clbkSetClassCaps. If scnpath is
+        //given, the ship block named "name" is read through clbkLoadStateEx.
+        //The visual is then created from the vessel's meshes (clbkVisualCreated);
+        //DeleteVessel destroys it first.
+        VESSEL *CreateVessel(const char *name, const char *classname, const char *scnpath = 0);
+        void DeleteVessel(VESSEL *v);
+
+        void SetFlightState(VESSEL *v, double alt, double airspeed, double gamma, double aoa);
+        void SetThrottle(VESSEL *v, double level);
+
+        //Advances all vessels by one fixed step of length dt.
+        void Step(double dt);
+
+        //Places the camera dist metres behind target (0: in its cockpit). By
+        //default the camera sits in the cockpit of the first vessel created.
+        void SetCamera(VESSEL *target, double dist);
+
+        bool PressKey(VESSEL *v, int key);
+        std::string SaveState(VESSEL *v);
+        void LoadState(VESSEL *v, const std::string &text);
+
+        double SimT() const;
+        //Textures loaded and not yet released, and their size in bytes: the
+        //video memory they would take.
+        static int TextureCount();
+        static size_t TextureBytes();
+        static std::string ResolvePath(const char *subdir, const char *name, const char *ext);
+
+        std::vector<VESSEL *> vessels;
+};
+
+//Angle of attack at which the vertical airfoils give the lift needed to turn
+//the flight path towards gamma_cmd with time constant tau (simple autopilot
+//for driver programs). Evaluates the airfoil callbacks outside the counters.
+double HeadlessTrimAoA(VESSEL *v, double gamma_cmd, double tau = 5.0);
+
+//Standard atmosphere (up to 86 km): density [kg/m^3], pressure [Pa], temperature [K].
+void HeadlessAtmosphere(double alt, double &rho, double &p, double &T);
+
+#endif //!__HEADLESSORBITER_H
@@ -0,0 +1,268 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//OrbiterAPI.h
+//Minimal replacement for the Orbiter SDK header, covering only the part of
+//the API used by the XB-70 module. Types and signatures follow the SDK so
+//that Linux/XB70Valkyrie.cpp compiles unchanged against either. Put this
+//directory on the include path *only* for headless builds.
+//
+//==========================================
+
+#ifndef __ORBITERAPI_H
+#define __ORBITERAPI_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include <math.h>
+
+#define DLLCLBK extern "C"
+#define OAPIFUNC
+
+typedef unsigned int UINT;
+typedef uint32_t DWORD;
+typedef uint16_t WORD;
+
+typedef void *OBJHANDLE;
+typedef void *MESHHANDLE;
+typedef void *SURFHANDLE;
+typedef void *VISHANDLE;
+typedef void *FILEHANDLE;
+typedef void *MODULEHANDLE;
+typedef void *AIRFOILHANDLE;
+typedef void *CTRLSURFHANDLE;
+typedef void *THRUSTER_HANDLE;
+
+//Handle of a mesh instance in a vessel's visual (a class in the SDK, so that
+//the oapi functions can be overloaded on it).
+class DEVMESHHANDLE{
+    public:
+        DEVMESHHANDLE() : hMesh(0) {}
+        DEVMESHHANDLE(MESHHANDLE h) : hMesh(h) {}
+        operator MESHHANDLE() const {return hMesh;}
+        operator bool() const {return hMesh != 0;}
+    private:
+        MESHHANDLE hMesh;
+};
+typedef void *THGROUP_HANDLE;
+typedef void *PROPELLANT_HANDLE;
+typedef void *PSTREAM_HANDLE;
+typedef void *ANIMATIONCOMPONENT_HANDLE;
+
+//Constants
+
+const double PI    = 3.14159265358979323846;
+const double PI05  = 1.57079632679489661923;
+const double PI2   = 6.28318530717958647693;
+const double RAD   = PI/180.0;
+const double DEG   = 180.0/PI;
+const double G     = 6.67259e-11;
+const double AU    = 1.49597870691e11;
+const double ATMP  = 101.4e3;
+const double ATMD  = 1.293;
+
+//Vectors
+
+typedef union {
+    double data[3];
+    struct {double x, y, z;};
+} VECTOR3;
+
+inline VECTOR3 _V(double x, double y, double z){
+    VECTOR3 v = {x, y, z};
+    return v;
+}
+
+inline VECTOR3 operator+ (const VECTOR3 &a, const VECTOR3 &b){return _V(a.x + b.x, a.y + b.y, a.z + b.z);}
+inline VECTOR3 operator- (const VECTOR3 &a, const VECTOR3 &b){return _V(a.x - b.x, a.y - b.y, a.z - b.z);}
+inline VECTOR3 operator* (const VECTOR3 &a, double f){return _V(a.x * f, a.y * f, a.z * f);}
+inline VECTOR3 operator/ (const VECTOR3 &a, double f){return _V(a.x / f, a.y / f, a.z / f);}
+inline double dotp(const VECTOR3 &a, const VECTOR3 &b){return a.x * b.x + a.y * b.y + a.z * b.z;}
+inline double length(const VECTOR3 &a){return sqrt(dotp(a, a));}
+
+//Vessel definition structures
+
+typedef struct {
+    VECTOR3 pos;
+    double stiffness;
+    double damping;
+    double mu;
+    double mu_lng;
+} TOUCHDOWNVTX;
+
+typedef struct {
+    DWORD flags;
+    double srcsize;
+    double srcrate;
+    double v0;
+    double srcspread;
+    double lifetime;
+    double growthrate;
+    double atmslowdown;
+    enum LTYPE {EMISSIVE, DIFFUSE} ltype;
+    enum LEVELMAP {LVL_FLAT, LVL_LIN, LVL_SQRT, LVL_PLIN, LVL_PSQRT} levelmap;
+    double lmin, lmax;
+    enum ATMSMAP {ATM_FLAT, ATM_PLIN, ATM_PLOG} atmsmap;
+    double amin, amax;
+    SURFHANDLE tex;
+} PARTICLESTREAMSPEC;
+
+//Mesh structures
+
+typedef struct {
+    float x, y, z;
+    float nx, ny, nz;
+    float tu, tv;
+} NTVERTEX;
+
+typedef struct {
+    float r, g, b, a;
+} COLOUR4;
+
+typedef struct {
+    COLOUR4 diffuse;
+    COLOUR4 ambient;
+    COLOUR4 specular;
+    COLOUR4 emissive;
+    float power;
+} MATERIAL;
+
+typedef struct {
+    NTVERTEX *Vtx;
+    WORD *Idx;
+    DWORD nVtx;
+    DWORD nIdx;
+    DWORD MtrlIdx;      //Material index (>= 1, 0 = none)
+    DWORD TexIdx;       //Texture index (>= 1, 0 = none)
+    DWORD UsrFlag;
+    WORD zBias;
+    WORD Flags;
+} MESHGROUP;
+
+//Mesh visibility modes (VESSEL::SetMeshVisibilityMode)
+const WORD MESHVIS_NEVER    = 0x00;
+const WORD MESHVIS_EXTERNAL = 0x01;
+const WORD MESHVIS_COCKPIT  = 0x02;
+const WORD MESHVIS_ALWAYS   = MESHVIS_EXTERNAL | MESHVIS_COCKPIT;
+const WORD MESHVIS_VC       = 0x04;
+
+enum AIRFOIL_ORIENTATION {LIFT_VERTICAL, LIFT_HORIZONTAL};
+
+enum AIRCTRL_TYPE {
+    AIRCTRL_ELEVATOR, AIRCTRL_RUDDER, AIRCTRL_AILERON, AIRCTRL_FLAP,
+    AIRCTRL_ELEVATORTRIM, AIRCTRL_RUDDERTRIM
+};
+
+const int AIRCTRL_AXIS_AUTO = 0;
+const int AIRCTRL_AXIS_YPOS = 1;
+const int AIRCTRL_AXIS_YNEG = 2;
+const int AIRCTRL_AXIS_XPOS = 3;
+const int AIRCTRL_AXIS_XNEG = 4;
+
+enum THGROUP_TYPE {
+    THGROUP_MAIN, THGROUP_RETRO, THGROUP_HOVER,
+    THGROUP_ATT_PITCHUP, THGROUP_ATT_PITCHDOWN, THGROUP_ATT_YAWLEFT, THGROUP_ATT_YAWRIGHT,
+    THGROUP_ATT_BANKLEFT, THGROUP_ATT_BANKRIGHT, THGROUP_ATT_RIGHT, THGROUP_ATT_LEFT,
+    THGROUP_ATT_UP, THGROUP_ATT_DOWN, THGROUP_ATT_FORWARD, THGROUP_ATT_BACK,
+    THGROUP_USER = 0x40
+};
+
+typedef void (*AirfoilCoeffFuncEx)(class VESSEL *v, double aoa, double M, double Re,
+    void *context, double *cl, double *cm, double *cd);
+
+//Animation transforms
+
+class MGROUP_TRANSFORM{
+    public:
+        enum TYPE {NULLTRANSFORM, ROTATE, TRANSLATE, SCALE};
+        MGROUP_TRANSFORM() : mesh(0), grp(0), ngrp(0) {}
+        MGROUP_TRANSFORM(UINT _mesh, UINT *_grp, UINT _ngrp) : mesh(_mesh), grp(_grp), ngrp(_ngrp) {}
+        virtual ~MGROUP_TRANSFORM() {}
+        virtual TYPE Type() const {return NULLTRANSFORM;}
+        UINT mesh;
+        UINT *grp;
+        UINT ngrp;
+};
+
+class MGROUP_ROTATE: public MGROUP_TRANSFORM{
+    public:
+        MGROUP_ROTATE(UINT _mesh, UINT *_grp, UINT _ngrp, const VECTOR3 &_ref, const VECTOR3 &_axis, float _angle) :
+            MGROUP_TRANSFORM(_mesh, _grp, _ngrp), ref(_ref), axis(_axis), angle(_angle) {}
+        TYPE Type() const override {return ROTATE;}
+        VECTOR3 ref;
+        VECTOR3 axis;
+        float angle;
+};
+
+class MGROUP_TRANSLATE: public MGROUP_TRANSFORM{
+    public:
+        MGROUP_TRANSLATE(UINT _mesh, UINT *_grp, UINT _ngrp, const VECTOR3 &_shift) :
+            MGROUP_TRANSFORM(_mesh, _grp, _ngrp), shift(_shift) {}
+        TYPE Type() const override {return TRANSLATE;}
+        VECTOR3 shift;
+};
+
+//Keyboard codes used by the module (DirectInput scan codes, as in the SDK)
+
+const int OAPI_KEY_G = 0x22;
+const int OAPI_KEY_K = 0x25;
+const int OAPI_KEY_W = 0x11;
+const int OAPI_KEY_C = 0x2E;
+const int OAPI_KEY_R = 0x13;
+const int OAPI_KEY_P = 0x19;
+
+//Mesh and texture management
+
+OAPIFUNC MESHHANDLE oapiLoadMesh(const char *fname);
+OAPIFUNC MESHHANDLE oapiLoadMeshGlobal(const char *fname);
+OAPIFUNC void oapiDeleteMesh(MESHHANDLE hMesh);
+OAPIFUNC DWORD oapiMeshGroupCount(MESHHANDLE hMesh);
+OAPIFUNC MESHHANDLE oapiCreateMesh(DWORD ngrp, MESHGROUP *grp);
+OAPIFUNC int oapiAddMaterial(MESHHANDLE hMesh, MATERIAL *mtrl);
+OAPIFUNC SURFHANDLE oapiLoadTexture(const char *fname, bool dynamic = false);
+OAPIFUNC bool oapiSetTexture(MESHHANDLE hMesh, DWORD texidx, SURFHANDLE tex);
+OAPIFUNC bool oapiSetTexture(DEVMESHHANDLE hMesh, DWORD texidx, SURFHANDLE tex);
+OAPIFUNC void oapiReleaseTexture(SURFHANDLE hTex);
+OAPIFUNC SURFHANDLE oapiRegisterExhaustTexture(const char *name);
+
+//Aerodynamics helpers
+
+OAPIFUNC double oapiGetInducedDrag(double cl, double A, double e);
+OAPIFUNC double oapiGetWaveDrag(double M, double M1, double M2, double M3, double cmax);
+
+//Configuration and scenario files
+
+OAPIFUNC bool oapiReadItem_bool(FILEHANDLE f, const char *item, bool &val);
+OAPIFUNC bool oapiReadItem_float(FILEHANDLE f, const char *item, double &val);
+OAPIFUNC bool oapiReadItem_vec(FILEHANDLE f, const char *item, VECTOR3 &val);
+OAPIFUNC bool oapiReadItem_int(FILEHANDLE f, const char *item, int &val);
+OAPIFUNC bool oapiReadItem_string(FILEHANDLE f, const char *item, char *string);
+
+OAPIFUNC bool oapiReadScenario_nextline(FILEHANDLE scn, char *&line);
+OAPIFUNC void oapiWriteLine(FILEHANDLE file, const char *line);
+OAPIFUNC void oapiWriteScenario_string(FILEHANDLE scn, const char *item, const char *string);
+OAPIFUNC void oapiWriteScenario_int(FILEHANDLE scn, const char *item, int i);
+OAPIFUNC void oapiWriteScenario_float(FILEHANDLE scn, const char *item, double d);
+OAPIFUNC void oapiWriteScenario_vec(FILEHANDLE scn, const char *item, const VECTOR3 &vec);
+
+//Camera and viewport
+
+OAPIFUNC void oapiCameraGlobalPos(VECTOR3 *gpos);
+OAPIFUNC double oapiCameraAperture(void);
+OAPIFUNC void oapiGetViewportSize(DWORD *w, DWORD *h, DWORD *bpp = 0);
+
+//Simulation state
+
+OAPIFUNC double oapiGetSimTime(void);
+OAPIFUNC double oapiGetSimStep(void);
+OAPIFUNC char *oapiDebugString(void);
+OAPIFUNC void oapiWriteLog(const char *line);
+OAPIFUNC void oapiWriteLogV(const char *format, ...);
+
+#endif //!__ORBITERAPI_H
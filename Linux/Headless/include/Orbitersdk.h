@@ -0,0 +1,18 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//Orbitersdk.h
+//Umbrella header, as in the Orbiter SDK.
+//
+//==========================================
+
+#ifndef __ORBITERSDK_H
+#define __ORBITERSDK_H
+
+#include "OrbiterAPI.h"
+#include "VesselAPI.h"
+
+#endif //!__ORBITERSDK_H
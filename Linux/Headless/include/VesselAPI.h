@@ -0,0 +1,129 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//VesselAPI.h
+//VESSEL/VESSEL2/VESSEL3/VESSEL4 interface, restricted to the members used by
+//the XB-70 module. The member functions are implemented in
+//HeadlessOrbiter.cpp on top of the headless vessel state.
+//
+//==========================================
+
+#ifndef __VESSELAPI_H
+#define __VESSELAPI_H
+
+#include "OrbiterAPI.h"
+
+class HeadlessVessel;
+
+class VESSEL{
+    public:
+        VESSEL(OBJHANDLE hVessel, int fmodel = 1);
+        virtual ~VESSEL();
+
+        OBJHANDLE GetHandle() const {return hObj;}
+        const char *GetName() const;
+        const char *GetClassName() const;
+
+        //Physical parameters
+        void SetSize(double size) const;
+        void SetEmptyMass(double m) const;
+        void SetCrossSections(const VECTOR3 &cs) const;
+        void SetPMI(const VECTOR3 &pmi) const;
+        void SetMaxWheelbrakeForce(double f) const;
+        void ShiftCentreOfMass(const VECTOR3 &shift);
+        void ShiftCG(const VECTOR3 &shift);
+        void SetWingEffectiveness(double eff) const;
+        void SetRotDrag(const VECTOR3 &rd) const;
+        void SetNosewheelSteering(bool activate) const;
+        void SetTouchdownPoints(const TOUCHDOWNVTX *tdvtx, DWORD ntdvtx) const;
+
+        //Propellant and thrusters
+        PROPELLANT_HANDLE CreatePropellantResource(double maxmass, double mass = -1.0, double efficiency = 1.0) const;
+        double GetPropellantMass(PROPELLANT_HANDLE ph) const;
+        double GetPropellantMaxMass(PROPELLANT_HANDLE ph) const;
+        double GetFuelMass() const;     //Default (first) propellant resource
+        THRUSTER_HANDLE CreateThruster(const VECTOR3 &pos, const VECTOR3 &dir, double maxth0,
+            PROPELLANT_HANDLE hp = 0, double isp0 = 0.0, double isp_ref = 0.0, double p_ref = 101.4e3) const;
+        THGROUP_HANDLE CreateThrusterGroup(THRUSTER_HANDLE *th, int nth, THGROUP_TYPE thgt) const;
+        double GetThrusterLevel(THRUSTER_HANDLE th) const;
+        double GetThrusterMax0(THRUSTER_HANDLE th) const;
+        void SetThrusterMax0(THRUSTER_HANDLE th, double maxth0) const;
+        double GetThrusterIsp0(THRUSTER_HANDLE th) const;
+        void SetThrusterIsp(THRUSTER_HANDLE th, double isp) const;
+        double GetThrusterGroupLevel(THGROUP_TYPE thgt) const;
+        void SetThrusterGroupLevel(THGROUP_TYPE thgt, double level) const;
+        UINT AddExhaust(THRUSTER_HANDLE th, double lscale, double wscale, const VECTOR3 &pos,
+            const VECTOR3 &dir, SURFHANDLE tex = 0) const;
+        PSTREAM_HANDLE AddParticleStream(PARTICLESTREAMSPEC *pss, const VECTOR3 &pos, const VECTOR3 &dir, double *lvl) const;
+
+        //Aerodynamics
+        AIRFOILHANDLE CreateAirfoil3(AIRFOIL_ORIENTATION align, const VECTOR3 &ref, AirfoilCoeffFuncEx cf,
+            void *context, double c, double S, double A) const;
+        CTRLSURFHANDLE CreateControlSurface3(AIRCTRL_TYPE type, double area, double dCl, const VECTOR3 &ref,
+            int axis = AIRCTRL_AXIS_AUTO, double delay = 1.0, UINT anim = (UINT)-1) const;
+        double GetControlSurfaceLevel(AIRCTRL_TYPE type) const;
+        void SetControlSurfaceLevel(AIRCTRL_TYPE type, double level) const;
+
+        //Flight state
+        double GetMachNumber() const;
+        double GetAltitude() const;
+        double GetAirspeed() const;
+        double GetDynPressure() const;
+        double GetAtmDensity() const;
+        double GetAtmPressure() const;
+        double GetAOA() const;
+        double GetSlipAngle() const;
+        double GetPitch() const;
+        double GetBank() const;         //Always 0: the model flies in the vertical plane
+        double GetMass() const;
+        void GetGlobalPos(VECTOR3 &pos) const;
+
+        //Visuals and animations
+        UINT AddMesh(MESHHANDLE hMesh, const VECTOR3 *ofs = 0) const;
+        UINT AddMesh(const char *meshname, const VECTOR3 *ofs = 0) const;
+        void SetMeshVisibilityMode(UINT idx, WORD mode) const;
+        DEVMESHHANDLE GetDevMesh(VISHANDLE vis, UINT idx) const;
+        UINT CreateAnimation(double initial_state) const;
+        ANIMATIONCOMPONENT_HANDLE AddAnimationComponent(UINT anim, double state0, double state1,
+            MGROUP_TRANSFORM *trans, ANIMATIONCOMPONENT_HANDLE parent = 0) const;
+        bool SetAnimation(UINT anim, double state) const;
+
+        //Scenario state
+        void SaveDefaultState(FILEHANDLE scn) const;
+        void ParseScenarioLineEx(char *line, void *status) const;
+
+        //Headless vessel state behind this interface (stand-in only).
+        HeadlessVessel *Headless() const {return hv;}
+
+    private:
+        OBJHANDLE hObj;
+        HeadlessVessel *hv;
+};
+
+class VESSEL2: public VESSEL{
+    public:
+        VESSEL2(OBJHANDLE hVessel, int fmodel = 1) : VESSEL(hVessel, fmodel) {}
+        virtual void clbkSetClassCaps(FILEHANDLE cfg) {}
+        virtual void clbkLoadStateEx(FILEHANDLE scn, void *status) {}
+        virtual void clbkSaveState(FILEHANDLE scn) {SaveDefaultState(scn);}
+        virtual void clbkPreStep(double simt, double simdt, double mjd) {}
+        virtual void clbkPostStep(double simt, double simdt, double mjd) {}
+        virtual void clbkVisualCreated(VISHANDLE vis, int refcount) {}
+        virtual void clbkVisualDestroyed(VISHANDLE vis, int refcount) {}
+        virtual int clbkConsumeBufferedKey(int key, bool down, char *kstate) {return 0;}
+};
+
+class VESSEL3: public VESSEL2{
+    public:
+        VESSEL3(OBJHANDLE hVessel, int fmodel = 1) : VESSEL2(hVessel, fmodel) {}
+};
+
+class VESSEL4: public VESSEL3{
+    public:
+        VESSEL4(OBJHANDLE hVessel, int fmodel = 1) : VESSEL3(hVessel, fmodel) {}
+};
+
+#endif //!__VESSELAPI_H
@@ -0,0 +1,491 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//xb70_bench.cpp
+//Micro-benchmarks for the module's hot paths, run against the headless
+//stand-in. Results are written as one JSON document (ns per call, best of
+//several repetitions) so runs can be diffed between releases.
+//
+//Usage: xb70_bench [root] [output.json]
+//
+//==========================================
+
+#include "HeadlessOrbiter.h"
+#include "XB70Valkyrie.h"
+#include "XB70AeroDatabase.h"
+#include "XB70DragTerms.h"
+#include "XB70MeshCache.h"
+#include "XB70Replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+static const int REPETITIONS = 7;
+
+struct BenchResult{
+    std::string name;
+    double ns_per_op;
+    long long ops;
+};
+
+static std::vector<BenchResult> results;
+static volatile double sink;
+
+//Largest deviation of a fast path from its reference.
+struct AccuracyResult{
+    std::string name;
+    double max_error;
+};
+
+static std::vector<AccuracyResult> accuracy;
+
+static void Accuracy(const std::string &name, double max_error){
+    accuracy.push_back({name, max_error});
+    fprintf(stderr, "%-44s %10.3g max error\n", name.c_str(), max_error);
+}
+
+//AeroTable::Eval against the breakpoint scan over [xmin, xmax].
+template<int NCH>
+static double TableError(const AeroTable<NCH> &t, double xmin, double xmax){
+    const int n = 100001;
+    double err = 0.0;
+    for(int i = 0; i < n; i++){
+        double x = xmin + (xmax - xmin) * i / (n - 1), a[NCH], b[NCH];
+        t.Eval(x, a);
+        t.EvalExact(x, b);
+        for(int k = 0; k < NCH; k++) err = std::max(err, std::fabs(a[k] - b[k]));
+    }
+    return err;
+}
+
+//Relative deviation of a from the reference b.
+static double RelError(double a, double b){
+    return a == b ? 0.0 : std::fabs(a - b) / std::max(std::fabs(a), std::fabs(b));
+}
+
+//Reference values of oapiGetInducedDrag(cl, A, e) and oapiGetWaveDrag(M,
+//0.75, 1.0, 1.1, 0.04), the expressions of Orbiter's OrbiterAPI.cpp
+//evaluated in 60-digit decimal arithmetic for the exact double arguments
+//and rounded once, to 17 digits. They do not go through the headless
+//stand-ins, which share the local closed forms' arithmetic.
+struct InducedDragRef{
+    double cl, A, e;
+    double cd;
+};
+static const InducedDragRef induced_ref[] = {
+    {-1.5, 1.751, 0.7, 0.58431691597742441},
+    {-0.8, 1.751, 0.7, 0.16620570054468964},
+    {-0.3, 1.751, 0.7, 0.023372676639096975},
+    {-0.05, 1.751, 0.7, 0.0006492410177526939},
+    {0.02, 1.751, 0.7, 0.00010387856284043101},
+    {0.1, 1.751, 0.7, 0.0025969640710107756},
+    {0.25, 1.751, 0.7, 0.016231025443817344},
+    {0.5, 1.751, 0.7, 0.064924101775269374},
+    {1.0, 1.751, 0.7, 0.2596964071010775},
+    {1.8, 1.751, 0.7, 0.84141635900749123},
+    {-1.5, 1, 0.6, 1.1936620731892151},
+    {-0.8, 1, 0.6, 0.33953054526271009},
+    {-0.3, 1, 0.6, 0.047746482927568598},
+    {-0.05, 1, 0.6, 0.0013262911924324613},
+    {0.02, 1, 0.6, 0.00021220659078919379},
+    {0.1, 1, 0.6, 0.0053051647697298452},
+    {0.25, 1, 0.6, 0.033157279810811527},
+    {0.5, 1, 0.6, 0.13262911924324611},
+    {1.0, 1, 0.6, 0.53051647697298443},
+    {1.8, 1, 0.6, 1.7188733853924698},
+};
+
+struct WaveDragRef{
+    double M;
+    double cd;
+};
+static const WaveDragRef wave_ref[] = {
+    {0.5, 0},
+    {0.76, 0.0016000000000000014},
+    {0.8, 0.0080000000000000071},
+    {0.9, 0.024000000000000004},
+    {0.99, 0.038399999999999997},
+    {1.0, 0.040000000000000001},
+    {1.05, 0.040000000000000001},
+    {1.1, 0.040000000000000001},
+    {1.2, 0.027633971188310315},
+    {1.5, 0.016395121225535367},
+    {2.0, 0.010583005244258368},
+    {2.5, 0.0080000000000000036},
+    {3.0, 0.0064807406984078633},
+    {3.2, 0.0060302268915552754},
+    {4.5, 0.0041778637429367499},
+};
+
+//InducedDrag and WaveDrag against the reference values (relative).
+static double InducedDragError(void){
+    double err = 0.0;
+    for(const InducedDragRef &r : induced_ref)
+        err = std::max(err, RelError(InducedDrag(r.A, r.e)(r.cl), r.cd));
+    return err;
+}
+
+static double WaveDragError(void){
+    WaveDrag wave(0.75, 1.0, 1.1, 0.04);
+    double err = 0.0;
+    for(const WaveDragRef &r : wave_ref) err = std::max(err, RelError(wave(r.M), r.cd));
+    return err;
+}
+
+//Runs body (which performs ops operations) REPETITIONS times and records the
+//fastest run.
+static void Bench(const std::string &name, long long ops, const std::function<void()> &body,
+    const std::function<void()> &setup = std::function<void()>()){
+    double best = 1e300;
+    for(int r = 0; r < REPETITIONS; r++){
+        if(setup) setup();
+        auto t0 = std::chrono::steady_clock::now();
+        body();
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count());
+    }
+    results.push_back({name, best / ops, ops});
+    fprintf(stderr, "%-44s %10.2f ns/op\n", name.c_str(), best / ops);
+}
+
+//AoA (or beta) x Mach sweep through an airfoil callback.
+static void BenchAirfoil(const std::string &name, AirfoilCoeffFuncEx cf, VESSEL *v, void *context,
+    double amin, double amax){
+    const int na = 721, nm = 61;
+    std::vector<double> angles(na), machs(nm);
+    for(int i = 0; i < na; i++) angles[i] = amin + (amax - amin) * i / (na - 1);
+    for(int j = 0; j < nm; j++) machs[j] = 3.5 * j / (nm - 1);
+    Bench(name, (long long)na * nm, [&]{
+        double acc = 0.0;
+        for(int j = 0; j < nm; j++)
+            for(int i = 0; i < na; i++){
+                double cl, cm, cd;
+                cf(v, angles[i], machs[j], 1e8, context, &cl, &cm, &cd);
+                acc += cl + cm + cd;
+            }
+        sink = acc;
+    });
+}
+
+//Writes a recording of the replayed channels: duration seconds every dt,
+//the actuators and control surfaces sweeping slowly.
+static bool WriteBenchRecording(const char *path, double duration, double dt){
+    static const char *names[] = {"gear", "door", "nosecone", "droop", "elevator", "elevtrim",
+        "aileron", "rudder", "throttle", "sndbarrier", "contrails"};
+    const uint32_t nch = sizeof(names) / sizeof(names[0]);
+    FILE *f = fopen(path, "wb");
+    if(!f) return false;
+    RecorderHeader hdr = {};
+    memcpy(hdr.magic, RECORDER_MAGIC, sizeof(hdr.magic));
+    hdr.nchannel = nch;
+    hdr.record_size = (uint32_t)((sizeof(double) + nch * sizeof(float) + 7) & ~(size_t)7);
+    hdr.decimation = 1;
+    hdr.nrecord = (uint64_t)(duration / dt);
+    fwrite(&hdr, sizeof(hdr), 1, f);
+    for(uint32_t k = 0; k < nch; k++){
+        RecorderChannel ch = {};
+        snprintf(ch.name, sizeof(ch.name), "%s", names[k]);
+        fwrite(&ch, sizeof(ch), 1, f);
+    }
+    std::vector<char> rec(hdr.record_size, 0);
+    for(uint64_t i = 0; i < hdr.nrecord; i++){
+        double t = i * dt;
+        memcpy(rec.data(), &t, sizeof(t));
+        float *value = (float *)(rec.data() + sizeof(double));
+        for(uint32_t k = 0; k < nch; k++) value[k] = (float)(0.5 + 0.5 * sin(t / (60.0 + 10.0 * k)));
+        fwrite(rec.data(), rec.size(), 1, f);
+    }
+    return fclose(f) == 0;
+}
+
+int main(int argc, char **argv){
+
+    const char *root = argc > 1 ? argv[1] : ".";
+    const char *outpath = argc > 2 ? argv[2] : 0;
+
+    HeadlessSim sim(root);
+    VESSEL *v = sim.CreateVessel("XB-70 20001", "XB-70_Valkyrie", "Scenarios/XB-70 Valkyrie.scn");
+    XB70 *xb = (XB70 *)v;
+    HeadlessVessel *hv = v->Headless();
+    sim.SetFlightState(v, 18000.0, 700.0, 0.0, 3.0 * RAD);
+
+    //Aerodynamic callbacks, with the Mach database (as in flight) and with
+    //the built-in tables (a copy of the vessel's context without databases).
+    XB70Aero *ctx = (XB70Aero *)hv->airfoils[0].context;
+    XB70Aero builtin = *ctx;
+    static const TableSlot<AeroDatabase> no_db;
+    builtin.vdb = builtin.hdb = &no_db;
+    BenchAirfoil("VLiftCoeff/database", VLiftCoeff, v, ctx, -PI, PI);
+    BenchAirfoil("VLiftCoeff/builtin", VLiftCoeff, v, &builtin, -PI, PI);
+    BenchAirfoil("HLiftCoeff/database", HLiftCoeff, v, ctx, -PI, PI);
+    BenchAirfoil("HLiftCoeff/builtin", HLiftCoeff, v, &builtin, -PI, PI);
+
+    //The uniform tables against the breakpoint scan they replace, over the
+    //whole angle range: inside the breakpoints and beyond them.
+    Accuracy("AeroTable/vlift", TableError(ctx->vlift, -PI, PI));
+    Accuracy("AeroTable/vlift_delta", TableError(ctx->vlift_delta, -PI, PI));
+    Accuracy("AeroTable/hlift", TableError(ctx->hlift, -PI, PI));
+
+    //The local drag terms against reference values of oapiGetInducedDrag
+    //and oapiGetWaveDrag (relative), with the default airfoil parameters.
+    Accuracy("InducedDrag", InducedDragError());
+    Accuracy("WaveDrag", WaveDragError());
+
+    //clbkPostStep with each actuator in every status. A tiny simdt keeps the
+    //moving states moving for the whole run.
+    const int npost = 200000;
+    static const char *gear_names[] = {"down", "up", "deploying", "stowing"};
+    static const char *door_names[] = {"closed", "open", "closing", "opening"};
+    static const char *nose_names[] = {"deployed", "stowed", "deploying", "stowing"};
+    for(int s = 0; s < 4; s++){
+        Bench(std::string("clbkPostStep/gear_") + gear_names[s], npost, [&]{
+            for(int i = 0; i < npost; i++) xb->clbkPostStep(i * 1e-7, 1e-7, 0.0);
+        }, [&]{
+            sim.LoadState(v, "GEAR 0 0.5\nDOOR 0 0.0");
+            xb->ActivateLandingGear((XB70::LandingGearStatus)s);
+            xb->ActivateNoseCone(XB70::NOSEC_DEPLOYED);
+        });
+    }
+    for(int s = 0; s < 4; s++){
+        Bench(std::string("clbkPostStep/door_") + door_names[s], npost, [&]{
+            for(int i = 0; i < npost; i++) xb->clbkPostStep(i * 1e-7, 1e-7, 0.0);
+        }, [&]{
+            sim.LoadState(v, "GEAR 0 0.0\nDOOR 0 0.5");
+            xb->ActivateDoor((XB70::DoorStatus)s);
+            xb->ActivateNoseCone(XB70::NOSEC_DEPLOYED);
+        });
+    }
+    for(int s = 0; s < 4; s++){
+        Bench(std::string("clbkPostStep/nosecone_") + nose_names[s], npost, [&]{
+            for(int i = 0; i < npost; i++) xb->clbkPostStep(i * 1e-7, 1e-7, 0.0);
+        }, [&]{
+            sim.LoadState(v, "GEAR 0 0.0\nDOOR 0 0.0");
+            xb->ActivateNoseCone((XB70::NoseConeStatus)s);
+        });
+    }
+
+    //Particle level evaluations.
+    const int nlvl = 1000000;
+    Bench("UpdateLvlSndBarrier", nlvl, [&]{
+        double acc = 0.0;
+        for(int i = 0; i < nlvl; i++) acc += xb->UpdateLvlSndBarrier();
+        sink = acc;
+    });
+    Bench("UpdateLvlCanardsEffect", nlvl, [&]{
+        double acc = 0.0;
+        for(int i = 0; i < nlvl; i++) acc += xb->UpdateLvlCanardsEffect();
+        sink = acc;
+    });
+
+    //Replay of a one-hour recording at 50 records/s: the keyframe seek on
+    //its own, in order and to random times, and clbkPostStep while playing
+    //(with the tiny simdt of the clbkPostStep runs above).
+    std::string fdr = std::string(P_tmpdir) + "/xb70_bench.fdr";
+    if(WriteBenchRecording(fdr.c_str(), 3600.0, 0.02)){
+        Replay replay;
+        replay.Open(fdr.c_str());
+        const int nseek = 1000000;
+        std::vector<double> seek_times(4096);
+        unsigned int seed = 12345;
+        for(double &t : seek_times){
+            seed = seed * 1664525u + 1013904223u;
+            t = 3600.0 * (seed >> 8) / (double)(1u << 24);
+        }
+        Bench("Replay::Seek/sequential", nseek, [&]{
+            double acc = 0.0;
+            for(int i = 0; i < nseek; i++){
+                replay.Seek(i * 0.0036);
+                acc += replay.Value(0);
+            }
+            sink = acc;
+        });
+        Bench("Replay::Seek/random", nseek, [&]{
+            double acc = 0.0;
+            for(int i = 0; i < nseek; i++){
+                replay.Seek(seek_times[i & 4095]);
+                acc += replay.Value(0);
+            }
+            sink = acc;
+        });
+        Bench("clbkPostStep/replay", npost, [&]{
+            for(int i = 0; i < npost; i++) xb->clbkPostStep(i * 1e-7, 1e-7, 0.0);
+        }, [&]{
+            sim.LoadState(v, "GEAR 0 0.0\nDOOR 0 0.0\nREPLAY " + fdr);
+        });
+        xb->StopReplay();
+        remove(fdr.c_str());
+    }
+
+    //Scenario I/O on the shipped scenario's vessel block.
+    HeadlessFile *scn = HeadlessFile::OpenScenarioShip("Scenarios/XB-70 Valkyrie.scn", "XB-70 20001");
+    if(scn){
+        const int nio = 20000;
+        Bench("clbkLoadStateEx/shipped_scn", nio, [&]{
+            for(int i = 0; i < nio; i++){
+                scn->next = 0;
+                hv->default_state.clear();
+                xb->clbkLoadStateEx((FILEHANDLE)scn, 0);
+            }
+        });
+        HeadlessFile *out = HeadlessFile::ForWriting();
+        Bench("clbkSaveState/shipped_scn", nio, [&]{
+            for(int i = 0; i < nio; i++){
+                out->out.clear();
+                xb->clbkSaveState((FILEHANDLE)out);
+            }
+        });
+        HeadlessFile *saved = HeadlessFile::FromText(out->out);
+        Bench("clbkLoadStateEx/saved", nio, [&]{
+            for(int i = 0; i < nio; i++){
+                saved->next = 0;
+                hv->default_state.clear();
+                xb->clbkLoadStateEx((FILEHANDLE)saved, 0);
+            }
+        });
+        delete saved;
+        xb->SetCompactState(true);
+        Bench("clbkSaveState/compact", nio, [&]{
+            for(int i = 0; i < nio; i++){
+                out->out.clear();
+                xb->clbkSaveState((FILEHANDLE)out);
+            }
+        });
+        xb->SetCompactState(false);
+        HeadlessFile *compact = HeadlessFile::FromText(out->out);
+        Bench("clbkLoadStateEx/compact", nio, [&]{
+            for(int i = 0; i < nio; i++){
+                compact->next = 0;
+                hv->default_state.clear();
+                xb->clbkLoadStateEx((FILEHANDLE)compact, 0);
+            }
+        });
+        delete compact;
+        delete out;
+        delete scn;
+    }
+
+    //Formatting of the custom state lines alone (gear, door, nose cone,
+    //droop): the previous sprintf path against ScenarioWriter.
+    {
+        const int nfmt = 200000;
+        const int status[3] = {1, 2, 0};
+        const double proc[4] = {1.0, 0.4187332901765432, 0.0, 0.3846153846153846};
+        Bench("scenario_format/sprintf", nfmt, [&]{
+            size_t len = 0;
+            for(int i = 0; i < nfmt; i++){
+                char cbuf[256];
+                for(int k = 0; k < 3; k++) len += sprintf(cbuf, "%d %0.4f", status[k], proc[k]);
+                len += sprintf(cbuf, "%d %d %0.4f", 0, 1, proc[3]);
+            }
+            sink = (double)len;
+        });
+        Bench("scenario_format/to_chars", nfmt, [&]{
+            size_t len = 0;
+            for(int i = 0; i < nfmt; i++){
+                for(int k = 0; k < 3; k++){
+                    ScenarioWriter w;
+                    len += strlen(w.Int(status[k]).Float(proc[k]).Str());
+                }
+                ScenarioWriter w;
+                len += strlen(w.Int(0).Int(1).Float(proc[3]).Str());
+            }
+            sink = (double)len;
+        });
+    }
+
+    //Mesh loading per vessel instance: text parse vs. the mapped binary cache
+    //(the first LoadMeshCached call above built it if needed).
+    const int nmesh = 20;
+    Bench("mesh/oapiLoadMesh", nmesh, [&]{
+        for(int i = 0; i < nmesh; i++) oapiDeleteMesh(oapiLoadMesh("XB-70_Valkyrie"));
+    });
+    Bench("mesh/LoadMeshCached", nmesh, [&]{
+        for(int i = 0; i < nmesh; i++) DeleteMeshCached(LoadMeshCached("XB-70_Valkyrie"));
+    });
+
+    //Memory footprint per instance in a fleet: the vessel object plus its
+    //share of the meshes the fleet references.
+    const int nfleet = 16;
+    std::vector<VESSEL *> fleet;
+    for(int i = 0; i < nfleet; i++){
+        char name[32];
+        snprintf(name, sizeof(name), "XB-70 fleet %d", i);
+        fleet.push_back(sim.CreateVessel(name, "XB-70_Valkyrie"));
+    }
+    std::set<const HeadlessMesh *> fleet_meshes;
+    for(VESSEL *fv : fleet)
+        for(const HeadlessMesh *m : fv->Headless()->meshes) fleet_meshes.insert(m);
+    size_t mesh_bytes = 0;
+    for(const HeadlessMesh *m : fleet_meshes) mesh_bytes += m ? m->Bytes() : 0;
+    for(VESSEL *fv : fleet) sim.DeleteVessel(fv);
+    double bytes_per_instance = sizeof(XB70) + (double)mesh_bytes / nfleet;
+    fprintf(stderr, "%-44s %10.0f bytes (%d instances, %zu meshes, %zu mesh bytes)\n", "memory/per_instance",
+        bytes_per_instance, nfleet, fleet_meshes.size(), mesh_bytes);
+
+    //Mesh level, groups (draw calls), triangles, texture changes and texture
+    //memory by camera distance.
+    struct LodPoint{double dist; int level; size_t groups, triangles; int binds, textures; size_t texture_bytes;};
+    std::vector<LodPoint> lod_points;
+    static const double lod_dist[] = {0.0, 100.0, 300.0, 1000.0, 3000.0, 10000.0};
+    for(double d : lod_dist){
+        sim.SetCamera(v, d);
+        xb->UpdateLod();
+        size_t grp = 0, tri = 0;
+        int binds = 0;
+        SURFHANDLE bound = 0;
+        for(size_t m = 0; m < hv->meshes.size(); m++){
+            if(hv->mesh_vis[m] == MESHVIS_NEVER || !hv->meshes[m]) continue;
+            grp += hv->meshes[m]->groups.size();
+            tri += hv->meshes[m]->Triangles();
+            const std::vector<SURFHANDLE> &surf = hv->visual[m].surfaces;
+            for(const HeadlessMeshGroup &g : hv->meshes[m]->groups){
+                SURFHANDLE t = g.texture && g.texture <= surf.size() ? surf[g.texture - 1] : 0;
+                if(t && t != bound) binds++;
+                bound = t;
+            }
+        }
+        lod_points.push_back({d, xb->GetLod(), grp, tri, binds, HeadlessSim::TextureCount(), HeadlessSim::TextureBytes()});
+        fprintf(stderr, "lod/camera_%-33.0f %10d level, %zu groups, %zu triangles, %d texture binds, %zu texture bytes\n",
+            d, xb->GetLod(), grp, tri, binds, HeadlessSim::TextureBytes());
+    }
+    sim.SetCamera(v, 0.0);
+
+    //Machine-readable report.
+    FILE *f = outpath ? fopen(outpath, "w") : stdout;
+    if(!f){
+        fprintf(stderr, "cannot write %s\n", outpath);
+        return 1;
+    }
+#ifdef XB70_EXACT_AERO
+    const char *aero = "exact";
+#else
+    const char *aero = "uniform";
+#endif
+    fprintf(f, "{\n  \"suite\": \"xb70_bench\",\n  \"aero_tables\": \"%s\",\n  \"repetitions\": %d,\n  \"results\": [\n",
+        aero, REPETITIONS);
+    for(size_t i = 0; i < results.size(); i++)
+        fprintf(f, "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"ops\": %lld}%s\n", results[i].name.c_str(),
+            results[i].ns_per_op, results[i].ops, i + 1 < results.size() ? "," : "");
+    fprintf(f, "  ],\n  \"accuracy\": [\n");
+    for(size_t i = 0; i < accuracy.size(); i++)
+        fprintf(f, "    {\"name\": \"%s\", \"max_error\": %.3g}%s\n", accuracy[i].name.c_str(),
+            accuracy[i].max_error, i + 1 < accuracy.size() ? "," : "");
+    fprintf(f, "  ],\n  \"memory\": {\"instances\": %d, \"vessel_bytes\": %zu, \"meshes\": %zu, \"mesh_bytes\": %zu, "
+        "\"bytes_per_instance\": %.0f},\n  \"lod\": [\n", nfleet, sizeof(XB70), fleet_meshes.size(), mesh_bytes, bytes_per_instance);
+    for(size_t i = 0; i < lod_points.size(); i++)
+        fprintf(f, "    {\"camera_dist\": %.0f, \"level\": %d, \"groups\": %zu, \"triangles\": %zu, \"texture_binds\": %d, "
+            "\"textures\": %d, \"texture_bytes\": %zu}%s\n", lod_points[i].dist, lod_points[i].level, lod_points[i].groups,
+            lod_points[i].triangles, lod_points[i].binds, lod_points[i].textures, lod_points[i].texture_bytes,
+            i + 1 < lod_points.size() ? "," : "");
+    fprintf(f, "  ]\n}\n");
+    if(outpath) fclose(f);
+    return 0;
+}
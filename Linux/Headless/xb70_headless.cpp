@@ -0,0 +1,60 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          HEADLESS ORBITER STAND-IN
+//
+//xb70_headless.cpp
+//Flies one XB-70 through a climb and acceleration profile at a fixed step
+//and reports the module's API traffic and saved state.
+//
+//Usage: xb70_headless [root] [seconds] [dt]
+//
+//==========================================
+
+#include "HeadlessOrbiter.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char **argv){
+
+    const char *root = argc > 1 ? argv[1] : ".";
+    double duration = argc > 2 ? atof(argv[2]) : 1200.0;
+    double dt = argc > 3 ? atof(argv[3]) : 0.02;
+
+    HeadlessSim sim(root);
+    VESSEL *v = sim.CreateVessel("XB-70 20001", "XB-70_Valkyrie");
+    HeadlessVessel *hv = v->Headless();
+
+    //Start airborne just after take-off with the gear down, then retract it.
+    sim.SetFlightState(v, 3000.0, 180.0, 0.0, 5.0 * RAD);
+    sim.SetThrottle(v, 1.0);
+    sim.PressKey(v, OAPI_KEY_G);
+
+    int nstep = (int)(duration / dt + 0.5);
+    int report = (int)(60.0 / dt + 0.5);
+    for(int i = 0; i < nstep; i++){
+        //Climb to 21 km on a Mach schedule (0.9 up to 9 km, then rising to
+        //3 at 21 km), accelerating level whenever the aircraft is behind it;
+        //then hold altitude and accelerate.
+        double mach_sched = 0.9 + 2.1 * std::max(0.0, std::min(1.0, (hv->alt - 9000.0) / 12000.0));
+        double gamma_climb = std::max(0.0, (v->GetMachNumber() - mach_sched) * 2.0);
+        double gamma_cmd = std::max(-0.05, std::min({0.12, (21000.0 - hv->alt) * 2e-4, gamma_climb}));
+        hv->aoa = HeadlessTrimAoA(v, gamma_cmd);
+        sim.Step(dt);
+        if(i % report == 0)
+            printf("t=%7.1f alt=%8.0f M=%5.2f aoa=%5.2f gamma=%6.2f fuel=%8.0f\n", sim.SimT(), hv->alt,
+                v->GetMachNumber(), hv->aoa * DEG, hv->gamma * DEG, hv->propellants.empty() ? 0.0 : hv->propellants[0].mass);
+    }
+
+    const HeadlessStats &s = hv->stats;
+    printf("\nsteps=%llu airfoil_calls=%llu set_animation=%llu set_touchdown=%llu set_thruster=%llu\n",
+        (unsigned long long)s.steps, (unsigned long long)s.airfoil_calls,
+        (unsigned long long)s.set_animation, (unsigned long long)s.set_touchdown,
+        (unsigned long long)s.set_thruster);
+
+    printf("\n--- saved state ---\n%s", sim.SaveState(v).c_str());
+    return 0;
+}
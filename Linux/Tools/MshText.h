@@ -0,0 +1,88 @@
+#ifndef __MSHTEXT_H
+#define __MSHTEXT_H
+
+//Orbiter MSHX1 text meshes as the mesh tools see them: group header lines
+//(LABEL, MATERIAL, TEXTURE, FLAG, ...) and the MATERIALS/TEXTURES sections
+//are kept verbatim, only the geometry is parsed. Shared by xb70_meshlod and
+//xb70_meshbatch.
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Group{
+    std::vector<std::string> header;    //Lines before GEOM, copied verbatim
+    int nfield;                         //Floats per vertex (3, 5, 6 or 8)
+    std::vector<float> vtx;             //nfield floats per vertex
+    std::vector<int> idx;
+};
+
+struct Mesh{
+    std::vector<Group> groups;
+    std::vector<std::string> tail;      //MATERIALS and TEXTURES, copied verbatim
+};
+
+inline bool ReadMesh(const char *path, Mesh &mesh){
+    std::ifstream f(path);
+    std::string line;
+    if(!std::getline(f, line) || line.compare(0, 5, "MSHX1")) return false;
+    int ngroup = 0;
+    if(!std::getline(f, line) || sscanf(line.c_str(), "GROUPS %d", &ngroup) != 1) return false;
+    mesh.groups.resize(ngroup);
+    for(int g = 0; g < ngroup; g++){
+        Group &grp = mesh.groups[g];
+        int nv = -1, nt = 0;
+        while(std::getline(f, line)){
+            if(sscanf(line.c_str(), "GEOM %d %d", &nv, &nt) == 2) break;
+            grp.header.push_back(line);
+        }
+        if(nv < 0) return false;
+        grp.nfield = 0;
+        std::vector<std::string> vlines(nv);
+        for(int i = 0; i < nv && std::getline(f, line); i++) vlines[i] = line;
+        for(int i = 0; i < nv; i++){
+            std::istringstream s(vlines[i]);
+            std::vector<float> v;
+            float x;
+            while(s >> x) v.push_back(x);
+            if(!i) grp.nfield = (int)v.size();
+            v.resize(grp.nfield, 0.0f);
+            grp.vtx.insert(grp.vtx.end(), v.begin(), v.end());
+        }
+        grp.idx.resize(nt * 3);
+        for(int i = 0; i < nt * 3; i++) f >> grp.idx[i];
+        std::getline(f, line);
+    }
+    while(std::getline(f, line)) mesh.tail.push_back(line);
+    return true;
+}
+
+inline bool WriteMesh(const char *path, const Mesh &mesh){
+    FILE *f = fopen(path, "w");
+    if(!f) return false;
+    fprintf(f, "MSHX1\nGROUPS %d\n", (int)mesh.groups.size());
+    for(const Group &g : mesh.groups){
+        for(const std::string &l : g.header) fprintf(f, "%s\n", l.c_str());
+        int nv = g.nfield ? (int)(g.vtx.size() / g.nfield) : 0;
+        fprintf(f, "GEOM %d %d\n", nv, (int)(g.idx.size() / 3));
+        for(int i = 0; i < nv; i++){
+            for(int k = 0; k < g.nfield; k++) fprintf(f, k ? " %.4f" : "%.4f", g.vtx[i * g.nfield + k]);
+            fprintf(f, "\n");
+        }
+        for(size_t t = 0; t < g.idx.size(); t += 3) fprintf(f, "%d %d %d\n", g.idx[t], g.idx[t + 1], g.idx[t + 2]);
+    }
+    for(const std::string &l : mesh.tail) fprintf(f, "%s\n", l.c_str());
+    return fclose(f) == 0;
+}
+
+inline void Totals(const Mesh &mesh, long &nvtx, long &ntri){
+    nvtx = ntri = 0;
+    for(const Group &g : mesh.groups){
+        nvtx += g.nfield ? (long)(g.vtx.size() / g.nfield) : 0;
+        ntri += (long)(g.idx.size() / 3);
+    }
+}
+
+#endif //!__MSHTEXT_H
@@ -0,0 +1,93 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          XB-70 FLIGHT DATA TOOLS
+//
+//xb70_fdr2csv.cpp
+//Converts a flight data recording (FlightData/*.fdr, see
+//Linux/XB70Recorder.h) to CSV: one row per record, the simulation time
+//first, then the channels in recorded order. The header row names each
+//column with its unit. A recording cut short (the simulator did not close
+//it) is read up to its last complete record.
+//
+//Usage: xb70_fdr2csv recording.fdr [output.csv]
+//Without an output file the CSV goes to stdout.
+//
+//==========================================
+
+#include "XB70Recorder.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char **argv){
+
+    if(argc < 2){
+        fprintf(stderr, "usage: %s recording.fdr [output.csv]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if(!in){
+        fprintf(stderr, "%s: cannot open\n", argv[1]);
+        return 1;
+    }
+    RecorderHeader hdr;
+    if(fread(&hdr, sizeof(hdr), 1, in) != 1 || memcmp(hdr.magic, RECORDER_MAGIC, sizeof(hdr.magic)) ||
+        hdr.record_size < sizeof(double) + hdr.nchannel * sizeof(float)){
+        fprintf(stderr, "%s: not a flight data recording\n", argv[1]);
+        fclose(in);
+        return 1;
+    }
+    std::vector<RecorderChannel> channels(hdr.nchannel);
+    if(hdr.nchannel && fread(channels.data(), sizeof(RecorderChannel), hdr.nchannel, in) != hdr.nchannel){
+        fprintf(stderr, "%s: truncated channel list\n", argv[1]);
+        fclose(in);
+        return 1;
+    }
+
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if(!out){
+        fprintf(stderr, "%s: cannot create\n", argv[2]);
+        fclose(in);
+        return 1;
+    }
+
+    fprintf(out, "simt [s]");
+    for(RecorderChannel &ch : channels){
+        ch.name[sizeof(ch.name) - 1] = ch.unit[sizeof(ch.unit) - 1] = '\0';
+        if(ch.unit[0]) fprintf(out, ",%s [%s]", ch.name, ch.unit);
+        else fprintf(out, ",%s", ch.name);
+    }
+    fprintf(out, "\n");
+
+    //A closed recording says how many records it holds. An unclosed one ends
+    //where the zero padding of its last file chunk starts: the first record
+    //after the first one that is all zeros.
+    std::vector<char> rec(hdr.record_size);
+    uint64_t n = 0;
+    while((!hdr.nrecord || n < hdr.nrecord) && fread(rec.data(), hdr.record_size, 1, in) == 1){
+        double simt;
+        memcpy(&simt, rec.data(), sizeof(simt));
+        const float *value = (const float *)(rec.data() + sizeof(double));
+        if(!hdr.nrecord && n > 0){
+            bool blank = simt == 0.0;
+            for(uint32_t k = 0; blank && k < hdr.nchannel; k++) blank = value[k] == 0.0f;
+            if(blank) break;
+        }
+        fprintf(out, "%.6f", simt);
+        for(uint32_t k = 0; k < hdr.nchannel; k++) fprintf(out, ",%.7g", value[k]);
+        fprintf(out, "\n");
+        n++;
+    }
+    fclose(in);
+    if(out != stdout) fclose(out);
+
+    fprintf(stderr, "%s: %llu records of %u channels, every %u steps", argv[1],
+        (unsigned long long)n, hdr.nchannel, hdr.decimation);
+    if(!hdr.nrecord) fprintf(stderr, " (not closed)");
+    else if(hdr.dropped) fprintf(stderr, ", %u dropped", hdr.dropped);
+    fprintf(stderr, "\n");
+    return 0;
+}
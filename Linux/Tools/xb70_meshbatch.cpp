@@ -0,0 +1,136 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          XB-70 MESH TOOLS
+//
+//xb70_meshbatch.cpp
+//Merges the static groups of an Orbiter MSHX1 mesh into one group per
+//material, texture and flags, so the static parts are drawn with one call
+//per material instead of one per Blender object. Groups listed in the keep
+//file (the animated ones) are copied unchanged and still take a call each.
+//A merged group takes the place of its first member and is labelled
+//Static_<material>; the groups change order, so regenerate both
+//XB70_mesh_groups.h (xb70_meshdefs) afterwards.
+//
+//Usage: xb70_meshbatch input.msh output.msh keepfile
+//The keep file lists one group label per line; '#' starts a comment.
+//
+//==========================================
+
+#include "MshText.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+//Largest vertex count of a group: indices are 16 bits in Orbiter.
+static const size_t MAX_GROUP_VTX = 65535;
+
+static std::string Label(const Group &g){
+    for(const std::string &l : g.header)
+        if(!l.compare(0, 6, "LABEL ")) return l.substr(6);
+    return std::string();
+}
+
+//Everything that decides how a group is drawn: its header without the label,
+//and the vertex layout.
+static std::string BatchKey(const Group &g){
+    std::string key;
+    for(const std::string &l : g.header)
+        if(l.compare(0, 6, "LABEL ")) key += l + "\n";
+    return key + std::to_string(g.nfield);
+}
+
+//Label for a batch of groups drawn like g: Static_ plus the material name.
+static std::string BatchLabel(const Group &g, const Mesh &mesh, std::set<std::string> &used){
+    int mtrl = 0;
+    for(const std::string &l : g.header) sscanf(l.c_str(), "MATERIAL %d", &mtrl);
+    std::string name = mtrl ? "M" + std::to_string(mtrl) : "NoMaterial";
+    for(size_t i = 0; i < mesh.tail.size(); i++){
+        int n;
+        if(sscanf(mesh.tail[i].c_str(), "MATERIALS %d", &n) == 1 && mtrl >= 1 && mtrl <= n && i + mtrl < mesh.tail.size())
+            name = mesh.tail[i + mtrl];
+    }
+    std::string label = "Static_" + name;
+    for(int k = 2; !used.insert(label).second; k++) label = "Static_" + name + "_" + std::to_string(k);
+    return label;
+}
+
+static bool ReadKeep(const char *path, std::set<std::string> &keep){
+    std::ifstream f(path);
+    if(!f) return false;
+    std::string line;
+    while(std::getline(f, line)){
+        size_t hash = line.find('#');
+        if(hash != std::string::npos) line.erase(hash);
+        size_t b = line.find_first_not_of(" \t\r"), e = line.find_last_not_of(" \t\r");
+        if(b != std::string::npos) keep.insert(line.substr(b, e - b + 1));
+    }
+    return true;
+}
+
+int main(int argc, char **argv){
+
+    if(argc < 4){
+        fprintf(stderr, "usage: %s input.msh output.msh keepfile\n", argv[0]);
+        return 2;
+    }
+    Mesh src;
+    if(!ReadMesh(argv[1], src)){
+        fprintf(stderr, "%s: not a readable MSHX1 mesh\n", argv[1]);
+        return 1;
+    }
+    std::set<std::string> keep;
+    if(!ReadKeep(argv[3], keep)){
+        fprintf(stderr, "cannot read %s\n", argv[3]);
+        return 1;
+    }
+    std::set<std::string> found;
+    for(const Group &g : src.groups) found.insert(Label(g));
+    for(const std::string &k : keep)
+        if(!found.count(k)) fprintf(stderr, "warning: %s has no group %s\n", argv[1], k.c_str());
+
+    Mesh out;
+    out.tail = src.tail;
+    std::map<std::string, size_t> open_batch;   //Key -> index into out.groups
+    std::set<std::string> labels(found);
+    int nbatch = 0, nmerged = 0;
+    for(const Group &g : src.groups){
+        if(keep.count(Label(g))){
+            out.groups.push_back(g);
+            continue;
+        }
+        std::string key = BatchKey(g);
+        size_t nv = g.nfield ? g.vtx.size() / g.nfield : 0;
+        auto it = open_batch.find(key);
+        if(it != open_batch.end()){
+            Group &b = out.groups[it->second];
+            size_t base = b.vtx.size() / b.nfield;
+            if(base + nv <= MAX_GROUP_VTX){
+                b.vtx.insert(b.vtx.end(), g.vtx.begin(), g.vtx.end());
+                for(int i : g.idx) b.idx.push_back((int)base + i);
+                nmerged++;
+                continue;
+            }
+        }
+        //First group of a batch (or the previous one is full).
+        Group b = g;
+        for(std::string &l : b.header)
+            if(!l.compare(0, 6, "LABEL ")) l = "LABEL " + BatchLabel(g, src, labels);
+        open_batch[key] = out.groups.size();
+        out.groups.push_back(b);
+        nbatch++;
+    }
+
+    if(!WriteMesh(argv[2], out)){
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    printf("%s: %d groups -> %s: %d groups (%d kept, %d static batches from %d groups)\n", argv[1],
+        (int)src.groups.size(), argv[2], (int)out.groups.size(), (int)(out.groups.size() - nbatch), nbatch,
+        nbatch + nmerged);
+    return 0;
+}
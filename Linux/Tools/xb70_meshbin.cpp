@@ -0,0 +1,104 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          XB-70 MESH TOOLS
+//
+//xb70_meshbin.cpp
+//Converts an Orbiter MSHX1 mesh into the binary mesh cache format read by
+//the module (see Linux/XB70MeshBin.h) and lists what was written. The module
+//rebuilds the cache by itself when needed; the tool is for installers and
+//for inspecting the result.
+//
+//For each group the listing compares the .msh with the cache: vertex count
+//after merging duplicates, storage (vertices and indices) and vertex fetch
+//per draw, i.e. post-transform cache misses times the vertex size, with the
+//cache misses per triangle (ACMR) before and after the triangle reordering.
+//The module decodes quantized vertices to NTVERTEX before the mesh is
+//created, so -q only shrinks the file: fetch is counted at the NTVERTEX
+//size either way.
+//
+//Usage: xb70_meshbin [-q] input.msh [output.mshb]
+//-q stores quantized vertices (16-bit positions and normals, 20 bytes).
+//
+//==========================================
+
+#include "XB70MeshBin.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+//Size of the NTVERTEX layout the .msh is loaded into.
+static const size_t SRC_VTXSIZE = 8 * sizeof(float);
+
+static double Percent(double now, double before){
+    return before > 0.0 ? 100.0 * (before - now) / before : 0.0;
+}
+
+int main(int argc, char **argv){
+
+    uint32_t flags = 0;
+    int arg = 1;
+    if(arg < argc && !strcmp(argv[arg], "-q")){
+        flags |= MESHBIN_QUANTIZED;
+        arg++;
+    }
+    if(argc - arg < 1){
+        fprintf(stderr, "usage: %s [-q] input.msh [output.mshb]\n", argv[0]);
+        return 2;
+    }
+    const char *mshpath = argv[arg];
+    std::string binpath;
+    if(argc - arg > 1){
+        binpath = argv[arg + 1];
+    } else {
+        binpath = mshpath;
+        size_t dot = binpath.rfind('.');
+        if(dot != std::string::npos && binpath.find('/', dot) == std::string::npos) binpath.erase(dot);
+        binpath += ".mshb";
+    }
+
+    char err[256];
+    if(!MeshBinBuild(mshpath, binpath.c_str(), err, sizeof(err), flags)){
+        fprintf(stderr, "%s\n", err);
+        return 1;
+    }
+
+    MeshBinFile file;
+    if(!file.Open(binpath.c_str(), mshpath)){
+        fprintf(stderr, "%s: written but does not verify\n", binpath.c_str());
+        return 1;
+    }
+    const MeshBinHeader &h = file.Header();
+    size_t vsize = file.VertexSize();
+    unsigned long nvtx = 0, src_nvtx = 0, ntri = 0;
+    double bytes = 0, src_bytes = 0, fetch = 0, src_fetch = 0, step = 0;
+    printf("%-32s %6s %6s %4s %4s %17s %15s %15s\n", "group", "vtx", "tri", "mtl", "tex",
+        "bytes", "acmr", "fetch/draw");
+    for(uint32_t g = 0; g < h.ngroup; g++){
+        const MeshBinGroup &grp = file.Group(g);
+        size_t tri = grp.nidx / 3;
+        double acmr = MeshBinACMR(file.Indices(g), grp.nidx);
+        double b = (double)grp.nvtx * vsize + grp.nidx * sizeof(uint16_t);
+        double sb = (double)grp.src_nvtx * SRC_VTXSIZE + grp.nidx * sizeof(uint16_t);
+        double f = acmr * tri * SRC_VTXSIZE, sf = grp.src_acmr * tri * SRC_VTXSIZE;
+        printf("%-32s %6u %6zu %4u %4u %8.0f>%8.0f %6.3f>%6.3f %7.0f>%7.0f\n", grp.label, grp.nvtx, tri,
+            grp.material, grp.texture, sb, b, grp.src_acmr, acmr, sf, f);
+        nvtx += grp.nvtx;
+        src_nvtx += grp.src_nvtx;
+        ntri += tri;
+        bytes += b;
+        src_bytes += sb;
+        fetch += f;
+        src_fetch += sf;
+        for(int k = 0; k < 3; k++) if(grp.pos_scale[k] > step) step = grp.pos_scale[k];
+    }
+    printf("%u groups, %lu vertices (%lu in the .msh), %lu triangles, %u materials, %u textures\n",
+        h.ngroup, nvtx, src_nvtx, ntri, h.nmaterial, h.ntexture);
+    printf("geometry: %.0f -> %.0f bytes (-%.1f%%), vertex fetch per draw: %.0f -> %.0f bytes (-%.1f%%)\n",
+        src_bytes, bytes, Percent(bytes, src_bytes), src_fetch, fetch, Percent(fetch, src_fetch));
+    if(file.Quantized()) printf("quantized: %zu-byte vertices on disk (decoded at load), position error up to %.2f mm\n",
+        vsize, 500.0 * step);
+    printf("%s: %lu bytes\n", binpath.c_str(), (unsigned long)file.Size());
+    return 0;
+}
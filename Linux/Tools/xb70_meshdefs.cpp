@@ -0,0 +1,146 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          XB-70 MESH TOOLS
+//
+//xb70_meshdefs.cpp
+//Generates XB70_mesh_groups.h (Linux/ and Windows/) from an Orbiter MSHX1
+//mesh: the group count, one constexpr group Id per LABEL (in file order), the
+//bounding box centre of each group and the label table. With --check the header is not
+//written; the tool fails if the existing one differs from what the mesh
+//gives, so a build can refuse to go ahead with stale group Ids.
+//
+//Usage: xb70_meshdefs input.msh output.h [--check]
+//
+//==========================================
+
+#include "XB70MeshBin.h"
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <unistd.h>
+
+//C++ identifier for a group label.
+static std::string Identifier(const char *label, uint32_t g){
+    std::string id;
+    for(const char *p = label; *p; p++) id += isalnum((unsigned char)*p) ? *p : '_';
+    if(id.empty()){
+        char buf[32];
+        snprintf(buf, sizeof(buf), "Group%u", g);
+        id = buf;
+    }
+    if(isdigit((unsigned char)id[0])) id = "_" + id;
+    return id;
+}
+
+static void Append(std::string &s, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void Append(std::string &s, const char *fmt, ...){
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    s += buf;
+}
+
+//Header text for the mesh in file; false (with a message) on duplicate labels.
+static bool Generate(const MeshBinFile &file, const char *mshname, std::string &out){
+    const MeshBinHeader &h = file.Header();
+    std::string ids, centres, labels;
+    std::set<std::string> seen;
+
+    for(uint32_t g = 0; g < h.ngroup; g++){
+        const MeshBinGroup &grp = file.Group(g);
+        std::string id = Identifier(grp.label, g);
+        if(!seen.insert(id).second){
+            fprintf(stderr, "%s: group %u: label %s used twice\n", mshname, g, grp.label);
+            return false;
+        }
+        float lo[3] = {0, 0, 0}, hi[3] = {0, 0, 0};
+        const float *v = file.Vertices(g);
+        for(uint32_t i = 0; i < grp.nvtx; i++)
+            for(int k = 0; k < 3; k++){
+                float x = v[i * 8 + k];
+                if(!i || x < lo[k]) lo[k] = x;
+                if(!i || x > hi[k]) hi[k] = x;
+            }
+        Append(ids, "    constexpr UINT %s_Id = %u;\n", id.c_str(), g);
+        Append(centres, "    constexpr VECTOR3 %s_Centre = {%.4f, %.4f, %.4f};\n", id.c_str(),
+            0.5 * (lo[0] + hi[0]), 0.5 * (lo[1] + hi[1]), 0.5 * (lo[2] + hi[2]));
+        Append(labels, "        \"%s\",\n", grp.label);
+    }
+
+    out.clear();
+    Append(out, "// Generated by Linux/Tools/xb70_meshdefs from %s.\n", mshname);
+    out += "// Do not edit: regenerate it whenever the mesh changes.\n\n\n";
+    out += "#include \"Orbitersdk.h\"\n\n";
+    out += "#ifndef __XB70_MESH_GROUPS_H\n#define __XB70_MESH_GROUPS_H\n\n";
+    Append(out, "    constexpr UINT MESH_NGROUP = %u;\n\n", h.ngroup);
+    out += ids;
+    out += "\n    //Bounding box centres, in mesh coordinates.\n";
+    out += centres;
+    out += "\n    constexpr const char *MESH_GROUP_LABEL[MESH_NGROUP] = {\n";
+    out += labels;
+    out += "    };\n\n#endif\n";
+    return true;
+}
+
+int main(int argc, char **argv){
+
+    if(argc < 3){
+        fprintf(stderr, "usage: %s input.msh output.h [--check]\n", argv[0]);
+        return 2;
+    }
+    const char *mshpath = argv[1];
+    const char *hpath = argv[2];
+    bool check = argc > 3 && !strcmp(argv[3], "--check");
+
+    //The mesh is read through the binary cache converter, so the tool sees
+    //the groups exactly as the module does.
+    std::string binpath = std::string(hpath) + ".mshb";
+    char err[256];
+    if(!MeshBinBuild(mshpath, binpath.c_str(), err, sizeof(err))){
+        fprintf(stderr, "%s\n", err);
+        return 1;
+    }
+    MeshBinFile file;
+    bool ok = file.Open(binpath.c_str());
+    unlink(binpath.c_str());
+    if(!ok){
+        fprintf(stderr, "%s: cannot read converted mesh\n", mshpath);
+        return 1;
+    }
+
+    std::string text;
+    if(!Generate(file, mshpath, text)) return 1;
+
+    if(check){
+        std::string cur;
+        FILE *f = fopen(hpath, "rb");
+        if(f){
+            char buf[4096];
+            size_t n;
+            while((n = fread(buf, 1, sizeof(buf), f)) > 0) cur.append(buf, n);
+            fclose(f);
+        }
+        if(cur != text){
+            fprintf(stderr, "%s is out of date with %s; run %s %s %s\n", hpath, mshpath, argv[0], mshpath, hpath);
+            return 1;
+        }
+        return 0;
+    }
+
+    FILE *f = fopen(hpath, "wb");
+    if(!f || fwrite(text.data(), 1, text.size(), f) != text.size()){
+        fprintf(stderr, "cannot write %s\n", hpath);
+        if(f) fclose(f);
+        return 1;
+    }
+    fclose(f);
+    printf("%s: %u groups\n", hpath, file.Header().ngroup);
+    return 0;
+}
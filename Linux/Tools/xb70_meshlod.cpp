@@ -0,0 +1,153 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          XB-70 MESH TOOLS
+//
+//xb70_meshlod.cpp
+//Builds reduced-detail versions of an Orbiter MSHX1 mesh for distance-based
+//LOD switching. Each group is decimated on its own by vertex clustering, so
+//the output keeps the group order, labels, materials and textures of the
+//source: group Ids (and the animations built on them) are the same in every
+//level. Vertices are merged per grid cell and per dominant normal direction,
+//so hard edges survive; degenerate and duplicate triangles are dropped.
+//
+//Usage: xb70_meshlod input.msh cell1 [cell2 ...]
+//Writes input_lod1.msh, input_lod2.msh, ... with the given cell sizes [m].
+//
+//==========================================
+
+#include "MshText.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+//Dominant direction of a normal: 0..5 for +x, -x, +y, -y, +z, -z.
+static int NormalBin(const float *n){
+    int k = 0;
+    for(int i = 1; i < 3; i++) if(fabsf(n[i]) > fabsf(n[k])) k = i;
+    return 2 * k + (n[k] < 0.0f);
+}
+
+static Group Decimate(const Group &src, double cell){
+    Group out;
+    out.header = src.header;
+    out.nfield = src.nfield;
+    int nf = src.nfield;
+    int nv = nf ? (int)(src.vtx.size() / nf) : 0;
+    bool normals = nf >= 6;
+
+    //Cluster the vertices.
+    std::map<std::tuple<long, long, long, int>, int> cluster;
+    std::vector<int> remap(nv);
+    std::vector<double> sum;
+    std::vector<int> count;
+    for(int i = 0; i < nv; i++){
+        const float *v = &src.vtx[i * nf];
+        std::tuple<long, long, long, int> key((long)floor(v[0] / cell), (long)floor(v[1] / cell),
+            (long)floor(v[2] / cell), normals ? NormalBin(v + 3) : 0);
+        auto it = cluster.find(key);
+        int c;
+        if(it == cluster.end()){
+            c = (int)count.size();
+            cluster[key] = c;
+            count.push_back(0);
+            sum.resize(sum.size() + nf, 0.0);
+            out.vtx.insert(out.vtx.end(), v, v + nf);   //Texture coordinates of the first vertex
+        } else {
+            c = it->second;
+        }
+        for(int k = 0; k < 3 || (normals && k < 6); k++) sum[c * nf + k] += v[k];
+        count[c]++;
+        remap[i] = c;
+    }
+    for(size_t c = 0; c < count.size(); c++){
+        float *v = &out.vtx[c * nf];
+        for(int k = 0; k < 3; k++) v[k] = (float)(sum[c * nf + k] / count[c]);
+        if(normals){
+            double len = sqrt(sum[c * nf + 3] * sum[c * nf + 3] + sum[c * nf + 4] * sum[c * nf + 4] +
+                sum[c * nf + 5] * sum[c * nf + 5]);
+            for(int k = 3; k < 6; k++) v[k] = len > 0.0 ? (float)(sum[c * nf + k] / len) : 0.0f;
+        }
+    }
+
+    //Remap the triangles, dropping degenerate and repeated ones.
+    std::set<std::tuple<int, int, int> > seen;
+    for(size_t t = 0; t + 2 < src.idx.size(); t += 3){
+        int a = remap[src.idx[t]], b = remap[src.idx[t + 1]], c = remap[src.idx[t + 2]];
+        if(a == b || b == c || a == c) continue;
+        //Same triangle with the same winding, whatever the starting vertex.
+        int r = (a < b && a < c) ? 0 : (b < c ? 1 : 2);
+        int tri[3] = {a, b, c};
+        if(!seen.insert(std::make_tuple(tri[r], tri[(r + 1) % 3], tri[(r + 2) % 3])).second) continue;
+        out.idx.push_back(a);
+        out.idx.push_back(b);
+        out.idx.push_back(c);
+    }
+
+    //Drop the clusters no triangle uses any more.
+    std::vector<int> used(count.size(), -1);
+    std::vector<float> vtx;
+    for(int &i : out.idx){
+        if(used[i] < 0){
+            used[i] = (int)(vtx.size() / nf);
+            vtx.insert(vtx.end(), &out.vtx[i * nf], &out.vtx[i * nf] + nf);
+        }
+        i = used[i];
+    }
+    out.vtx.swap(vtx);
+
+    //A group that vanished keeps one degenerate triangle, so it still exists
+    //for the animations and the group count stays the same.
+    if(out.idx.empty() && nv){
+        out.vtx.assign(src.vtx.begin(), src.vtx.begin() + nf);
+        out.idx.assign(3, 0);
+    }
+    return out;
+}
+
+int main(int argc, char **argv){
+
+    if(argc < 3){
+        fprintf(stderr, "usage: %s input.msh cell1 [cell2 ...]\n", argv[0]);
+        return 2;
+    }
+    const char *mshpath = argv[1];
+    Mesh src;
+    if(!ReadMesh(mshpath, src)){
+        fprintf(stderr, "%s: not a readable MSHX1 mesh\n", mshpath);
+        return 1;
+    }
+    std::string base = mshpath;
+    size_t dot = base.rfind('.');
+    if(dot != std::string::npos && base.find('/', dot) == std::string::npos) base.erase(dot);
+
+    long nvtx, ntri;
+    Totals(src, nvtx, ntri);
+    printf("%-40s %8s %8s\n", "level", "vtx", "tri");
+    printf("%-40s %8ld %8ld\n", mshpath, nvtx, ntri);
+    for(int l = 2; l < argc; l++){
+        double cell = atof(argv[l]);
+        if(cell <= 0.0){
+            fprintf(stderr, "bad cell size %s\n", argv[l]);
+            return 1;
+        }
+        Mesh lod;
+        lod.tail = src.tail;
+        for(const Group &g : src.groups) lod.groups.push_back(Decimate(g, cell));
+        char path[512];
+        snprintf(path, sizeof(path), "%s_lod%d.msh", base.c_str(), l - 1);
+        if(!WriteMesh(path, lod)){
+            fprintf(stderr, "cannot write %s\n", path);
+            return 1;
+        }
+        Totals(lod, nvtx, ntri);
+        printf("%-40s %8ld %8ld  (cell %.3g m)\n", path, nvtx, ntri, cell);
+    }
+    return 0;
+}
@@ -0,0 +1,294 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          XB-70 MESH TOOLS
+//
+//xb70_texatlas.cpp
+//Packs up to four textures of an Orbiter MSHX1 mesh into one atlas, so the
+//groups that used them share a texture (and its normal map): fewer textures
+//to load and fewer texture changes per frame. Each texture takes a quadrant
+//of an atlas of its own size, at half resolution: the atlas levels are the
+//source levels from the second one down, copied block by block without
+//recompression. The texture coordinates of the groups are remapped into
+//their quadrant, half a texel in from its edges. Sources must be DXT
+//textures of one size and format, and their groups must not wrap (u, v in
+//0..1).
+//
+//Normal maps (<name>_norm.dds) are packed the same way into <atlas>_norm.dds,
+//with a flat normal in the quadrants of textures that have none.
+//
+//The other entries of the TEXTURES list are checked as well: a texture that
+//is only found in texdir gets texdir's path under Textures/ as prefix, so
+//Orbiter finds it; one that is not found at all is reported.
+//
+//Usage: xb70_texatlas input.msh output.msh texdir atlas.dds tex1.dds tex2.dds [tex3.dds [tex4.dds]]
+//texdir is where the textures are (e.g. Textures/XB-70_Valkyrie); the atlas
+//is written there.
+//
+//==========================================
+
+#include "MshText.h"
+#include "XB70Dds.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+static bool Exists(const std::string &path){
+    struct stat st;
+    return !stat(path.c_str(), &st);
+}
+
+static long FileSize(const std::string &path){
+    struct stat st;
+    return stat(path.c_str(), &st) ? 0 : (long)st.st_size;
+}
+
+//"<name>_norm.dds" for "<name>.dds".
+static std::string NormName(const std::string &name){
+    size_t dot = name.rfind('.');
+    return (dot == std::string::npos ? name : name.substr(0, dot)) + "_norm" +
+        (dot == std::string::npos ? "" : name.substr(dot));
+}
+
+static std::string Basename(const std::string &path){
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+//DXT block of a flat normal (128, 128, 255), opaque: DXT5/DXT3 alpha, then
+//the colour block with both end points equal.
+static void FlatBlock(const DdsTexture &t, bool normal, char *blk){
+    memset(blk, 0, t.block_bytes);
+    char *c = blk + (t.block_bytes - 8);
+    if(t.block_bytes == 16){
+        if(t.fourcc == ('D' | 'X' << 8 | 'T' << 16 | '5' << 24)){
+            blk[0] = blk[1] = (char)0xff;
+        } else {
+            memset(blk, 0xff, 8);
+        }
+    }
+    uint16_t rgb = normal ? (16 << 11 | 32 << 5 | 31) : 0;
+    memcpy(c, &rgb, 2);
+    memcpy(c + 2, &rgb, 2);
+}
+
+//Atlas of src (null entries are filled with flat blocks).
+static bool Pack(const std::vector<const DdsTexture *> &src, bool normal, DdsTexture &atlas){
+    const DdsTexture *first = 0;
+    for(const DdsTexture *t : src) if(t && !first) first = t;
+    atlas.data.assign(first->data.begin(), first->data.begin() + DDS_HEADER_SIZE);
+    atlas.width = first->width;
+    atlas.height = first->height;
+    atlas.fourcc = first->fourcc;
+    atlas.block_bytes = first->block_bytes;
+    //Levels while a quadrant is at least one block wide and high.
+    atlas.mips = 0;
+    while(atlas.mips + 1 < first->mips && (atlas.width >> (atlas.mips + 1)) >= 4 && (atlas.height >> (atlas.mips + 1)) >= 4)
+        atlas.mips++;
+    if(!atlas.mips) return false;
+
+    std::vector<char> flat(atlas.block_bytes);
+    FlatBlock(atlas, normal, &flat[0]);
+    atlas.data.resize(atlas.LevelOffset(atlas.mips));
+    for(uint32_t l = 0; l < atlas.mips; l++){
+        char *dst = &atlas.data[atlas.LevelOffset(l)];
+        uint32_t ab = atlas.BlocksWide(l), qw = ab / 2, qh = atlas.BlocksHigh(l) / 2;
+        for(size_t q = 0; q < 4; q++){
+            const DdsTexture *t = q < src.size() ? src[q] : 0;
+            const char *s = t ? &t->data[t->LevelOffset(l + 1)] : 0;
+            for(uint32_t r = 0; r < qh; r++){
+                char *row = dst + ((size_t)((q / 2) * qh + r) * ab + (q % 2) * qw) * atlas.block_bytes;
+                if(s) memcpy(row, s + (size_t)r * qw * atlas.block_bytes, (size_t)qw * atlas.block_bytes);
+                else for(uint32_t b = 0; b < qw; b++) memcpy(row + (size_t)b * atlas.block_bytes, &flat[0], atlas.block_bytes);
+            }
+        }
+    }
+    return true;
+}
+
+//Texture index used by each group (1-based, 0 = none): a group without a
+//TEXTURE line keeps the previous group's, as in Orbiter's loader.
+static std::vector<int> GroupTextures(const Mesh &mesh){
+    std::vector<int> tex;
+    int cur = 0;
+    for(const Group &g : mesh.groups){
+        for(const std::string &l : g.header) sscanf(l.c_str(), "TEXTURE %d", &cur);
+        tex.push_back(cur);
+    }
+    return tex;
+}
+
+//Texture changes when the groups are drawn in order.
+static int Binds(const std::vector<int> &tex){
+    int n = 0, cur = 0;
+    for(int t : tex){
+        if(t && t != cur) n++;
+        cur = t;
+    }
+    return n;
+}
+
+int main(int argc, char **argv){
+
+    if(argc < 7 || argc > 9){
+        fprintf(stderr, "usage: %s input.msh output.msh texdir atlas.dds tex1.dds tex2.dds [tex3.dds [tex4.dds]]\n", argv[0]);
+        return 2;
+    }
+    Mesh mesh;
+    if(!ReadMesh(argv[1], mesh)){
+        fprintf(stderr, "%s: not a readable MSHX1 mesh\n", argv[1]);
+        return 1;
+    }
+    std::string texdir = argv[3], atlasname = argv[4];
+    //Path of texdir under Textures/, for the entries of the TEXTURES list.
+    std::string prefix;
+    size_t tdir = texdir.rfind("Textures/");
+    if(tdir != std::string::npos) prefix = texdir.substr(tdir + 9) + "/";
+
+    //The TEXTURES list
+    size_t list = 0;
+    int ntex = -1;
+    for(size_t i = 0; i < mesh.tail.size() && ntex < 0; i++)
+        if(sscanf(mesh.tail[i].c_str(), "TEXTURES %d", &ntex) == 1) list = i + 1;
+    if(ntex < 0 || list + ntex > mesh.tail.size()){
+        fprintf(stderr, "%s: no TEXTURES list\n", argv[1]);
+        return 1;
+    }
+    std::vector<std::string> names(mesh.tail.begin() + list, mesh.tail.begin() + list + ntex);
+
+    //Sources: index in the list, texture and normal map.
+    int nsrc = argc - 5;
+    std::vector<int> src_index(nsrc, 0);
+    std::vector<DdsTexture> tex(nsrc), norm(nsrc);
+    std::vector<const DdsTexture *> texp(nsrc), normp(nsrc, (const DdsTexture *)0);
+    bool any_norm = false;
+    char err[256];
+    for(int s = 0; s < nsrc; s++){
+        for(int i = 0; i < ntex; i++)
+            if(Basename(names[i]) == argv[5 + s]) src_index[s] = i + 1;
+        if(!src_index[s]){
+            fprintf(stderr, "%s: %s is not one of the mesh textures\n", argv[1], argv[5 + s]);
+            return 1;
+        }
+        std::string path = texdir + "/" + argv[5 + s];
+        if(!DdsRead(path.c_str(), tex[s], err, sizeof(err))){
+            fprintf(stderr, "%s\n", err);
+            return 1;
+        }
+        if(tex[s].width != tex[0].width || tex[s].height != tex[0].height || tex[s].fourcc != tex[0].fourcc){
+            fprintf(stderr, "%s: size or format differs from %s\n", path.c_str(), argv[5]);
+            return 1;
+        }
+        texp[s] = &tex[s];
+        std::string npath = texdir + "/" + NormName(argv[5 + s]);
+        if(Exists(npath)){
+            if(!DdsRead(npath.c_str(), norm[s], err, sizeof(err))){
+                fprintf(stderr, "%s\n", err);
+                return 1;
+            }
+            normp[s] = &norm[s];
+            any_norm = true;
+        }
+    }
+
+    //Groups that use a source must stay inside 0..1.
+    std::vector<int> gtex = GroupTextures(mesh);
+    for(size_t g = 0; g < mesh.groups.size(); g++){
+        const Group &grp = mesh.groups[g];
+        for(int s = 0; s < nsrc; s++){
+            if(gtex[g] != src_index[s] || grp.nfield < 8) continue;
+            for(size_t v = 0; v < grp.vtx.size(); v += grp.nfield){
+                float u = grp.vtx[v + 6], w = grp.vtx[v + 7];
+                if(u < -1e-3f || u > 1.001f || w < -1e-3f || w > 1.001f){
+                    fprintf(stderr, "%s: group %d wraps %s (uv %.3f %.3f); cannot atlas it\n", argv[1], (int)g, argv[5 + s], u, w);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    //Atlas and normal map atlas.
+    DdsTexture atlas, natlas;
+    if(!Pack(texp, false, atlas)){
+        fprintf(stderr, "%s: textures too small to atlas\n", argv[5]);
+        return 1;
+    }
+    std::string atlaspath = texdir + "/" + atlasname;
+    if(!DdsWrite(atlaspath.c_str(), atlas, err, sizeof(err))){
+        fprintf(stderr, "%s\n", err);
+        return 1;
+    }
+    if(any_norm){
+        bool ok = true;
+        for(const DdsTexture *n : normp) ok = ok && (!n || (n->width == tex[0].width && n->height == tex[0].height && n->fourcc == tex[0].fourcc));
+        if(!ok || !Pack(normp, true, natlas) || !DdsWrite((texdir + "/" + NormName(atlasname)).c_str(), natlas, err, sizeof(err))){
+            fprintf(stderr, "%s: cannot build the normal map atlas\n", atlaspath.c_str());
+            return 1;
+        }
+    }
+
+    //Remap the texture coordinates into the quadrants.
+    float q = (float)(atlas.width >> 1), inset = 0.5f / q, span = 1.0f - 2.0f * inset;
+    for(size_t g = 0; g < mesh.groups.size(); g++){
+        Group &grp = mesh.groups[g];
+        for(int s = 0; s < nsrc; s++){
+            if(gtex[g] != src_index[s] || grp.nfield < 8) continue;
+            for(size_t v = 0; v < grp.vtx.size(); v += grp.nfield){
+                float &u = grp.vtx[v + 6], &w = grp.vtx[v + 7];
+                u = 0.5f * ((s % 2) + inset + span * std::min(std::max(u, 0.0f), 1.0f));
+                w = 0.5f * ((s / 2) + inset + span * std::min(std::max(w, 0.0f), 1.0f));
+            }
+        }
+    }
+
+    //New TEXTURES list: the atlas takes the place of the first source.
+    std::vector<int> remap(ntex + 1, 0);
+    std::vector<std::string> out;
+    int atlas_index = 0;
+    for(int i = 1; i <= ntex; i++){
+        bool packed = false;
+        for(int s = 0; s < nsrc; s++) packed = packed || src_index[s] == i;
+        if(packed){
+            if(!atlas_index){
+                out.push_back(prefix + atlasname);
+                atlas_index = (int)out.size();
+            }
+            remap[i] = atlas_index;
+            continue;
+        }
+        std::string name = names[i - 1];
+        if(!Exists("Textures/" + name)){
+            if(Exists(texdir + "/" + name)) name = prefix + name;
+            else fprintf(stderr, "warning: texture %s not found\n", name.c_str());
+        }
+        out.push_back(name);
+        remap[i] = (int)out.size();
+    }
+    for(Group &grp : mesh.groups)
+        for(std::string &l : grp.header){
+            int t;
+            if(sscanf(l.c_str(), "TEXTURE %d", &t) == 1 && t >= 0 && t <= ntex) l = "TEXTURE " + std::to_string(remap[t]);
+        }
+    mesh.tail.erase(mesh.tail.begin() + list, mesh.tail.begin() + list + ntex);
+    mesh.tail[list - 1] = "TEXTURES " + std::to_string(out.size());
+    mesh.tail.insert(mesh.tail.begin() + list, out.begin(), out.end());
+
+    if(!WriteMesh(argv[2], mesh)){
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+
+    //Report
+    long before = 0, after = FileSize(atlaspath) + (any_norm ? FileSize(texdir + "/" + NormName(atlasname)) : 0);
+    for(int s = 0; s < nsrc; s++)
+        before += FileSize(texdir + "/" + argv[5 + s]) + FileSize(texdir + "/" + NormName(argv[5 + s]));
+    printf("%s: %d textures -> %s: %d textures\n", argv[1], ntex, argv[2], (int)out.size());
+    printf("packed %d textures into %s (%ux%u, %u levels): %ld -> %ld bytes with normal maps\n",
+        nsrc, atlaspath.c_str(), atlas.width, atlas.height, atlas.mips, before, after);
+    printf("texture changes in group order: %d -> %d\n", Binds(gtex), Binds(GroupTextures(mesh)));
+    return 0;
+}
@@ -0,0 +1,110 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          XB-70 MESH TOOLS
+//
+//xb70_textail.cpp
+//Writes the mip tails the module streams in place of the full textures: for
+//every entry of a mesh's TEXTURES list that is found under Textures/, the
+//levels of at most TAIL_SIZE pixels go to <name>_tail.dds, and those of its
+//normal map (<name>_norm.dds), if it has one, to <name>_tail_norm.dds.
+//Textures that are not found (Orbiter's own) are skipped. Run it from the
+//Orbiter root after changing a texture; the tails are shipped with the
+//textures and the module never writes them. With --check nothing is
+//written; the tool fails if a shipped tail differs from what its texture
+//gives.
+//
+//Usage: xb70_textail input.msh [--check]
+//
+//==========================================
+
+#include "MshText.h"
+#include "XB70Dds.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+//Longest side of a tail [px]; TEX_TAIL_SIZE in XB70MeshCache.h.
+static const uint32_t TAIL_SIZE = 256;
+
+static bool Exists(const std::string &path){
+    struct stat st;
+    return !stat(path.c_str(), &st);
+}
+
+static bool ReadFile(const std::string &path, std::string &data){
+    FILE *f = fopen(path.c_str(), "rb");
+    if(!f) return false;
+    char buf[65536];
+    size_t n;
+    data.clear();
+    while((n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+//Path of a texture under Textures/ with suffix added before ".dds".
+static std::string TexturePath(const std::string &name, const char *suffix){
+    std::string base = name;
+    if(base.size() > 4 && !strcasecmp(base.c_str() + base.size() - 4, ".dds")) base.erase(base.size() - 4);
+    return "Textures/" + base + suffix + ".dds";
+}
+
+//Writes (or with check, compares) the tail of src at dst.
+static bool Tail(const std::string &src, const std::string &dst, bool check){
+    char err[256];
+    std::string out = check ? dst + ".check" : dst;
+    if(!DdsWriteTail(src.c_str(), out.c_str(), TAIL_SIZE, err, sizeof(err))){
+        fprintf(stderr, "%s\n", err);
+        return false;
+    }
+    if(!check){
+        printf("%s\n", dst.c_str());
+        return true;
+    }
+    std::string want, have;
+    bool same = ReadFile(out, want) && ReadFile(dst, have) && want == have;
+    unlink(out.c_str());
+    if(!same) fprintf(stderr, "%s is missing or out of date with %s\n", dst.c_str(), src.c_str());
+    return same;
+}
+
+int main(int argc, char **argv){
+
+    if(argc < 2){
+        fprintf(stderr, "usage: %s input.msh [--check]\n", argv[0]);
+        return 2;
+    }
+    bool check = argc > 2 && !strcmp(argv[2], "--check");
+
+    Mesh mesh;
+    if(!ReadMesh(argv[1], mesh)){
+        fprintf(stderr, "%s: not a MSHX1 mesh\n", argv[1]);
+        return 1;
+    }
+    std::vector<std::string> names;
+    for(size_t i = 0; i < mesh.tail.size(); i++){
+        int n = 0;
+        if(sscanf(mesh.tail[i].c_str(), "TEXTURES %d", &n) != 1) continue;
+        for(int k = 0; k < n && i + 1 + k < mesh.tail.size(); k++){
+            char name[256];
+            if(sscanf(mesh.tail[i + 1 + k].c_str(), "%255s", name) == 1) names.push_back(name);
+        }
+    }
+
+    bool ok = true;
+    for(const std::string &name : names){
+        std::string src = TexturePath(name, "");
+        if(!Exists(src)) continue;
+        ok = Tail(src, TexturePath(name, "_tail"), check) && ok;
+        std::string norm = TexturePath(name, "_norm");
+        if(Exists(norm)) ok = Tail(norm, TexturePath(name, "_tail_norm"), check) && ok;
+    }
+    if(!ok && check) fprintf(stderr, "run %s %s\n", argv[0], argv[1]);
+    return ok ? 0 : 1;
+}
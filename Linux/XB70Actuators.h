@@ -0,0 +1,47 @@
+#ifndef __XB70ACTUATORS_H
+#define __XB70ACTUATORS_H
+
+//Two-position actuators (landing gear, doors, nose cone, ...).
+//
+//Every moving part is a position in [0,1] driven at a constant rate towards
+//one of its ends. The status values keep the layout the scenario files
+//already use for GEAR and DOOR:
+//0 = at position 0, 1 = at position 1, 2 = moving to 0, 3 = moving to 1.
+//Parts with intermediate stops (wingtip droop) travel towards target; the
+//moving states then only give the direction, and a part resting short of 1
+//reports ACT_AT0.
+enum ActuatorStatus{ACT_AT0, ACT_AT1, ACT_TO0, ACT_TO1};
+
+//Static description of one actuator; the vessel class keeps one table entry
+//per moving part.
+struct ActuatorSpec{
+    double rate;                //Operating speed [1/s]
+    double threshold;           //Position change before the animation is updated
+};
+
+//Run-time state of one actuator. The vessel keeps these in one array.
+struct Actuator{
+    int status;
+    double proc;                //Position [0,1]
+    double shown;               //Position last passed to SetAnimation
+    double target;              //End position of the current travel
+    unsigned int anim;          //Animation handle
+};
+
+//Moves a travelling actuator by simdt. Returns true when it reached its end
+//position in this step (the status is then ACT_AT0 or ACT_AT1).
+inline bool StepActuator(Actuator &a, const ActuatorSpec &spec, double simdt){
+    double da = simdt * spec.rate;
+    if(a.status == ACT_TO0){
+        a.proc -= da;
+        if(a.proc > a.target) return false;
+    } else {
+        a.proc += da;
+        if(a.proc < a.target) return false;
+    }
+    a.proc = a.target;
+    a.status = a.proc >= 1.0 ? ACT_AT1 : ACT_AT0;
+    return true;
+}
+
+#endif //!__XB70ACTUATORS_H
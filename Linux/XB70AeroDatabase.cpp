@@ -0,0 +1,194 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70AeroDatabase.cpp
+//Loading and multilinear lookup of the Mach/Re coefficient database
+//
+//==========================================
+
+#include "OrbiterAPI.h"
+#include "XB70AeroDatabase.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+void AeroDatabase::Axis::Finish(){
+    int n = (int)x.size();
+    inv_dx.assign(n > 1 ? n - 1 : 1, 0.0);
+    for(int i = 0; i + 1 < n; i++)
+        inv_dx[i] = 1.0 / (x[i + 1] - x[i]);
+    step_cell.clear();
+    if(n < 2) return;
+
+    //Largest step that divides every breakpoint interval (floating-point gcd).
+    double range = x[n - 1] - x[0];
+    double tol = range * 1e-9;
+    double g = 0.0;
+    for(int i = 1; i < n; i++){
+        double a = std::max(g, x[i] - x[i - 1]);
+        double b = std::min(g, x[i] - x[i - 1]);
+        while(b > tol){
+            double r = std::fmod(a, b);
+            if(b - r < tol) r = 0.0;
+            a = b;
+            b = r;
+        }
+        g = a;
+    }
+    if(!(g > 0.0) || range / g > AERODB_MAXSTEPS + 0.5) return;
+
+    int nstep = (int)(range / g + 0.5);
+    inv_step = nstep / range;
+    last_step = nstep - 1;
+    step_cell.resize(nstep);
+    for(int k = 0; k < nstep; k++){
+        double mid = x[0] + (k + 0.5) * range / nstep;
+        int i = (int)(std::upper_bound(x.begin(), x.end(), mid) - x.begin()) - 1;
+        i = std::max(0, std::min(i, n - 2));
+        step_cell[k] = {x[i], inv_dx[i], i};
+    }
+}
+
+inline int AeroDatabase::Axis::Bracket(double v, double &f) const{
+    if(step_cell.empty()) return Bisect(v, f);
+    double u = (v - x[0]) * inv_step;
+    const StepCell &s = step_cell[(int)(u > 0.0 ? (u < last_step ? u : last_step) : 0.0)];
+    f = std::max(0.0, std::min(1.0, (v - s.x) * s.inv_dx));
+    return s.cell;
+}
+
+int AeroDatabase::Axis::Bisect(double v, double &f) const{
+    int n = (int)x.size();
+    if(n < 2){
+        f = 0.0;
+        return 0;
+    }
+    int i = (int)(std::upper_bound(x.begin(), x.end(), v) - x.begin()) - 1;
+    i = std::max(0, std::min(i, n - 2));
+    f = std::max(0.0, std::min(1.0, (v - x[i]) * inv_dx[i]));
+    return i;
+}
+
+AeroDatabase *AeroDatabase::Load(const char *path){
+
+    FILE *f = fopen(path, "r");
+    if(!f) return 0;
+
+    AeroDatabase *db = new AeroDatabase;
+    char line[1024];
+    bool indata = false, ok = true;
+    size_t nnode = 1;
+
+    while(ok && fgets(line, sizeof(line), f)){
+        //A row longer than the buffer would be read as two.
+        if(!strchr(line, '\n') && !feof(f)){
+            ok = false;
+            break;
+        }
+        char *c = strchr(line, ';');
+        if(c) *c = '\0';
+        char *s = line;
+        while(*s == ' ' || *s == '\t') s++;
+        if(!*s || *s == '\n' || *s == '\r') continue;
+
+        if(indata){
+            char *e;
+            for(;;){
+                double v = strtod(s, &e);
+                if(e == s) break;
+                db->data.push_back(v);
+                s = e;
+            }
+        } else if(!strncasecmp(s, "DATA", 4)){
+            indata = true;
+        } else {
+            int ax;
+            if(!strncasecmp(s, "AOA", 3)) ax = AXIS_AOA, s += 3;
+            else if(!strncasecmp(s, "MACH", 4)) ax = AXIS_MACH, s += 4;
+            else if(!strncasecmp(s, "RE", 2)) ax = AXIS_RE, s += 2;
+            else {ok = false; break;}
+            char *e;
+            for(;;){
+                double v = strtod(s, &e);
+                if(e == s) break;
+                db->axis[ax].x.push_back(ax == AXIS_AOA ? v * RAD : v);
+                s = e;
+            }
+        }
+    }
+    fclose(f);
+
+    db->naxis = db->axis[AXIS_RE].x.empty() ? 2 : 3;
+    for(int a = 0; a < db->naxis; a++){
+        Axis &axis = db->axis[a];
+        //Breakpoints must be strictly increasing: a repeated one would give
+        //a cell of zero width.
+        if(axis.x.empty() || std::adjacent_find(axis.x.begin(), axis.x.end(), std::greater_equal<double>()) != axis.x.end()){
+            ok = false;
+            break;
+        }
+        axis.stride = (int)nnode;
+        nnode *= axis.x.size();
+        axis.Finish();
+    }
+    if(!ok || !indata || db->data.size() != nnode * NCOEFF){
+        oapiWriteLogV("XB70: malformed aerodynamic database %s", path);
+        delete db;
+        return 0;
+    }
+    return db;
+}
+
+void AeroDatabase::Lookup(double aoa, double M, double Re, double *c) const{
+
+    double f[3];
+    int ia = axis[AXIS_AOA].Bracket(aoa, f[AXIS_AOA]);
+    int im = axis[AXIS_MACH].Bracket(M, f[AXIS_MACH]);
+
+    //AoA x Mach: the four corners of the cell, unrolled.
+    if(naxis == 2){
+        int da = axis[AXIS_AOA].x.size() > 1 ? NCOEFF : 0;
+        int dm = axis[AXIS_MACH].x.size() > 1 ? axis[AXIS_MACH].stride * NCOEFF : 0;
+        const double *d00 = &data[(ia + im * axis[AXIS_MACH].stride) * NCOEFF];
+        const double *d10 = d00 + da, *d01 = d00 + dm, *d11 = d01 + da;
+        double fa = f[AXIS_AOA], fm = f[AXIS_MACH];
+        for(int k = 0; k < NCOEFF; k++){
+            double lo = d00[k] + (d10[k] - d00[k]) * fa;
+            double hi = d01[k] + (d11[k] - d01[k]) * fa;
+            c[k] = lo + (hi - lo) * fm;
+        }
+        return;
+    }
+
+    int lo[3], hi[3];
+    int cell[3] = {ia, im, axis[AXIS_RE].Bracket(Re, f[AXIS_RE])};
+    for(int a = 0; a < naxis; a++){
+        lo[a] = cell[a] * axis[a].stride;
+        hi[a] = (axis[a].x.size() > 1 ? cell[a] + 1 : cell[a]) * axis[a].stride;
+    }
+
+    for(int k = 0; k < NCOEFF; k++) c[k] = 0.0;
+
+    //Sum over the 2^naxis corners of the enclosing cell.
+    for(int corner = 0; corner < (1 << naxis); corner++){
+        double w = 1.0;
+        int node = 0;
+        for(int a = 0; a < naxis; a++){
+            if(corner & (1 << a)){
+                w *= f[a];
+                node += hi[a];
+            } else {
+                w *= 1.0 - f[a];
+                node += lo[a];
+            }
+        }
+        const double *d = &data[node * NCOEFF];
+        for(int k = 0; k < NCOEFF; k++) c[k] += w * d[k];
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef __XB70AERODATABASE_H
+#define __XB70AERODATABASE_H
+
+#include <vector>
+
+//Mach- and Reynolds-dependent aerodynamic coefficient database.
+//
+//CL, CM and CD (profile + wave drag; induced drag is added by the airfoil
+//callback) are tabulated on a rectilinear grid of AoA x Mach, with an
+//optional third Reynolds number axis, and evaluated by multilinear
+//interpolation. Grid nodes are stored in one contiguous array with AoA
+//varying fastest and the three coefficients interleaved per node, so a
+//lookup touches 2 (or 4 with Re) short runs of memory.
+//
+//The bracket search is a table lookup: each axis divides its range into
+//uniform steps that put every breakpoint on a step boundary (the
+//floating-point gcd of the spacing, as in XB70AeroTables.h) and keeps the
+//breakpoint cell of every step. A lookup is then one scale and one index per
+//axis, with no search and no state, so any number of vessels and threads can
+//share a database. An axis whose spacing needs more than AERODB_MAXSTEPS
+//steps (typically a logarithmic Reynolds axis) is searched by bisection.
+//Outside the breakpoints the values are held, not extrapolated.
+//
+//Databases are handed to the airfoils through XB70Aero.
+//
+//Data file format (';' starts a comment):
+//
+//    AOA  -180 -60 ... 180      breakpoints in degrees, strictly ascending
+//    MACH 0 0.6 ... 3.5         breakpoints, strictly ascending
+//    RE   1e6 1e8 ...           optional
+//    DATA
+//    cl cm cd                   one row per node, AoA fastest, then Mach, then Re
+//
+//Lines are at most 1022 characters long.
+
+//Largest uniform step index per axis [steps].
+const int AERODB_MAXSTEPS = 4096;
+
+class AeroDatabase{
+    public:
+        enum Coeff{CL, CM, CD, NCOEFF};
+
+        //Returns 0 if the file is missing or malformed.
+        static AeroDatabase *Load(const char *path);
+
+        void Lookup(double aoa, double M, double Re, double *c) const;
+
+        bool HasReynoldsAxis() const {return naxis > 2;}
+
+    private:
+        struct Axis{
+            std::vector<double> x;
+            std::vector<double> inv_dx;     //1/(x[i+1]-x[i]) per cell
+            //Cell of each uniform step with its lower breakpoint and 1/width,
+            //so a bracket is one load; empty: bisection
+            struct StepCell{
+                double x;
+                double inv_dx;
+                int cell;
+            };
+            std::vector<StepCell> step_cell;
+            double inv_step = 0.0;
+            double last_step = 0.0;         //Index of the last step
+            int stride = 0;                 //Node stride in the data array
+
+            void Finish();
+            //Cell index and clamped fraction in the cell.
+            inline int Bracket(double v, double &f) const;
+            int Bisect(double v, double &f) const;
+        };
+
+        enum {AXIS_AOA, AXIS_MACH, AXIS_RE};
+
+        Axis axis[3];
+        int naxis = 0;
+        std::vector<double> data;
+};
+
+#endif //!__XB70AERODATABASE_H
@@ -0,0 +1,24 @@
+#ifndef __XB70ANIMATIONS_H
+#define __XB70ANIMATIONS_H
+
+//Table-driven mesh animations.
+//
+//Every animation component (one rotation of a few mesh groups over part of
+//an animation's range) is a row of a static table. The vessel copies the
+//rows into its own storage when it defines its animations, so no transform
+//or group list is shared between instances.
+
+const int ANIM_MAXGRP = 3;      //Largest number of mesh groups in one component
+
+//Static description of one rotation component.
+struct AnimComponentSpec{
+    int anim;                   //Animation the component belongs to
+    double state0, state1;      //Part of the animation range it covers
+    UINT ngrp;
+    UINT grp[ANIM_MAXGRP];      //Mesh group indices
+    VECTOR3 ref;                //Rotation pivot
+    VECTOR3 axis;
+    float angle;                //Rotation at state1 [rad]
+};
+
+#endif //!__XB70ANIMATIONS_H
@@ -0,0 +1,101 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70Config.cpp
+//Vessel class parameters from the class config file
+//
+//==========================================
+
+#include "XB70Config.h"
+#include <cstddef>
+#include <cstdio>
+
+namespace{
+
+enum ItemType{ITEM_FLOAT, ITEM_VEC, ITEM_BOOL, ITEM_INT, ITEM_STRING};
+
+struct ConfigItem{
+    const char *key;
+    ItemType type;
+    size_t offset;              //Member of XB70Config
+    size_t size;                //Bytes of the member, ITEM_STRING only
+};
+
+//Config file keys. Adding a parameter is a member in XB70Config and one row
+//here. Keys the Orbiter core reads itself (MaxFuel, MaxMainThrust, ...) are
+//avoided, so the core does not build a second propellant resource or
+//thruster from them.
+const ConfigItem config_items[] = {
+    {"Size",                    ITEM_FLOAT, offsetof(XB70Config, size)},
+    {"EmptyMass",               ITEM_FLOAT, offsetof(XB70Config, empty_mass)},
+    {"FuelMass",                ITEM_FLOAT, offsetof(XB70Config, fuel_mass)},
+    {"CrossSections",           ITEM_VEC,   offsetof(XB70Config, cs)},
+    {"Inertia",                 ITEM_VEC,   offsetof(XB70Config, pmi)},
+    {"CGShift",                 ITEM_VEC,   offsetof(XB70Config, cg_shift)},
+    {"RotDrag",                 ITEM_VEC,   offsetof(XB70Config, rot_drag)},
+    {"WingEffectiveness",       ITEM_FLOAT, offsetof(XB70Config, wing_effectiveness)},
+    {"WheelbrakeForce",         ITEM_FLOAT, offsetof(XB70Config, wheelbrake_force)},
+
+    {"EngineIsp",               ITEM_FLOAT, offsetof(XB70Config, isp)},
+    {"DryThrust",               ITEM_FLOAT, offsetof(XB70Config, dry_thrust)},
+    {"AfterburnerThrust",       ITEM_FLOAT, offsetof(XB70Config, afterburner_thrust)},
+
+    {"GearOperatingSpeed",      ITEM_FLOAT, offsetof(XB70Config, gear_speed)},
+    {"DoorOperatingSpeed",      ITEM_FLOAT, offsetof(XB70Config, door_speed)},
+    {"NoseconeOperatingSpeed",  ITEM_FLOAT, offsetof(XB70Config, nosecone_speed)},
+    {"DroopOperatingSpeed",     ITEM_FLOAT, offsetof(XB70Config, droop_speed)},
+
+    {"VLiftChord",              ITEM_FLOAT, offsetof(XB70Config, vlift_chord)},
+    {"VLiftArea",               ITEM_FLOAT, offsetof(XB70Config, vlift_area)},
+    {"VLiftAspectRatio",        ITEM_FLOAT, offsetof(XB70Config, vlift_aspect)},
+    {"VLiftEfficiency",         ITEM_FLOAT, offsetof(XB70Config, vlift_efficiency)},
+    {"HLiftChord",              ITEM_FLOAT, offsetof(XB70Config, hlift_chord)},
+    {"HLiftArea",               ITEM_FLOAT, offsetof(XB70Config, hlift_area)},
+    {"HLiftAspectRatio",        ITEM_FLOAT, offsetof(XB70Config, hlift_aspect)},
+    {"HLiftEfficiency",         ITEM_FLOAT, offsetof(XB70Config, hlift_efficiency)},
+
+    {"AileronArea",             ITEM_FLOAT, offsetof(XB70Config, aileron_area)},
+    {"AileronDCl",              ITEM_FLOAT, offsetof(XB70Config, aileron_dcl)},
+    {"CanardArea",              ITEM_FLOAT, offsetof(XB70Config, canard_area)},
+    {"CanardDCl",               ITEM_FLOAT, offsetof(XB70Config, canard_dcl)},
+    {"ElevatorArea",            ITEM_FLOAT, offsetof(XB70Config, elevator_area)},
+    {"ElevatorDCl",             ITEM_FLOAT, offsetof(XB70Config, elevator_dcl)},
+    {"RudderArea",              ITEM_FLOAT, offsetof(XB70Config, rudder_area)},
+    {"RudderDCl",               ITEM_FLOAT, offsetof(XB70Config, rudder_dcl)},
+
+    {"TextureStreaming",        ITEM_BOOL,  offsetof(XB70Config, texture_streaming)},
+
+    {"FlightRecorder",          ITEM_BOOL,  offsetof(XB70Config, flight_recorder)},
+    {"RecorderChannels",        ITEM_STRING, offsetof(XB70Config, recorder_channels), sizeof(XB70Config::recorder_channels)},
+    {"RecorderDecimation",      ITEM_INT,   offsetof(XB70Config, recorder_decimation)},
+
+    {"CompactState",            ITEM_BOOL,  offsetof(XB70Config, compact_state)},
+};
+
+} //namespace
+
+int XB70Config::Read(FILEHANDLE cfg){
+    int found = 0;
+    //oapiReadItem_string takes no length: strings are read into a buffer
+    //that holds any config line, then cut to the member.
+    char line[1024];
+    for(const ConfigItem &item : config_items){
+        char *member = (char *)this + item.offset;
+        bool ok = false;
+        switch(item.type){
+            case ITEM_FLOAT: ok = oapiReadItem_float(cfg, (char *)item.key, *(double *)member); break;
+            case ITEM_VEC:   ok = oapiReadItem_vec(cfg, (char *)item.key, *(VECTOR3 *)member); break;
+            case ITEM_BOOL:  ok = oapiReadItem_bool(cfg, (char *)item.key, *(bool *)member); break;
+            case ITEM_INT:   ok = oapiReadItem_int(cfg, (char *)item.key, *(int *)member); break;
+            case ITEM_STRING:
+                ok = oapiReadItem_string(cfg, (char *)item.key, line);
+                if(ok) snprintf(member, item.size, "%s", line);
+                break;
+        }
+        if(ok) found++;
+    }
+    return found;
+}
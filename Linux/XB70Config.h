@@ -0,0 +1,67 @@
+#ifndef __XB70CONFIG_H
+#define __XB70CONFIG_H
+
+#include "OrbiterAPI.h"
+
+//Vessel class parameters.
+//
+//Every member can be set in the class config file
+//(Config/Vessels/XB-70_Valkyrie.cfg) under the key listed in XB70Config.cpp.
+//Items the file does not contain keep the defaults below, the values the
+//module was tuned with. The file is read once per class, by the first
+//clbkSetClassCaps, and all vessels share the result.
+
+struct XB70Config{
+    //Physical parameters
+    double size = 22.8;                         //Mean radius [m]
+    double empty_mass = 115031;                 //[kg]
+    double fuel_mass = 140000;                  //JP-6 capacity [kg]
+    VECTOR3 cs = {181.48, 642.24, 46.93};       //Cross sections [m^2]
+    VECTOR3 pmi = {245.53, 260.68, 46.93};      //Principal moments of inertia per unit mass [m^2]
+    VECTOR3 cg_shift = {0, -0.8294, 0};         //Centre of mass relative to the mesh origin [m]
+    VECTOR3 rot_drag = {5, 5, 2.5};             //Rotational drag coefficients
+    double wing_effectiveness = 2.5;
+    double wheelbrake_force = 25e5;             //[N]
+
+    //Engines (six YJ93s, one thruster each). Sea-level static ratings,
+    //scaled by the engine table (XB70Engine.h).
+    double isp = 2e4;                           //Fuel-specific impulse without the engine table [m/s]
+    double dry_thrust = 89e3;                   //Thrust without afterburner [N]
+    double afterburner_thrust = 30e4;           //Thrust with full reheat [N]
+
+    //Actuator operating speeds [1/s]
+    double gear_speed = 0.06;
+    double door_speed = 0.06;
+    double nosecone_speed = 0.06;
+    double droop_speed = 0.05;
+
+    //Airfoils: chord [m], reference area [m^2], aspect ratio and span
+    //efficiency (induced drag)
+    double vlift_chord = 23.94, vlift_area = 2 * 585.07, vlift_aspect = 1.751, vlift_efficiency = 0.7;
+    double hlift_chord = 2.79, hlift_area = 2 * 17.76, hlift_aspect = 1, hlift_efficiency = 0.6;
+
+    //Control surfaces: area of each surface [m^2] and lift gradient
+    double aileron_area = 18.37 / 2, aileron_dcl = 1.7;
+    double canard_area = 38.61, canard_dcl = 1.7;
+    double elevator_area = 36.74, elevator_dcl = 1.7;  //Elevator and elevator trim
+    double rudder_area = 17.76, rudder_dcl = 1.7;
+
+    //Mip tails only until the vessel is close to the camera (XB70MeshCache.h)
+    bool texture_streaming = true;
+
+    //Flight data recorder (XB70Recorder.h): channel names separated by
+    //spaces (empty: all channels; a longer list is cut at 255 characters)
+    //and simulation steps per record
+    bool flight_recorder = false;
+    char recorder_channels[256] = "";
+    int recorder_decimation = 1;
+
+    //Custom scenario state as one base64 XB70STATE line (XB70Scenario.h)
+    bool compact_state = false;
+
+    //Reads the items cfg contains over the current values. Returns the
+    //number of items found.
+    int Read(FILEHANDLE cfg);
+};
+
+#endif //!__XB70CONFIG_H
@@ -0,0 +1,138 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70Dds.cpp
+//Block-compressed DDS reading, writing and mip tail extraction
+//
+//==========================================
+
+#include "XB70Dds.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace{
+
+//DDSURFACEDESC2 fields, as byte offsets into the file (after "DDS ").
+const size_t DDS_FLAGS = 8, DDS_HEIGHT = 12, DDS_WIDTH = 16, DDS_LINEARSIZE = 20,
+    DDS_MIPCOUNT = 28, DDS_PF_FLAGS = 80, DDS_PF_FOURCC = 84, DDS_CAPS = 108;
+
+const uint32_t DDSD_MIPMAPCOUNT = 0x20000, DDPF_FOURCC = 0x4;
+const uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_MIPMAP = 0x400000;
+
+uint32_t Get32(const std::vector<char> &d, size_t at){
+    uint32_t v;
+    memcpy(&v, &d[at], 4);
+    return v;
+}
+
+void Set32(std::vector<char> &d, size_t at, uint32_t v){
+    memcpy(&d[at], &v, 4);
+}
+
+uint32_t FourCC(const char *s){
+    return (uint32_t)(unsigned char)s[0] | (uint32_t)(unsigned char)s[1] << 8 |
+        (uint32_t)(unsigned char)s[2] << 16 | (uint32_t)(unsigned char)s[3] << 24;
+}
+
+void SetError(char *err, size_t errlen, const char *fmt, ...){
+    if(!err || !errlen) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(err, errlen, fmt, ap);
+    va_end(ap);
+}
+
+} //namespace
+
+uint32_t DdsTexture::BlocksWide(uint32_t level) const{
+    uint32_t w = width >> level;
+    return w < 4 ? 1 : (w + 3) / 4;
+}
+
+uint32_t DdsTexture::BlocksHigh(uint32_t level) const{
+    uint32_t h = height >> level;
+    return h < 4 ? 1 : (h + 3) / 4;
+}
+
+size_t DdsTexture::LevelOffset(uint32_t level) const{
+    size_t at = DDS_HEADER_SIZE;
+    for(uint32_t l = 0; l < level; l++) at += LevelSize(l);
+    return at;
+}
+
+bool DdsRead(const char *path, DdsTexture &tex, char *err, size_t errlen){
+    FILE *f = fopen(path, "rb");
+    if(!f){
+        SetError(err, errlen, "cannot open %s", path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    tex.data.resize(size > 0 ? (size_t)size : 0);
+    bool ok = size >= (long)DDS_HEADER_SIZE && fread(&tex.data[0], 1, tex.data.size(), f) == tex.data.size();
+    fclose(f);
+    if(!ok || memcmp(&tex.data[0], "DDS ", 4) || Get32(tex.data, 4) != 124){
+        SetError(err, errlen, "%s: not a DDS file", path);
+        return false;
+    }
+    tex.width = Get32(tex.data, DDS_WIDTH);
+    tex.height = Get32(tex.data, DDS_HEIGHT);
+    tex.mips = (Get32(tex.data, DDS_FLAGS) & DDSD_MIPMAPCOUNT) ? Get32(tex.data, DDS_MIPCOUNT) : 1;
+    if(!tex.mips) tex.mips = 1;
+    tex.fourcc = Get32(tex.data, DDS_PF_FOURCC);
+    if(!(Get32(tex.data, DDS_PF_FLAGS) & DDPF_FOURCC) ||
+        (tex.fourcc != FourCC("DXT1") && tex.fourcc != FourCC("DXT3") && tex.fourcc != FourCC("DXT5"))){
+        SetError(err, errlen, "%s: not DXT1/DXT3/DXT5 compressed", path);
+        return false;
+    }
+    tex.block_bytes = tex.fourcc == FourCC("DXT1") ? 8 : 16;
+    if(!tex.width || !tex.height || tex.LevelOffset(tex.mips) > tex.data.size()){
+        SetError(err, errlen, "%s: truncated", path);
+        return false;
+    }
+    return true;
+}
+
+bool DdsWrite(const char *path, DdsTexture &tex, char *err, size_t errlen){
+    Set32(tex.data, DDS_WIDTH, tex.width);
+    Set32(tex.data, DDS_HEIGHT, tex.height);
+    Set32(tex.data, DDS_LINEARSIZE, (uint32_t)tex.LevelSize(0));
+    Set32(tex.data, DDS_MIPCOUNT, tex.mips);
+    uint32_t caps = Get32(tex.data, DDS_CAPS) & ~(DDSCAPS_COMPLEX | DDSCAPS_MIPMAP);
+    Set32(tex.data, DDS_CAPS, tex.mips > 1 ? caps | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : caps);
+    Set32(tex.data, DDS_FLAGS, Get32(tex.data, DDS_FLAGS) | DDSD_MIPMAPCOUNT);
+    tex.data.resize(tex.LevelOffset(tex.mips));
+
+    char tmppath[1024];
+    snprintf(tmppath, sizeof(tmppath), "%s.%d.tmp", path, (int)getpid());
+    FILE *f = fopen(tmppath, "wb");
+    bool ok = f && fwrite(&tex.data[0], 1, tex.data.size(), f) == tex.data.size();
+    ok = f && (fclose(f) == 0) && ok;
+    if(!ok || rename(tmppath, path)){
+        remove(tmppath);
+        SetError(err, errlen, "cannot write %s", path);
+        return false;
+    }
+    return true;
+}
+
+bool DdsWriteTail(const char *src, const char *dst, uint32_t maxsize, char *err, size_t errlen){
+    DdsTexture tex;
+    if(!DdsRead(src, tex, err, errlen)) return false;
+    uint32_t first = 0;
+    while(first + 1 < tex.mips && ((tex.width >> first) > maxsize || (tex.height >> first) > maxsize)) first++;
+    if(first){
+        size_t at = tex.LevelOffset(first);
+        tex.data.erase(tex.data.begin() + DDS_HEADER_SIZE, tex.data.begin() + at);
+        tex.width = tex.width >> first ? tex.width >> first : 1;
+        tex.height = tex.height >> first ? tex.height >> first : 1;
+        tex.mips -= first;
+    }
+    return DdsWrite(dst, tex, err, errlen);
+}
@@ -0,0 +1,42 @@
+#ifndef __XB70DDS_H
+#define __XB70DDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Block-compressed DDS textures (DXT1, DXT3, DXT5) as the texture tools and
+//the texture streaming see them: the header is kept verbatim and the mip
+//levels are located by offset, so levels can be cut off or copied block by
+//block without decoding.
+//
+//Like XB70MeshBin, this file does not depend on the Orbiter SDK.
+
+const size_t DDS_HEADER_SIZE = 128;         //"DDS " plus DDSURFACEDESC2
+
+struct DdsTexture{
+    std::vector<char> data;                 //Whole file
+    uint32_t width, height;
+    uint32_t mips;                          //Levels in the file
+    uint32_t fourcc;
+    uint32_t block_bytes;                   //8 for DXT1, 16 for DXT3/DXT5
+
+    //Blocks per row of a level, and its offset and size in data.
+    uint32_t BlocksWide(uint32_t level) const;
+    uint32_t BlocksHigh(uint32_t level) const;
+    size_t LevelOffset(uint32_t level) const;
+    size_t LevelSize(uint32_t level) const {return (size_t)BlocksWide(level) * BlocksHigh(level) * block_bytes;}
+};
+
+//Reads and validates a 2D block-compressed DDS file.
+bool DdsRead(const char *path, DdsTexture &tex, char *err = 0, size_t errlen = 0);
+
+//Writes tex with its header updated for its current size and level count.
+//Written to a temporary file and renamed into place, as the mesh cache is.
+bool DdsWrite(const char *path, DdsTexture &tex, char *err = 0, size_t errlen = 0);
+
+//Mip tail of src: the levels of at most maxsize pixels on the longer side.
+//A texture already that small is written unchanged.
+bool DdsWriteTail(const char *src, const char *dst, uint32_t maxsize, char *err = 0, size_t errlen = 0);
+
+#endif //!__XB70DDS_H
@@ -0,0 +1,134 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70Engine.cpp
+//J93 thrust and fuel consumption tables
+//
+//==========================================
+
+#include "OrbiterAPI.h"
+#include "XB70Engine.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+//lb/(lbf h) to kg/(N s)
+static const double SFC_SI = 1.0 / (3600.0 * 9.80665);
+
+//Cell of v in the breakpoints x, and the clamped fraction in the cell.
+static int Bracket(const std::vector<double> &x, double v, double &f){
+    int n = (int)x.size();
+    if(n < 2){
+        f = 0.0;
+        return 0;
+    }
+    int i = (int)(std::upper_bound(x.begin(), x.end(), v) - x.begin()) - 1;
+    i = std::max(0, std::min(i, n - 2));
+    f = std::max(0.0, std::min(1.0, (v - x[i]) / (x[i + 1] - x[i])));
+    return i;
+}
+
+EngineTable *EngineTable::Load(const char *path){
+
+    FILE *f = fopen(path, "r");
+    if(!f) return 0;
+
+    EngineTable *t = new EngineTable;
+    char line[1024];
+    bool indata = false, ok = true;
+
+    while(ok && fgets(line, sizeof(line), f)){
+        //A row longer than the buffer would be read as two.
+        if(!strchr(line, '\n') && !feof(f)){
+            ok = false;
+            break;
+        }
+        char *c = strchr(line, ';');
+        if(c) *c = '\0';
+        char *s = line;
+        while(*s == ' ' || *s == '\t') s++;
+        if(!*s || *s == '\n' || *s == '\r') continue;
+
+        std::vector<double> *dst;
+        if(indata) dst = &t->data;
+        else if(!strncasecmp(s, "DATA", 4)) {indata = true; continue;}
+        else if(!strncasecmp(s, "MACH", 4)) dst = &t->mach, s += 4;
+        else if(!strncasecmp(s, "ALT", 3)) dst = &t->alt, s += 3;
+        else {ok = false; break;}
+        char *e;
+        for(;;){
+            double v = strtod(s, &e);
+            if(e == s) break;
+            dst->push_back(v);
+            s = e;
+        }
+    }
+    fclose(f);
+
+    //Breakpoints must be strictly increasing: a repeated one would give a
+    //cell of zero width.
+    auto increasing = [](const std::vector<double> &x){
+        return !x.empty() && std::adjacent_find(x.begin(), x.end(), std::greater_equal<double>()) == x.end();
+    };
+    if(!ok || !indata || !increasing(t->mach) || !increasing(t->alt) ||
+        t->data.size() != t->mach.size() * t->alt.size() * NCOLUMN){
+        oapiWriteLogV("XB70: malformed engine table %s", path);
+        delete t;
+        return 0;
+    }
+    return t;
+}
+
+void EngineTable::Lookup(double M, double h, double *c) const{
+    double fm, fh;
+    int im = Bracket(mach, M, fm), ih = Bracket(alt, h, fh);
+    int nm = (int)mach.size();
+    int im1 = std::min(im + 1, nm - 1), ih1 = std::min(ih + 1, (int)alt.size() - 1);
+    const double *d00 = &data[(ih * nm + im) * NCOLUMN], *d01 = &data[(ih * nm + im1) * NCOLUMN];
+    const double *d10 = &data[(ih1 * nm + im) * NCOLUMN], *d11 = &data[(ih1 * nm + im1) * NCOLUMN];
+    for(int k = 0; k < NCOLUMN; k++){
+        double lo = d00[k] + (d01[k] - d00[k]) * fm;
+        double hi = d10[k] + (d11[k] - d10[k]) * fm;
+        c[k] = lo + (hi - lo) * fh;
+    }
+}
+
+void EngineState::Set(double dry, double reheat, double isp){
+    dry_thrust = dry;
+    reheat_thrust = reheat;
+    dry_flow = reheat_flow = 1.0 / isp;
+}
+
+void EngineState::Set(const EngineTable &table, double M, double alt, double dry, double reheat){
+    double c[EngineTable::NCOLUMN];
+    table.Lookup(M, alt, c);
+    dry_thrust = dry * c[EngineTable::DRY];
+    reheat_thrust = reheat * c[EngineTable::REHEAT];
+    dry_flow = c[EngineTable::SFC_DRY] * SFC_SI;
+    //The reheat SFC is for the whole thrust; the part above dry burns the rest.
+    double full_flow = reheat_thrust * c[EngineTable::SFC_REHEAT] * SFC_SI;
+    reheat_flow = reheat_thrust > dry_thrust ?
+        std::max(dry_flow, (full_flow - dry_thrust * dry_flow) / (reheat_thrust - dry_thrust)) : dry_flow;
+}
+
+double EngineState::Isp(double level) const{
+    double th = level * reheat_thrust;
+    double dry = std::min(th, dry_thrust);
+    double flow = dry * dry_flow + (th - dry) * reheat_flow;
+    return flow > 0.0 ? th / flow : 1.0 / dry_flow;
+}
+
+double DensityAltitude(double rho){
+    //US Standard Atmosphere 1976 up to 32 km: troposphere, isothermal layer
+    //from 11 km, then +1 K/km from 20 km.
+    const double rho11 = 0.36392, rho20 = 0.088910;
+    if(rho >= rho11) return 288.15 / 6.5e-3 * (1.0 - pow(rho / 1.225, 1.0 / 4.255876));
+    if(rho >= rho20) return 11000.0 - 6341.62 * log(rho / rho11);
+    return 20000.0 + 216.65 / 1e-3 * (pow(rho / rho20, -1.0 / 35.16319) - 1.0);
+}
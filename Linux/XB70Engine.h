@@ -0,0 +1,65 @@
+#ifndef __XB70ENGINE_H
+#define __XB70ENGINE_H
+
+#include <vector>
+
+//J93 engine performance.
+//
+//Each engine has a dry stage up to its dry thrust and a reheat stage from
+//there to its full afterburner thrust. Both ratings and the fuel consumption
+//of each stage depend on Mach number and density altitude; the engine table
+//gives them on a Mach x altitude grid, evaluated by bilinear interpolation
+//(clamped at the edges).
+//
+//The vessel evaluates the table at a reduced rate into an EngineState, and
+//turns the main throttle level into a thruster rating (the full reheat
+//thrust) and an effective Isp that burns the fuel of the dry and reheat
+//parts of the thrust.
+//
+//Data file format (';' starts a comment):
+//
+//    MACH 0 0.3 ... 3.5         breakpoints, strictly ascending
+//    ALT  0 3000 ... 30000      density altitude breakpoints [m], strictly ascending
+//    DATA
+//    dry reheat sfc_dry sfc_reheat    one row per node, Mach fastest
+//
+//Lines are at most 1022 characters long.
+//
+//dry and reheat are fractions of the sea-level static rating of the stage,
+//the SFCs are in lb/(lbf h) at full dry and full reheat thrust.
+
+class EngineTable{
+    public:
+        enum Column{DRY, REHEAT, SFC_DRY, SFC_REHEAT, NCOLUMN};
+
+        //Returns 0 if the file is missing or malformed.
+        static EngineTable *Load(const char *path);
+
+        void Lookup(double M, double alt, double *c) const;
+
+    private:
+        std::vector<double> mach, alt;
+        std::vector<double> data;
+};
+
+//Operating point of one engine.
+struct EngineState{
+    double dry_thrust;          //Full dry thrust [N]
+    double reheat_thrust;       //Full reheat thrust [N]
+    double dry_flow;            //Fuel flow per N of dry thrust [kg/(N s)]
+    double reheat_flow;         //Fuel flow per N of thrust above dry [kg/(N s)]
+
+    //Constant ratings and Isp, for a vessel without an engine table.
+    void Set(double dry, double reheat, double isp);
+
+    //Ratings for Mach M and density altitude alt from the table.
+    void Set(const EngineTable &table, double M, double alt, double dry, double reheat);
+
+    //Effective Isp [m/s] at main throttle level (of the reheat thrust).
+    double Isp(double level) const;
+};
+
+//Altitude [m] of the standard atmosphere with density rho [kg/m^3].
+double DensityAltitude(double rho);
+
+#endif //!__XB70ENGINE_H
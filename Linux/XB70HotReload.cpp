@@ -0,0 +1,66 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70HotReload.cpp
+//Change notification for the tables reloaded at run time
+//
+//==========================================
+
+#include "XB70HotReload.h"
+
+#ifdef __linux__
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+bool FileWatch::Watch(const char *dir){
+    Close();
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(fd < 0) return false;
+    if(inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0){
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void FileWatch::Close(){
+    if(fd >= 0) close(fd);
+    fd = -1;
+}
+
+bool FileWatch::Poll(std::vector<std::string> &names){
+    if(fd < 0) return false;
+    bool changed = false;
+    alignas(struct inotify_event) char buf[4096];
+    ssize_t n;
+    while((n = read(fd, buf, sizeof(buf))) > 0){
+        for(ssize_t at = 0; at < n; ){
+            const struct inotify_event *ev = (const struct inotify_event *)(buf + at);
+            if(ev->len && !(ev->mask & IN_ISDIR)){
+                names.push_back(ev->name);
+                changed = true;
+            }
+            at += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+    return changed;
+}
+
+#else
+
+bool FileWatch::Watch(const char *dir){
+    return false;
+}
+
+void FileWatch::Close(){
+}
+
+bool FileWatch::Poll(std::vector<std::string> &names){
+    return false;
+}
+
+#endif
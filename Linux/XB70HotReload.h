@@ -0,0 +1,62 @@
+#ifndef __XB70HOTRELOAD_H
+#define __XB70HOTRELOAD_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+//Tables replaced while the simulation runs.
+//
+//A TableSlot holds the current version of a table for its readers (the
+//airfoil callbacks), which fetch it with one atomic load and no lock.
+//Publish installs a new version with one atomic exchange and keeps the
+//version it replaced alive until the next Publish, so a reader that fetched
+//the old pointer just before the swap still finishes on valid data: the two
+//versions form a double buffer.
+template<class T>
+class TableSlot{
+    public:
+        TableSlot() : current(0), retired(0) {}
+        ~TableSlot() {Clear();}
+
+        const T *Get() const {return current.load(std::memory_order_acquire);}
+
+        //Takes ownership of t (0 leaves the slot empty).
+        void Publish(T *t){
+            T *old = current.exchange(t, std::memory_order_acq_rel);
+            delete retired;
+            retired = old;
+        }
+
+        void Clear() {Publish(0); Publish(0);}
+
+    private:
+        TableSlot(const TableSlot &) = delete;
+        TableSlot &operator= (const TableSlot &) = delete;
+
+        std::atomic<T *> current;
+        T *retired;                 //Previous version, freed by the next Publish
+};
+
+//Reports the files written in one directory, through inotify on Linux.
+//Elsewhere (or without inotify) Watch fails and Poll reports nothing, so
+//the tables are only read when the module is loaded.
+class FileWatch{
+    public:
+        FileWatch() : fd(-1) {}
+        ~FileWatch() {Close();}
+
+        bool Watch(const char *dir);
+        void Close();
+
+        //Appends the names (without the directory) of the files closed after
+        //writing, or renamed into the directory, since the last call. Editors
+        //and tools that save through a temporary file are seen at the rename.
+        //Never blocks; returns false if nothing changed.
+        bool Poll(std::vector<std::string> &names);
+
+    private:
+        int fd;
+};
+
+#endif //!__XB70HOTRELOAD_H
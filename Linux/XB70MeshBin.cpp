@@ -0,0 +1,567 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70MeshBin.cpp
+//MSHX1 to binary mesh cache conversion and memory-mapped access
+//
+//==========================================
+
+#include "XB70MeshBin.h"
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace{
+
+struct SrcGroup{
+    std::string label;
+    uint32_t material, texture, flags, zbias;
+    std::vector<float> vtx;         //8 floats per vertex
+    std::vector<uint16_t> idx;
+    std::vector<MeshBinQVertex> qvtx;   //Quantized copy of vtx, if requested
+    uint32_t src_nvtx;
+    float src_acmr;
+    float pos_offset[3], pos_scale[3];
+};
+
+void SetError(char *err, size_t errlen, const char *fmt, ...){
+    if(!err || !errlen) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(err, errlen, fmt, ap);
+    va_end(ap);
+}
+
+//Line reader over the whole file held in memory.
+class LineReader{
+    public:
+        explicit LineReader(std::vector<char> &buf) : p(&buf[0]), end(&buf[0] + buf.size() - 1), lineno(0) {}
+
+        //Next line, with trailing whitespace removed; 0 at end of file.
+        char *Next(){
+            if(p >= end) return 0;
+            char *line = p;
+            char *nl = (char *)memchr(p, '\n', end - p);
+            char *e = nl ? nl : end;
+            p = nl ? nl + 1 : end;
+            while(e > line && (e[-1] == '\r' || e[-1] == ' ' || e[-1] == '\t')) e--;
+            *e = '\0';
+            lineno++;
+            return line;
+        }
+
+        //Next non-empty line.
+        char *NextNonEmpty(){
+            char *line;
+            while((line = Next()) && !*line);
+            return line;
+        }
+
+        int Line() const {return lineno;}
+
+    private:
+        char *p, *end;
+        int lineno;
+};
+
+bool Keyword(const char *line, const char *kw, const char **rest){
+    size_t n = strlen(kw);
+    if(strncasecmp(line, kw, n) || (line[n] && line[n] != ' ' && line[n] != '\t')) return false;
+    *rest = line + n;
+    return true;
+}
+
+int ReadFloats(const char *s, float *v, int max){
+    int n = 0;
+    char *e;
+    while(n < max){
+        float f = strtof(s, &e);
+        if(e == s) break;
+        v[n++] = f;
+        s = e;
+    }
+    return n;
+}
+
+uint64_t Align16(uint64_t x){
+    return (x + 15) & ~(uint64_t)15;
+}
+
+//Fills grp.qvtx: positions on a 16-bit grid over the group's bounding box,
+//normals as signed normalized 16-bit values.
+void Quantize(SrcGroup &grp){
+    size_t nv = grp.vtx.size() / 8;
+    float lo[3] = {0, 0, 0}, hi[3] = {0, 0, 0};
+    for(size_t i = 0; i < nv; i++)
+        for(int k = 0; k < 3; k++){
+            float x = grp.vtx[i * 8 + k];
+            if(!i || x < lo[k]) lo[k] = x;
+            if(!i || x > hi[k]) hi[k] = x;
+        }
+    for(int k = 0; k < 3; k++){
+        grp.pos_scale[k] = (hi[k] - lo[k]) / 65535.0f;
+        grp.pos_offset[k] = lo[k] + 32768.0f * grp.pos_scale[k];
+    }
+    grp.qvtx.resize(nv);
+    for(size_t i = 0; i < nv; i++){
+        const float *v = &grp.vtx[i * 8];
+        MeshBinQVertex &q = grp.qvtx[i];
+        for(int k = 0; k < 3; k++){
+            long p = grp.pos_scale[k] > 0.0f ? lroundf((v[k] - lo[k]) / grp.pos_scale[k]) - 32768 : 0;
+            q.pos[k] = (int16_t)(p < -32768 ? -32768 : p > 32767 ? 32767 : p);
+            float n = v[3 + k] < -1.0f ? -1.0f : v[3 + k] > 1.0f ? 1.0f : v[3 + k];
+            q.nrm[k] = (int16_t)lroundf(n * 32767.0f);
+        }
+        q.tex[0] = v[6];
+        q.tex[1] = v[7];
+    }
+}
+
+//Merges vertices that are bit-for-bit equal in the stored format, so
+//quantizing also merges vertices that only differed below the grid step.
+void Weld(SrcGroup &grp){
+    bool quantized = !grp.qvtx.empty();
+    size_t nv = grp.vtx.size() / 8;
+    size_t vsize = quantized ? sizeof(MeshBinQVertex) : 8 * sizeof(float);
+    std::unordered_map<std::string, uint16_t> seen;
+    std::vector<uint16_t> remap(nv);
+    std::vector<float> vtx;
+    std::vector<MeshBinQVertex> qvtx;
+    for(size_t i = 0; i < nv; i++){
+        const char *v = quantized ? (const char *)&grp.qvtx[i] : (const char *)&grp.vtx[i * 8];
+        auto ins = seen.emplace(std::string(v, vsize), (uint16_t)(vtx.size() / 8));
+        if(ins.second){
+            vtx.insert(vtx.end(), &grp.vtx[i * 8], &grp.vtx[i * 8] + 8);
+            if(quantized) qvtx.push_back(grp.qvtx[i]);
+        }
+        remap[i] = ins.first->second;
+    }
+    for(uint16_t &i : grp.idx) i = remap[i];
+    grp.vtx.swap(vtx);
+    grp.qvtx.swap(qvtx);
+}
+
+//Vertex score for the triangle ordering: recently used vertices and those
+//with few triangles left rank highest.
+float VertexScore(int cachepos, int remaining){
+    if(!remaining) return -1.0f;
+    float s = 0.0f;
+    if(cachepos >= 0)
+        s = cachepos < 3 ? 0.75f : powf(1.0f - (cachepos - 3) / (float)(MESHBIN_CACHE - 3), 1.5f);
+    return s + 2.0f / sqrtf((float)remaining);
+}
+
+//Reorders the triangles for the post-transform vertex cache, after Forsyth's
+//linear-speed vertex cache optimisation: each step emits the best scoring
+//triangle among those touching the simulated cache, and only falls back to a
+//full scan when none is left.
+void OrderTriangles(std::vector<uint16_t> &idx, size_t nv){
+    size_t ntri = idx.size() / 3;
+    std::vector<int> remaining(nv, 0), start(nv + 1, 0);
+    for(uint16_t i : idx) remaining[i]++;
+    for(size_t v = 0; v < nv; v++) start[v + 1] = start[v] + remaining[v];
+    std::vector<int> tris(idx.size()), fill(start.begin(), start.end() - 1);
+    for(size_t i = 0; i < idx.size(); i++) tris[fill[idx[i]]++] = (int)(i / 3);
+
+    std::vector<int> cachepos(nv, -1);
+    std::vector<float> vscore(nv), tscore(ntri, 0.0f);
+    std::vector<char> done(ntri, 0);
+    for(size_t v = 0; v < nv; v++) vscore[v] = VertexScore(-1, remaining[v]);
+    for(size_t t = 0; t < ntri; t++)
+        tscore[t] = vscore[idx[t * 3]] + vscore[idx[t * 3 + 1]] + vscore[idx[t * 3 + 2]];
+
+    std::vector<uint16_t> out;
+    out.reserve(idx.size());
+    std::vector<int> cache, next;
+    int best = -1;
+    for(size_t n = 0; n < ntri; n++){
+        if(best < 0){
+            float top = -1e30f;
+            for(size_t t = 0; t < ntri; t++)
+                if(!done[t] && tscore[t] > top){
+                    top = tscore[t];
+                    best = (int)t;
+                }
+        }
+        int t = best;
+        done[t] = 1;
+
+        //Emit, and take the triangle off its vertices' lists.
+        next.clear();
+        for(int k = 0; k < 3; k++){
+            int v = idx[t * 3 + k];
+            out.push_back((uint16_t)v);
+            int *list = &tris[start[v]];
+            for(int j = 0; j < remaining[v]; j++)
+                if(list[j] == t){
+                    list[j] = list[remaining[v] - 1];
+                    break;
+                }
+            remaining[v]--;
+            bool dup = false;
+            for(int c : next) dup = dup || c == v;
+            if(!dup) next.push_back(v);
+        }
+
+        //Move its vertices to the front of the cache; rescore every vertex
+        //whose position changed, including those pushed out.
+        for(int c : cache){
+            bool dup = false;
+            for(size_t j = 0; j < 3 && j < next.size(); j++) dup = dup || next[j] == c;
+            if(!dup) next.push_back(c);
+        }
+        for(size_t j = 0; j < next.size(); j++){
+            int v = next[j];
+            cachepos[v] = j < (size_t)MESHBIN_CACHE ? (int)j : -1;
+            vscore[v] = VertexScore(cachepos[v], remaining[v]);
+        }
+        best = -1;
+        float top = -1e30f;
+        for(int v : next)
+            for(int j = 0; j < remaining[v]; j++){
+                int u = tris[start[v] + j];
+                tscore[u] = vscore[idx[u * 3]] + vscore[idx[u * 3 + 1]] + vscore[idx[u * 3 + 2]];
+                if(tscore[u] > top){
+                    top = tscore[u];
+                    best = u;
+                }
+            }
+        if(next.size() > (size_t)MESHBIN_CACHE) next.resize(MESHBIN_CACHE);
+        cache.swap(next);
+    }
+    idx.swap(out);
+}
+
+//Renumbers the vertices in the order the triangles first use them, dropping
+//any that no triangle uses.
+void OrderVertices(SrcGroup &grp){
+    bool quantized = !grp.qvtx.empty();
+    std::vector<int> remap(grp.vtx.size() / 8, -1);
+    std::vector<float> vtx;
+    std::vector<MeshBinQVertex> qvtx;
+    for(uint16_t &i : grp.idx){
+        if(remap[i] < 0){
+            remap[i] = (int)(vtx.size() / 8);
+            vtx.insert(vtx.end(), &grp.vtx[i * 8], &grp.vtx[i * 8] + 8);
+            if(quantized) qvtx.push_back(grp.qvtx[i]);
+        }
+        i = (uint16_t)remap[i];
+    }
+    grp.vtx.swap(vtx);
+    grp.qvtx.swap(qvtx);
+}
+
+} //namespace
+
+double MeshBinACMR(const uint16_t *idx, size_t nidx, int cache){
+    if(nidx < 3) return 0.0;
+    std::vector<uint16_t> fifo(cache);
+    std::vector<char> in(65536, 0);
+    size_t head = 0, filled = 0, misses = 0;
+    for(size_t i = 0; i < nidx; i++){
+        uint16_t v = idx[i];
+        if(in[v]) continue;
+        misses++;
+        if(filled == (size_t)cache) in[fifo[head]] = 0;
+        else filled++;
+        fifo[head] = v;
+        in[v] = 1;
+        head = (head + 1) % cache;
+    }
+    return (double)misses / (nidx / 3);
+}
+
+bool MeshBinBuild(const char *mshpath, const char *binpath, char *err, size_t errlen, uint32_t flags){
+
+    FILE *f = fopen(mshpath, "rb");
+    if(!f){
+        SetError(err, errlen, "cannot open %s", mshpath);
+        return false;
+    }
+    struct stat st;
+    fstat(fileno(f), &st);
+    std::vector<char> buf((size_t)st.st_size + 1);
+    size_t nread = fread(&buf[0], 1, (size_t)st.st_size, f);
+    fclose(f);
+    buf.resize(nread + 1);
+    buf[nread] = '\0';
+
+    LineReader rd(buf);
+    const char *rest;
+    char *line = rd.NextNonEmpty();
+    if(!line || strncmp(line, "MSHX1", 5)){
+        SetError(err, errlen, "%s: not a MSHX1 mesh", mshpath);
+        return false;
+    }
+    line = rd.NextNonEmpty();
+    int ngroup = 0;
+    if(!line || !Keyword(line, "GROUPS", &rest) || sscanf(rest, "%d", &ngroup) != 1 || ngroup < 0){
+        SetError(err, errlen, "%s:%d: GROUPS expected", mshpath, rd.Line());
+        return false;
+    }
+
+    //Groups. MATERIAL and TEXTURE carry over from the previous group when a
+    //group does not specify them, as in Orbiter's loader.
+    std::vector<SrcGroup> groups(ngroup);
+    uint32_t material = 0, texture = 0;
+    for(int g = 0; g < ngroup; g++){
+        SrcGroup &grp = groups[g];
+        grp.flags = grp.zbias = 0;
+        int nv = -1, nt = -1;
+        while(nv < 0 && (line = rd.NextNonEmpty())){
+            if(Keyword(line, "LABEL", &rest)){
+                while(*rest == ' ' || *rest == '\t') rest++;
+                grp.label = rest;
+            } else if(Keyword(line, "MATERIAL", &rest)){
+                material = (uint32_t)strtoul(rest, 0, 10);
+            } else if(Keyword(line, "TEXTURE", &rest)){
+                texture = (uint32_t)strtoul(rest, 0, 10);
+            } else if(Keyword(line, "FLAG", &rest)){
+                grp.flags = (uint32_t)strtoul(rest, 0, 0);
+            } else if(Keyword(line, "ZBIAS", &rest)){
+                grp.zbias = (uint32_t)strtoul(rest, 0, 10);
+            } else if(Keyword(line, "NONORMAL", &rest)){
+                SetError(err, errlen, "%s:%d: NONORMAL groups are not supported", mshpath, rd.Line());
+                return false;
+            } else if(Keyword(line, "GEOM", &rest)){
+                if(sscanf(rest, "%d%d", &nv, &nt) != 2 || nv < 0 || nt < 0 || nv > 65536){
+                    SetError(err, errlen, "%s:%d: bad GEOM", mshpath, rd.Line());
+                    return false;
+                }
+            }
+        }
+        if(nv < 0){
+            SetError(err, errlen, "%s: group %d has no GEOM", mshpath, g);
+            return false;
+        }
+        grp.material = material;
+        grp.texture = texture;
+        grp.vtx.assign((size_t)nv * 8, 0.0f);
+        for(int i = 0; i < nv; i++){
+            if(!(line = rd.Next()) || ReadFloats(line, &grp.vtx[i * 8], 8) < 6){
+                SetError(err, errlen, "%s:%d: bad vertex", mshpath, rd.Line());
+                return false;
+            }
+        }
+        grp.idx.resize((size_t)nt * 3);
+        for(int i = 0; i < nt; i++){
+            int a, b, c;
+            if(!(line = rd.Next()) || sscanf(line, "%d%d%d", &a, &b, &c) != 3 ||
+                a < 0 || b < 0 || c < 0 || a >= nv || b >= nv || c >= nv){
+                SetError(err, errlen, "%s:%d: bad triangle", mshpath, rd.Line());
+                return false;
+            }
+            grp.idx[i * 3] = (uint16_t)a;
+            grp.idx[i * 3 + 1] = (uint16_t)b;
+            grp.idx[i * 3 + 2] = (uint16_t)c;
+        }
+    }
+
+    //Materials and textures (both sections are optional).
+    std::vector<MeshBinMaterial> materials;
+    std::vector<std::string> textures;
+    while((line = rd.NextNonEmpty())){
+        int n = 0;
+        if(Keyword(line, "MATERIALS", &rest) && sscanf(rest, "%d", &n) == 1 && n >= 0){
+            materials.assign(n, MeshBinMaterial());
+            for(int i = 0; i < n; i++) rd.NextNonEmpty();     //Names, repeated below
+            for(int i = 0; i < n; i++){
+                MeshBinMaterial &m = materials[i];
+                memset(&m, 0, sizeof(m));
+                float spec[5] = {0, 0, 0, 0, 0};
+                bool ok = (line = rd.NextNonEmpty()) && Keyword(line, "MATERIAL", &rest);
+                ok = ok && (line = rd.Next()) && ReadFloats(line, m.diffuse, 4) == 4;
+                ok = ok && (line = rd.Next()) && ReadFloats(line, m.ambient, 4) == 4;
+                ok = ok && (line = rd.Next()) && ReadFloats(line, spec, 5) >= 4;
+                ok = ok && (line = rd.Next()) && ReadFloats(line, m.emissive, 4) == 4;
+                if(!ok){
+                    SetError(err, errlen, "%s:%d: bad material", mshpath, rd.Line());
+                    return false;
+                }
+                memcpy(m.specular, spec, sizeof(m.specular));
+                m.power = spec[4];
+            }
+        } else if(Keyword(line, "TEXTURES", &rest) && sscanf(rest, "%d", &n) == 1 && n >= 0){
+            for(int i = 0; i < n && (line = rd.NextNonEmpty()); i++){
+                char name[MESHBIN_NAMELEN];
+                if(sscanf(line, "%63s", name) != 1) name[0] = '\0';
+                textures.push_back(name);
+            }
+        }
+    }
+
+    //Compaction
+    bool quantize = (flags & MESHBIN_QUANTIZED) != 0;
+    for(SrcGroup &grp : groups){
+        grp.src_nvtx = (uint32_t)(grp.vtx.size() / 8);
+        grp.src_acmr = (float)MeshBinACMR(grp.idx.empty() ? 0 : &grp.idx[0], grp.idx.size());
+        for(int k = 0; k < 3; k++) grp.pos_offset[k] = grp.pos_scale[k] = 0.0f;
+        if(quantize) Quantize(grp);
+        Weld(grp);
+        OrderTriangles(grp.idx, grp.vtx.size() / 8);
+        OrderVertices(grp);
+    }
+
+    //Layout
+    size_t vsize = quantize ? sizeof(MeshBinQVertex) : 8 * sizeof(float);
+    MeshBinHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, MESHBIN_MAGIC, sizeof(hdr.magic));
+    hdr.version = MESHBIN_VERSION;
+    hdr.ngroup = (uint32_t)groups.size();
+    hdr.nmaterial = (uint32_t)materials.size();
+    hdr.ntexture = (uint32_t)textures.size();
+    hdr.flags = quantize ? MESHBIN_QUANTIZED : 0;
+    hdr.src_size = (uint64_t)st.st_size;
+    hdr.src_mtime = (int64_t)st.st_mtime;
+
+    std::vector<MeshBinGroup> gtab(groups.size());
+    uint64_t pos = sizeof(MeshBinHeader) + gtab.size() * sizeof(MeshBinGroup) +
+        materials.size() * sizeof(MeshBinMaterial) + textures.size() * MESHBIN_NAMELEN;
+    for(size_t g = 0; g < groups.size(); g++){
+        MeshBinGroup &bg = gtab[g];
+        memset(&bg, 0, sizeof(bg));
+        strncpy(bg.label, groups[g].label.c_str(), MESHBIN_NAMELEN - 1);
+        bg.nvtx = (uint32_t)(groups[g].vtx.size() / 8);
+        bg.nidx = (uint32_t)groups[g].idx.size();
+        bg.material = groups[g].material;
+        bg.texture = groups[g].texture;
+        bg.flags = groups[g].flags;
+        bg.zbias = groups[g].zbias;
+        bg.src_nvtx = groups[g].src_nvtx;
+        bg.src_acmr = groups[g].src_acmr;
+        memcpy(bg.pos_offset, groups[g].pos_offset, sizeof(bg.pos_offset));
+        memcpy(bg.pos_scale, groups[g].pos_scale, sizeof(bg.pos_scale));
+        pos = Align16(pos);
+        bg.vtx_offset = pos;
+        pos += (uint64_t)bg.nvtx * vsize;
+        pos = Align16(pos);
+        bg.idx_offset = pos;
+        pos += (uint64_t)bg.nidx * sizeof(uint16_t);
+    }
+    hdr.file_size = Align16(pos);
+
+    //Write to a temporary file, then rename into place.
+    char tmppath[1024];
+    snprintf(tmppath, sizeof(tmppath), "%s.%d.tmp", binpath, (int)getpid());
+    FILE *out = fopen(tmppath, "wb");
+    if(!out){
+        SetError(err, errlen, "cannot write %s", tmppath);
+        return false;
+    }
+    static const char zero[16] = {0};
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, out) == 1;
+    if(!gtab.empty()) ok = ok && fwrite(&gtab[0], sizeof(MeshBinGroup), gtab.size(), out) == gtab.size();
+    if(!materials.empty()) ok = ok && fwrite(&materials[0], sizeof(MeshBinMaterial), materials.size(), out) == materials.size();
+    for(size_t i = 0; i < textures.size(); i++){
+        char name[MESHBIN_NAMELEN];
+        memset(name, 0, sizeof(name));
+        strncpy(name, textures[i].c_str(), MESHBIN_NAMELEN - 1);
+        ok = ok && fwrite(name, MESHBIN_NAMELEN, 1, out) == 1;
+    }
+    for(size_t g = 0; g < groups.size() && ok; g++){
+        long at = ftell(out);
+        ok = fwrite(zero, 1, (size_t)(gtab[g].vtx_offset - at), out) == (size_t)(gtab[g].vtx_offset - at);
+        const void *vtx = quantize ? (const void *)groups[g].qvtx.data() : (const void *)groups[g].vtx.data();
+        if(gtab[g].nvtx) ok = ok && fwrite(vtx, vsize, gtab[g].nvtx, out) == gtab[g].nvtx;
+        at = ftell(out);
+        ok = ok && fwrite(zero, 1, (size_t)(gtab[g].idx_offset - at), out) == (size_t)(gtab[g].idx_offset - at);
+        if(gtab[g].nidx) ok = ok && fwrite(&groups[g].idx[0], sizeof(uint16_t), gtab[g].nidx, out) == gtab[g].nidx;
+    }
+    long at = ftell(out);
+    ok = ok && fwrite(zero, 1, (size_t)(hdr.file_size - at), out) == (size_t)(hdr.file_size - at);
+    ok = (fclose(out) == 0) && ok;
+    if(!ok || rename(tmppath, binpath)){
+        remove(tmppath);
+        SetError(err, errlen, "cannot write %s", binpath);
+        return false;
+    }
+    return true;
+}
+
+bool MeshBinFile::Open(const char *path, const char *mshpath){
+    Close();
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd, &st) || (size_t)st.st_size < sizeof(MeshBinHeader)){
+        close(fd);
+        return false;
+    }
+    void *p = mmap(0, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED) return false;
+    base = (char *)p;
+    size = (size_t)st.st_size;
+
+    //Header and table bounds
+    const MeshBinHeader &h = Header();
+    bool ok = !memcmp(h.magic, MESHBIN_MAGIC, sizeof(h.magic)) && h.version == MESHBIN_VERSION &&
+        (h.flags & ~MESHBIN_QUANTIZED) == 0 &&
+        h.file_size == size && h.ngroup <= 65536 && h.nmaterial <= 65536 && h.ntexture <= 65536 &&
+        sizeof(MeshBinHeader) + (uint64_t)h.ngroup * sizeof(MeshBinGroup) +
+        (uint64_t)h.nmaterial * sizeof(MeshBinMaterial) + (uint64_t)h.ntexture * MESHBIN_NAMELEN <= size;
+    for(uint32_t g = 0; ok && g < h.ngroup; g++){
+        const MeshBinGroup &grp = Group(g);
+        ok = grp.vtx_offset % 16 == 0 && grp.idx_offset % 16 == 0 &&
+            grp.vtx_offset + (uint64_t)grp.nvtx * VertexSize() <= size &&
+            grp.idx_offset + (uint64_t)grp.nidx * sizeof(uint16_t) <= size;
+        const uint16_t *idx = ok ? Indices(g) : 0;
+        for(uint32_t i = 0; ok && i < grp.nidx; i++) ok = idx[i] < grp.nvtx;
+    }
+
+    //Staleness against the source mesh
+    if(ok && mshpath){
+        struct stat src;
+        ok = !stat(mshpath, &src) && (uint64_t)src.st_size == h.src_size && (int64_t)src.st_mtime == h.src_mtime;
+    }
+    if(!ok) Close();
+    return ok;
+}
+
+void MeshBinFile::Close(){
+    if(base) munmap(base, size);
+    base = 0;
+    size = 0;
+}
+
+const MeshBinMaterial &MeshBinFile::Material(int i) const{
+    const char *p = base + sizeof(MeshBinHeader) + Header().ngroup * sizeof(MeshBinGroup);
+    return ((const MeshBinMaterial *)p)[i];
+}
+
+const char *MeshBinFile::Texture(int i) const{
+    const char *p = base + sizeof(MeshBinHeader) + Header().ngroup * sizeof(MeshBinGroup) +
+        Header().nmaterial * sizeof(MeshBinMaterial);
+    return p + (size_t)i * MESHBIN_NAMELEN;
+}
+
+void MeshBinFile::DecodeVertices(int i, float *out) const{
+    const MeshBinGroup &grp = Group(i);
+    if(!Quantized()){
+        memcpy(out, Vertices(i), (size_t)grp.nvtx * 8 * sizeof(float));
+        return;
+    }
+    const MeshBinQVertex *q = QVertices(i);
+    for(uint32_t v = 0; v < grp.nvtx; v++, out += 8){
+        for(int k = 0; k < 3; k++){
+            out[k] = grp.pos_offset[k] + q[v].pos[k] * grp.pos_scale[k];
+            out[3 + k] = q[v].nrm[k] / 32767.0f;
+        }
+        out[6] = q[v].tex[0];
+        out[7] = q[v].tex[1];
+    }
+}
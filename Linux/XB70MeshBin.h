@@ -0,0 +1,135 @@
+#ifndef __XB70MESHBIN_H
+#define __XB70MESHBIN_H
+
+#include <cstddef>
+#include <cstdint>
+
+//Binary mesh cache (.mshb).
+//
+//A pre-processed copy of an Orbiter MSHX1 text mesh, laid out so that the
+//vertex and index arrays can be handed to oapiCreateMesh straight from a
+//memory mapping: loading is an mmap plus a check of the header and indices,
+//with no parsing and no intermediate buffers (oapiCreateMesh still makes its
+//own copy). Vertices are stored in the NTVERTEX layout (x y z nx ny nz tu
+//tv, 32 bytes) and indices as 16-bit values, each group's arrays starting on
+//a 16-byte boundary.
+//
+//The converter compacts every group on the way: exact duplicate vertices are
+//merged, the triangles are reordered for the post-transform vertex cache and
+//the vertices renumbered in first-use order, so both arrays are read front to
+//back. With MESHBIN_QUANTIZED the vertices are stored as MeshBinQVertex
+//(20 bytes) instead, and have to be decoded before use.
+//
+//    MeshBinHeader
+//    MeshBinGroup[ngroup]
+//    MeshBinMaterial[nmaterial]
+//    char[MESHBIN_NAMELEN][ntexture]       texture file names
+//    vertex and index data
+//
+//The header records the size and modification time of the source .msh, so a
+//cache is rebuilt when the text mesh changes. Files are native-endian; the
+//version is bumped whenever the layout changes.
+//
+//This file and XB70MeshBin.cpp do not depend on the Orbiter SDK, so the
+//converter (Linux/Tools/xb70_meshbin.cpp) builds on its own.
+
+const char MESHBIN_MAGIC[4] = {'X', 'M', 'B', '1'};
+const uint32_t MESHBIN_VERSION = 2;
+const int MESHBIN_NAMELEN = 64;
+const uint32_t MESHBIN_QUANTIZED = 1;       //Header flag: vertices are MeshBinQVertex
+const int MESHBIN_CACHE = 16;               //Vertex cache size the triangle order is tuned for
+
+struct MeshBinHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t ngroup;
+    uint32_t nmaterial;
+    uint32_t ntexture;
+    uint32_t flags;                 //MESHBIN_QUANTIZED
+    uint64_t src_size;              //Size of the source .msh [bytes]
+    int64_t src_mtime;              //Modification time of the source .msh [s]
+    uint64_t file_size;             //Size of this file, for truncation checks
+};
+
+struct MeshBinGroup{
+    char label[MESHBIN_NAMELEN];
+    uint64_t vtx_offset;            //From the start of the file
+    uint64_t idx_offset;
+    uint32_t nvtx;
+    uint32_t nidx;
+    uint32_t material;              //As in the .msh: 1-based, 0 = none
+    uint32_t texture;               //As in the .msh: 1-based, 0 = none
+    uint32_t flags;                 //FLAG value
+    uint32_t zbias;
+    uint32_t src_nvtx;              //Vertex count in the .msh, before merging
+    float src_acmr;                 //Cache misses per triangle in the .msh order
+    float pos_offset[3];            //Quantized positions: p = offset + q*scale
+    float pos_scale[3];
+};
+
+//Quantized vertex: position on the group's bounding box grid, normal as
+//signed normalized 16-bit values, texture coordinates unchanged.
+struct MeshBinQVertex{
+    int16_t pos[3];
+    int16_t nrm[3];
+    float tex[2];
+};
+
+//Same layout as Orbiter's MATERIAL.
+struct MeshBinMaterial{
+    float diffuse[4];
+    float ambient[4];
+    float specular[4];
+    float emissive[4];
+    float power;
+};
+
+//Converts a MSHX1 text mesh into a .mshb file. The output is written to a
+//temporary file and renamed into place, so a concurrent reader never sees a
+//partial cache. flags is 0 or MESHBIN_QUANTIZED. On failure, err (if given)
+//receives a message.
+bool MeshBinBuild(const char *mshpath, const char *binpath, char *err = 0, size_t errlen = 0, uint32_t flags = 0);
+
+//Average cache misses per triangle (ACMR) of an index list drawn through a
+//FIFO post-transform cache of the given size: 3 with no reuse, about 0.5 to
+//0.7 for a well ordered closed mesh.
+double MeshBinACMR(const uint16_t *idx, size_t nidx, int cache = MESHBIN_CACHE);
+
+//Read-only view of a .mshb file through mmap. The mapping is private and
+//writable (copy-on-write), so a consumer that modifies a vertex array only
+//copies the pages it touches and never changes the file.
+class MeshBinFile{
+    public:
+        MeshBinFile() : base(0), size(0) {}
+        ~MeshBinFile() {Close();}
+
+        //Maps path and validates the header, all offsets and every index
+        //against its group's vertex count. If mshpath is
+        //given, the file is also rejected when it was not built from the
+        //current version of that mesh.
+        bool Open(const char *path, const char *mshpath = 0);
+        void Close();
+
+        const MeshBinHeader &Header() const {return *(const MeshBinHeader *)base;}
+        const MeshBinGroup &Group(int i) const {return ((const MeshBinGroup *)(base + sizeof(MeshBinHeader)))[i];}
+        const MeshBinMaterial &Material(int i) const;
+        const char *Texture(int i) const;
+        bool Quantized() const {return (Header().flags & MESHBIN_QUANTIZED) != 0;}
+        size_t VertexSize() const {return Quantized() ? sizeof(MeshBinQVertex) : 8 * sizeof(float);}
+        //NTVERTEX array of group i; only in a file that is not quantized.
+        float *Vertices(int i) const {return (float *)(base + Group(i).vtx_offset);}
+        const MeshBinQVertex *QVertices(int i) const {return (const MeshBinQVertex *)(base + Group(i).vtx_offset);}
+        uint16_t *Indices(int i) const {return (uint16_t *)(base + Group(i).idx_offset);}
+        //Writes group i's vertices to out in the NTVERTEX layout, in either format.
+        void DecodeVertices(int i, float *out) const;
+        size_t Size() const {return size;}
+
+    private:
+        MeshBinFile(const MeshBinFile &);
+        MeshBinFile &operator=(const MeshBinFile &);
+
+        char *base;
+        size_t size;
+};
+
+#endif //!__XB70MESHBIN_H
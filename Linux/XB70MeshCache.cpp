@@ -0,0 +1,251 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70MeshCache.cpp
+//Mesh loading from the memory-mapped binary mesh cache
+//
+//==========================================
+
+#include "XB70MeshCache.h"
+#include "XB70MeshBin.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+//Textures of the cached meshes, shared by name. The slots are reused, never
+//moved, so meshes can refer to them by index.
+struct CachedTexture{
+    std::string name;               //As in the mesh, relative to Textures/; empty if free
+    SURFHANDLE tail, full;
+    int refs;                       //Meshes using the texture
+    int full_refs;                  //AcquireFullTextures calls holding the full texture
+};
+
+static std::vector<CachedTexture> cached_textures;
+
+//Meshes created from the cache. oapiCreateMesh copies the group arrays, so
+//neither the mapping nor the vertices decoded from a quantized cache outlive
+//the creation.
+struct CachedMesh{
+    MESHHANDLE mesh;
+    std::vector<int> textures;      //Into cached_textures, by texture index - 1
+};
+
+static std::vector<CachedMesh> cached_meshes;
+
+//Templates handed out by AcquireSharedMesh, with their reference counts.
+struct SharedMesh{
+    char name[64];
+    MESHHANDLE mesh;
+    int refs;
+};
+
+static std::vector<SharedMesh> shared_meshes;
+
+//Path of a texture under Textures/ with suffix added before ".dds".
+static std::string TexturePath(const std::string &name, const char *suffix){
+    std::string base = name;
+    if(base.size() > 4 && !strcasecmp(base.c_str() + base.size() - 4, ".dds")) base.erase(base.size() - 4);
+    return "Textures/" + base + suffix + ".dds";
+}
+
+//Loads the mip tail of a texture, shipped next to it (with the tail of its
+//normal map, if it has one) by xb70_textail. The full texture is loaded
+//instead if a tail is missing; textures that are not under Textures/ (the
+//ones Orbiter provides) have none.
+static SURFHANDLE LoadTextureTail(const std::string &name){
+    struct stat st;
+    std::string tail = TexturePath(name, "_tail");
+    bool ok = !stat(tail.c_str(), &st);
+    if(ok && !stat(TexturePath(name, "_norm").c_str(), &st)) ok = !stat(TexturePath(name, "_tail_norm").c_str(), &st);
+    if(!ok){
+        if(!stat(TexturePath(name, "").c_str(), &st))
+            oapiWriteLogV("XB70: no mip tail for %s (run xb70_textail), loading the full texture", name.c_str());
+        return oapiLoadTexture(name.c_str());
+    }
+    //Back to a name under Textures/, as oapiLoadTexture wants it.
+    return oapiLoadTexture(tail.c_str() + 9);
+}
+
+static int AcquireTexture(const char *name){
+    int free = -1;
+    for(size_t i = 0; i < cached_textures.size(); i++){
+        if(cached_textures[i].name == name){
+            cached_textures[i].refs++;
+            return (int)i;
+        }
+        if(free < 0 && cached_textures[i].name.empty()) free = (int)i;
+    }
+    if(free < 0){
+        free = (int)cached_textures.size();
+        cached_textures.push_back(CachedTexture());
+    }
+    CachedTexture &t = cached_textures[free];
+    t.name = name;
+    t.tail = LoadTextureTail(t.name);
+    t.full = 0;
+    t.refs = 1;
+    t.full_refs = 0;
+    return free;
+}
+
+static void ReleaseTexture(int i){
+    CachedTexture &t = cached_textures[i];
+    if(--t.refs > 0) return;
+    oapiReleaseTexture(t.tail);
+    if(t.full) oapiReleaseTexture(t.full);
+    t.name.clear();
+    t.tail = t.full = 0;
+}
+
+static const CachedMesh *FindCachedMesh(MESHHANDLE mesh){
+    for(const CachedMesh &cm : cached_meshes)
+        if(cm.mesh == mesh) return &cm;
+    return 0;
+}
+
+//Creates the mesh from the file's arrays, which oapiCreateMesh copies.
+//Quantized vertices are first decoded into a temporary buffer; otherwise the
+//group descriptors point into the mapping.
+static MESHHANDLE CreateMeshFromFile(const MeshBinFile &file, std::vector<int> &textures){
+    const MeshBinHeader &h = file.Header();
+
+    std::vector<float> decoded;
+    std::vector<size_t> first(h.ngroup, 0);
+    if(file.Quantized()){
+        size_t n = 0;
+        for(uint32_t g = 0; g < h.ngroup; g++){
+            first[g] = n;
+            n += (size_t)file.Group(g).nvtx * 8;
+        }
+        decoded.resize(n);
+        for(uint32_t g = 0; g < h.ngroup; g++)
+            if(file.Group(g).nvtx) file.DecodeVertices(g, &decoded[first[g]]);
+    }
+
+    std::vector<MESHGROUP> grp(h.ngroup);
+    for(uint32_t g = 0; g < h.ngroup; g++){
+        const MeshBinGroup &bg = file.Group(g);
+        MESHGROUP &mg = grp[g];
+        mg.Vtx = (NTVERTEX *)(file.Quantized() ? decoded.data() + first[g] : file.Vertices(g));
+        mg.Idx = (WORD *)file.Indices(g);
+        mg.nVtx = bg.nvtx;
+        mg.nIdx = bg.nidx;
+        mg.MtrlIdx = bg.material;
+        mg.TexIdx = bg.texture;
+        mg.UsrFlag = bg.flags;
+        mg.zBias = (WORD)bg.zbias;
+        mg.Flags = 0;
+    }
+    MESHHANDLE mesh = oapiCreateMesh(h.ngroup, h.ngroup ? &grp[0] : 0);
+    if(!mesh) return 0;
+
+    for(uint32_t i = 0; i < h.nmaterial; i++)
+        oapiAddMaterial(mesh, (MATERIAL *)&file.Material(i));
+    for(uint32_t i = 0; i < h.ntexture; i++){
+        textures.push_back(AcquireTexture(file.Texture(i)));
+        oapiSetTexture(mesh, i + 1, cached_textures[textures.back()].tail);
+    }
+    return mesh;
+}
+
+MESHHANDLE LoadMeshCached(const char *name){
+    char mshpath[256], binpath[256];
+    snprintf(mshpath, sizeof(mshpath), "Meshes/%s.msh", name);
+    snprintf(binpath, sizeof(binpath), "Meshes/%s.mshb", name);
+
+    MeshBinFile file;
+    if(!file.Open(binpath, mshpath)){
+        char err[256] = "rejected after rebuild";
+        if(!MeshBinBuild(mshpath, binpath, err, sizeof(err)) || !file.Open(binpath, mshpath)){
+            oapiWriteLogV("XB70: mesh cache unavailable (%s), loading %s", err, mshpath);
+            return oapiLoadMesh(name);
+        }
+    }
+
+    CachedMesh cm = {0, std::vector<int>()};
+    cm.mesh = CreateMeshFromFile(file, cm.textures);
+    file.Close();
+    if(!cm.mesh) return oapiLoadMesh(name);
+    MESHHANDLE mesh = cm.mesh;
+    cached_meshes.push_back(cm);
+    return mesh;
+}
+
+void DeleteMeshCached(MESHHANDLE mesh){
+    oapiDeleteMesh(mesh);
+    for(size_t i = 0; i < cached_meshes.size(); i++){
+        if(cached_meshes[i].mesh == mesh){
+            for(int t : cached_meshes[i].textures) ReleaseTexture(t);
+            cached_meshes.erase(cached_meshes.begin() + i);
+            break;
+        }
+    }
+}
+
+MESHHANDLE AcquireSharedMesh(const char *name){
+    for(size_t i = 0; i < shared_meshes.size(); i++){
+        if(!strcmp(shared_meshes[i].name, name)){
+            shared_meshes[i].refs++;
+            return shared_meshes[i].mesh;
+        }
+    }
+    MESHHANDLE mesh = LoadMeshCached(name);
+    if(!mesh) return 0;
+    SharedMesh sm;
+    snprintf(sm.name, sizeof(sm.name), "%s", name);
+    sm.mesh = mesh;
+    sm.refs = 1;
+    shared_meshes.push_back(sm);
+    return mesh;
+}
+
+void ReleaseSharedMesh(MESHHANDLE mesh){
+    for(size_t i = 0; i < shared_meshes.size(); i++){
+        if(shared_meshes[i].mesh == mesh){
+            if(--shared_meshes[i].refs == 0){
+                DeleteMeshCached(mesh);
+                shared_meshes.erase(shared_meshes.begin() + i);
+            }
+            return;
+        }
+    }
+}
+
+DWORD MeshTextureCount(MESHHANDLE mesh){
+    const CachedMesh *cm = FindCachedMesh(mesh);
+    return cm ? (DWORD)cm->textures.size() : 0;
+}
+
+SURFHANDLE MeshTexture(MESHHANDLE mesh, DWORD idx, bool full){
+    const CachedMesh *cm = FindCachedMesh(mesh);
+    if(!cm || idx < 1 || idx > cm->textures.size()) return 0;
+    const CachedTexture &t = cached_textures[cm->textures[idx - 1]];
+    return full && t.full ? t.full : t.tail;
+}
+
+void AcquireFullTextures(MESHHANDLE mesh){
+    const CachedMesh *cm = FindCachedMesh(mesh);
+    if(!cm) return;
+    for(int i : cm->textures){
+        CachedTexture &t = cached_textures[i];
+        if(!t.full_refs++) t.full = oapiLoadTexture(t.name.c_str());
+    }
+}
+
+void ReleaseFullTextures(MESHHANDLE mesh){
+    const CachedMesh *cm = FindCachedMesh(mesh);
+    if(!cm) return;
+    for(int i : cm->textures){
+        CachedTexture &t = cached_textures[i];
+        if(t.full_refs > 0 && !--t.full_refs){
+            oapiReleaseTexture(t.full);
+            t.full = 0;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef __XB70MESHCACHE_H
+#define __XB70MESHCACHE_H
+
+#include "OrbiterAPI.h"
+
+//Mesh loading through the binary mesh cache (see XB70MeshBin.h).
+//
+//LoadMeshCached("XB-70_Valkyrie") maps Meshes/XB-70_Valkyrie.mshb and builds
+//the mesh with oapiCreateMesh from group descriptors that point into the
+//mapping (a cache written quantized by xb70_meshbin -q is decoded into a
+//temporary buffer instead). oapiCreateMesh copies the arrays, so the mapping
+//and the buffer are released right after. The cache is (re)built from
+//Meshes/XB-70_Valkyrie.msh when it is missing, stale or unreadable. If it cannot be written (read-only
+//installation) or mapped, the text mesh is loaded with oapiLoadMesh instead.
+
+MESHHANDLE LoadMeshCached(const char *name);
+
+//Deletes a mesh returned by LoadMeshCached and releases its textures.
+void DeleteMeshCached(MESHHANDLE mesh);
+
+//Mesh template shared by all vessels of the module. The first call loads it
+//through LoadMeshCached; later calls return the same handle and count a
+//reference. Orbiter builds each vessel's visual from the template, so the
+//instances only hold their own animation state.
+MESHHANDLE AcquireSharedMesh(const char *name);
+
+//Drops a reference taken by AcquireSharedMesh; the last one deletes the mesh.
+void ReleaseSharedMesh(MESHHANDLE mesh);
+
+//Texture streaming. A cached mesh is created with only the mip tail of its
+//textures, the levels of TEX_TAIL_SIZE pixels and below, which
+//Linux/Tools/xb70_textail writes next to each texture (and its normal map)
+//as <name>_tail.dds; the module only reads them. The first
+//AcquireFullTextures for a mesh loads its full textures, the last
+//ReleaseFullTextures frees them; in between, a vessel puts them on its own
+//visual with MeshTexture. Textures are shared between meshes by name.
+//
+//oapiLoadTexture has no asynchronous form, so AcquireFullTextures reads and
+//uploads the full textures on the simulation thread: the frame in which the
+//first XB-70 comes close stalls for the load (four 1.4 MB DXT files).
+const unsigned int TEX_TAIL_SIZE = 256;
+
+//Number of textures of a cached mesh (0 for a mesh loaded from the .msh).
+DWORD MeshTextureCount(MESHHANDLE mesh);
+
+//Texture idx (1-based, as in oapiSetTexture): the full one if requested and
+//held by AcquireFullTextures, the mip tail otherwise.
+SURFHANDLE MeshTexture(MESHHANDLE mesh, DWORD idx, bool full);
+
+void AcquireFullTextures(MESHHANDLE mesh);
+void ReleaseFullTextures(MESHHANDLE mesh);
+
+#endif //!__XB70MESHCACHE_H
@@ -0,0 +1,107 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70Profiler.cpp
+//Hot-path counters: debug string overlay and dump file
+//
+//==========================================
+
+#include "XB70Profiler.h"
+
+#ifdef XB70_PROFILE
+
+#include "OrbiterAPI.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+ProfileCounter profile_counters[NPROFILE];
+
+static const char *const profile_name[NPROFILE] = {
+    "clbkPostStep", "VLiftCoeff", "HLiftCoeff", "clbkLoadStateEx", "clbkSaveState", "clbkConsumeBufferedKey",
+};
+
+static const char *const profile_tag[NPROFILE] = {"Post", "VLift", "HLift", "Load", "Save", "Key"};
+
+//Ticks per nanosecond, measured against the steady clock since the module
+//was loaded.
+static const uint64_t profile_tick0 = ProfileTicks();
+static const std::chrono::steady_clock::time_point profile_clock0 = std::chrono::steady_clock::now();
+
+static double TicksPerNs(void){
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - profile_clock0).count();
+    return ns > 0.0 ? (ProfileTicks() - profile_tick0) / ns : 1.0;
+}
+
+static bool overlay_shown = false;
+static double overlay_simt = -1e10;
+static uint64_t overlay_tick;
+static ProfileCounter overlay_prev[NPROFILE];
+
+//One line: the share of wall time spent in the callbacks, then calls and
+//mean cycles of each over the last interval.
+void ProfileOverlay(double simt){
+    if(!overlay_shown || fabs(simt - overlay_simt) < PROFILE_OVERLAY_INTERVAL) return;
+    overlay_simt = simt;
+    uint64_t now = ProfileTicks(), busy = 0;
+    char calls[160];
+    int n = 0;
+    for(int i = 0; i < NPROFILE; i++){
+        const ProfileCounter &c = profile_counters[i];
+        uint64_t dn = c.calls - overlay_prev[i].calls, dt = c.cycles - overlay_prev[i].cycles;
+        busy += dt;
+        if(dn && n < (int)sizeof(calls))
+            n += snprintf(calls + n, sizeof(calls) - n, " %s %llux%.0f", profile_tag[i],
+                (unsigned long long)dn, (double)dt / dn);
+        overlay_prev[i] = c;
+    }
+    if(!n) calls[0] = '\0';
+    double share = now > overlay_tick ? 100.0 * busy / (now - overlay_tick) : 0.0;
+    snprintf(oapiDebugString(), 256, "XB70 %.2f%% |%s", share, calls);
+    overlay_tick = now;
+}
+
+void ToggleProfileOverlay(void){
+    overlay_shown = !overlay_shown;
+    overlay_simt = -1e10;
+    overlay_tick = ProfileTicks();
+    memcpy(overlay_prev, profile_counters, sizeof(overlay_prev));
+    if(!overlay_shown) oapiDebugString()[0] = '\0';
+}
+
+void ProfileDump(void){
+    FILE *f = fopen(PROFILE_DUMP_FILE, "w");
+    if(!f) return;
+#ifdef XB70_PROFILE_TSC
+    const char *unit = "TSC cycles";
+#else
+    const char *unit = "ns";
+#endif
+    double tpn = TicksPerNs();
+    fprintf(f, "XB70 module profile, in %s (%.3f per ns)\n\n", unit, tpn);
+    fprintf(f, "%-24s %12s %16s %10s %10s %10s\n", "callback", "calls", "total", "mean", "max", "mean ns");
+    for(int i = 0; i < NPROFILE; i++){
+        const ProfileCounter &c = profile_counters[i];
+        double mean = c.calls ? (double)c.cycles / c.calls : 0.0;
+        fprintf(f, "%-24s %12llu %16llu %10.0f %10llu %10.1f\n", profile_name[i], (unsigned long long)c.calls,
+            (unsigned long long)c.cycles, mean, (unsigned long long)c.max, mean / tpn);
+    }
+    fprintf(f, "\nHistograms (calls per duration range)\n");
+    for(int i = 0; i < NPROFILE; i++){
+        const ProfileCounter &c = profile_counters[i];
+        if(!c.calls) continue;
+        fprintf(f, "\n%s\n", profile_name[i]);
+        for(int k = 0; k < PROFILE_NBUCKET; k++){
+            if(!c.hist[k]) continue;
+            fprintf(f, "  %10llu - %-10llu %12u  %5.1f%%\n", k ? 1ull << k : 0ull, (2ull << k) - 1,
+                c.hist[k], 100.0 * c.hist[k] / c.calls);
+        }
+    }
+    fclose(f);
+}
+
+#endif //XB70_PROFILE
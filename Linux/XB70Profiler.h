@@ -0,0 +1,88 @@
+#ifndef __XB70PROFILER_H
+#define __XB70PROFILER_H
+
+//Hot-path instrumentation, compiled in with -DXB70_PROFILE.
+//
+//XB70_PROFILE_SCOPE(id) at the top of a callback counts the call and times
+//it in TSC cycles (steady clock nanoseconds where there is no TSC): total,
+//maximum and a histogram with one bucket per power of two. The counters are
+//module-wide, for all vessels, and only touched from the simulation thread.
+//Without XB70_PROFILE the macro expands to nothing and none of this is
+//built.
+//
+//ProfileOverlay shows the last second's figures in the debug string line;
+//ProfileDump writes the totals since the module was loaded, with the
+//histograms, to PROFILE_DUMP_FILE (every ovcExit).
+
+#ifdef XB70_PROFILE
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define XB70_PROFILE_TSC 1
+#else
+#include <chrono>
+#endif
+
+enum ProfileId{PROF_POSTSTEP, PROF_VLIFT, PROF_HLIFT, PROF_LOADSTATE, PROF_SAVESTATE, PROF_KEY, NPROFILE};
+
+//Histogram bucket k counts calls of 2^k to 2^(k+1)-1 cycles.
+const int PROFILE_NBUCKET = 32;
+
+const char PROFILE_DUMP_FILE[] = "XB70Profile.log";
+
+//Overlay refresh period [s of simulation time].
+const double PROFILE_OVERLAY_INTERVAL = 1.0;
+
+struct ProfileCounter{
+    uint64_t calls;
+    uint64_t cycles;
+    uint64_t max;
+    uint32_t hist[PROFILE_NBUCKET];
+};
+
+extern ProfileCounter profile_counters[NPROFILE];
+
+inline uint64_t ProfileTicks(){
+#ifdef XB70_PROFILE_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+class ProfileScope{
+    public:
+        explicit ProfileScope(ProfileId _id) : id(_id), t0(ProfileTicks()) {}
+        ~ProfileScope(){
+            uint64_t dt = ProfileTicks() - t0;
+            ProfileCounter &c = profile_counters[id];
+            c.calls++;
+            c.cycles += dt;
+            if(dt > c.max) c.max = dt;
+            int k = dt ? 63 - __builtin_clzll(dt) : 0;
+            c.hist[k < PROFILE_NBUCKET ? k : PROFILE_NBUCKET - 1]++;
+        }
+
+    private:
+        ProfileId id;
+        uint64_t t0;
+};
+
+//Refreshes the overlay every PROFILE_OVERLAY_INTERVAL while shown.
+void ProfileOverlay(double simt);
+void ToggleProfileOverlay(void);
+
+void ProfileDump(void);
+
+#define XB70_PROFILE_SCOPE(id) ProfileScope xb70_profile_scope(id)
+
+#else
+
+#define XB70_PROFILE_SCOPE(id)
+
+#endif //XB70_PROFILE
+
+#endif //!__XB70PROFILER_H
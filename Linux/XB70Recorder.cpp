@@ -0,0 +1,150 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70Recorder.cpp
+//Flight data recorder: lock-free ring drained to a memory-mapped file
+//
+//==========================================
+
+#include "XB70Recorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+Recorder::Recorder() : fd(-1), record_size(0), decimation(1), step(0), dropped(0),
+    head(0), tail(0), stopping(false), map(0), mapped(0), size(0), failed(false){
+}
+
+float *Recorder::Begin(double simt){
+    if(fd < 0) return 0;
+    bool sample = step == 0;
+    if(++step >= decimation) step = 0;
+    if(!sample) return 0;
+    uint64_t h = head.load(std::memory_order_relaxed);
+    if(h - tail.load(std::memory_order_acquire) >= RECORDER_RING){
+        dropped++;
+        return 0;
+    }
+    char *rec = Slot(h);
+    memcpy(rec, &simt, sizeof(simt));
+    return (float *)(rec + sizeof(simt));
+}
+
+void Recorder::Drain(){
+    for(;;){
+        //Everything committed before Close set stopping is seen below.
+        bool stop = stopping.load(std::memory_order_acquire);
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        for(; t < h; t++){
+            if(failed || !Reserve(record_size)) continue;
+            memcpy(map + size, Slot(t), record_size);
+            size += record_size;
+        }
+        tail.store(t, std::memory_order_release);
+        if(stop) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(RECORDER_DRAIN_MS));
+    }
+}
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool Recorder::Reserve(size_t n){
+    if(size + n <= mapped) return true;
+    //The old mapping stays valid (for Close) if the file cannot grow.
+    size_t grown = mapped + std::max(n, RECORDER_CHUNK);
+    void *m = MAP_FAILED;
+    if(ftruncate(fd, grown) == 0) m = mmap(0, grown, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(m == MAP_FAILED){
+        failed = true;
+        return false;
+    }
+    if(map) munmap(map, mapped);
+    map = (char *)m;
+    mapped = grown;
+    return true;
+}
+
+bool Recorder::Open(const char *path, const std::vector<RecorderChannel> &channels, int _decimation){
+    Close();
+    std::string dir(path);
+    size_t slash = dir.rfind('/');
+    if(slash != std::string::npos && slash > 0) mkdir(dir.substr(0, slash).c_str(), 0755);
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0) return false;
+
+    record_size = (uint32_t)((sizeof(double) + channels.size() * sizeof(float) + 7) & ~(size_t)7);
+    decimation = _decimation > 1 ? _decimation : 1;
+    step = dropped = 0;
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    stopping.store(false, std::memory_order_relaxed);
+    ring.assign((size_t)RECORDER_RING * record_size, 0);
+    map = 0;
+    mapped = size = 0;
+    failed = false;
+
+    size_t hsize = sizeof(RecorderHeader) + channels.size() * sizeof(RecorderChannel);
+    if(!Reserve(hsize)){
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    RecorderHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, RECORDER_MAGIC, sizeof(hdr.magic));
+    hdr.nchannel = (uint32_t)channels.size();
+    hdr.record_size = record_size;
+    hdr.decimation = decimation;
+    memcpy(map, &hdr, sizeof(hdr));
+    if(!channels.empty()) memcpy(map + sizeof(hdr), channels.data(), channels.size() * sizeof(RecorderChannel));
+    size = hsize;
+
+    writer = std::thread(&Recorder::Drain, this);
+    return true;
+}
+
+uint64_t Recorder::Close(){
+    if(fd < 0) return 0;
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+
+    RecorderHeader *hdr = (RecorderHeader *)map;
+    uint64_t nrecord = (size - sizeof(RecorderHeader) - hdr->nchannel * sizeof(RecorderChannel)) / record_size;
+    hdr->nrecord = nrecord;
+    hdr->dropped = dropped;
+    munmap(map, mapped);
+    //If the truncation fails the file keeps zero padding after the records,
+    //which nrecord excludes.
+    if(ftruncate(fd, size) != 0) {}
+    close(fd);
+    fd = -1;
+    map = 0;
+    std::vector<char>().swap(ring);
+    return nrecord;
+}
+
+#else
+
+bool Recorder::Reserve(size_t n){
+    return false;
+}
+
+bool Recorder::Open(const char *path, const std::vector<RecorderChannel> &channels, int _decimation){
+    return false;
+}
+
+uint64_t Recorder::Close(){
+    return 0;
+}
+
+#endif
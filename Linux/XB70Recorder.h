@@ -0,0 +1,103 @@
+#ifndef __XB70RECORDER_H
+#define __XB70RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+//Flight data recorder.
+//
+//The simulation thread fills one fixed-size record per sample in place, in a
+//single-producer, single-consumer ring: no lock, no allocation and no system
+//call on that thread. A writer thread drains the ring into the recording, a
+//file it maps into memory and grows RECORDER_CHUNK bytes at a time. If the
+//writer falls behind and the ring is full, the sample is dropped and counted;
+//the simulation never waits for the disk.
+//
+//File layout (host byte order):
+//
+//    RecorderHeader
+//    RecorderChannel[nchannel]
+//    records of record_size bytes: double simt, float value[nchannel]
+//
+//nrecord and dropped are written when the recording is closed; a recording
+//cut short has nrecord 0 and its length follows from the file size.
+//Linux/Tools/xb70_fdr2csv.cpp converts recordings to CSV.
+
+const char RECORDER_MAGIC[8] = {'X', 'B', '7', '0', 'F', 'D', 'R', '1'};
+
+struct RecorderHeader{
+    char magic[8];
+    uint32_t nchannel;
+    uint32_t record_size;       //[bytes], a multiple of 8
+    uint32_t decimation;        //Simulation steps per record
+    uint32_t dropped;           //Records lost to a full ring
+    uint64_t nrecord;
+};
+
+struct RecorderChannel{
+    char name[24];
+    char unit[8];
+};
+
+//Records in the ring (a power of two): 20 s at 50 records/s.
+const unsigned int RECORDER_RING = 1024;
+
+//File growth step [bytes].
+const size_t RECORDER_CHUNK = 4 << 20;
+
+//Writer thread wake-up period [ms].
+const int RECORDER_DRAIN_MS = 20;
+
+class Recorder{
+    public:
+        Recorder();
+        ~Recorder() {Close();}
+
+        //Creates the recording (and its directory) and starts the writer.
+        //Returns false, and records nothing, if the file cannot be created
+        //and mapped. Only available on Linux.
+        bool Open(const char *path, const std::vector<RecorderChannel> &channels, int decimation);
+
+        //Writes what is left in the ring, completes the header and stops the
+        //writer. Returns the number of records in the file.
+        uint64_t Close();
+
+        bool IsOpen() const {return fd >= 0;}
+        uint32_t Dropped() const {return dropped;}
+
+        //Simulation thread. Begin returns the values of the next record, or
+        //0 if this step is not sampled (decimation) or the ring is full;
+        //Commit hands the filled record to the writer.
+        float *Begin(double simt);
+        void Commit() {head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);}
+
+    private:
+        Recorder(const Recorder &) = delete;
+        Recorder &operator= (const Recorder &) = delete;
+
+        char *Slot(uint64_t i) {return &ring[(i & (RECORDER_RING - 1)) * record_size];}
+        void Drain();                   //Writer thread
+        bool Reserve(size_t n);         //Writer thread: maps n more bytes
+
+        int fd;
+        std::vector<char> ring;
+        uint32_t record_size;
+        uint32_t decimation;
+        uint32_t step;                  //Steps since the last record
+        uint32_t dropped;
+
+        alignas(64) std::atomic<uint64_t> head;     //Records committed (simulation thread)
+        alignas(64) std::atomic<uint64_t> tail;     //Records written (writer thread)
+        std::atomic<bool> stopping;
+        std::thread writer;
+
+        //Writer thread only while it runs
+        char *map;
+        size_t mapped;                  //Bytes mapped (the file size)
+        size_t size;                    //Bytes written
+        bool failed;                    //File could not grow; records are discarded
+};
+
+#endif //!__XB70RECORDER_H
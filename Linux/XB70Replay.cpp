@@ -0,0 +1,126 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70Replay.cpp
+//Flight data playback with a keyframe index
+//
+//==========================================
+
+#include "XB70Replay.h"
+#include <algorithm>
+
+Replay::Replay() : map(0), mapped(0), channels(0), nchannel(0), records(0), record_size(0),
+    nrecord(0), t0(0.0), cur(0), w(0.0){
+}
+
+int Replay::Channel(const char *name) const{
+    for(uint32_t k = 0; k < nchannel; k++)
+        if(!strncmp(channels[k].name, name, sizeof(channels[k].name))) return (int)k;
+    return -1;
+}
+
+void Replay::Seek(double simt){
+    if(simt <= t0){
+        cur = 0;
+        w = 0.0;
+        return;
+    }
+    //Onwards from the current record while playing. After a jump, a binary
+    //search between the keyframes around simt.
+    if(simt < Time(cur) || simt - Time(cur) > REPLAY_KEYFRAME_INTERVAL){
+        size_t k = std::min((size_t)((simt - t0) / REPLAY_KEYFRAME_INTERVAL), keyframe.size() - 1);
+        uint64_t lo = keyframe[k] ? keyframe[k] - 1 : 0;
+        uint64_t hi = k + 1 < keyframe.size() ? keyframe[k + 1] : nrecord;
+        while(hi - lo > 1){
+            uint64_t mid = lo + (hi - lo) / 2;
+            if(Time(mid) <= simt) lo = mid;
+            else hi = mid;
+        }
+        cur = lo;
+    }
+    while(cur + 1 < nrecord && Time(cur + 1) <= simt) cur++;
+    w = cur + 1 < nrecord ? (simt - Time(cur)) / (Time(cur + 1) - Time(cur)) : 0.0;
+}
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool Replay::Open(const char *_path){
+    Close();
+    int fd = open(_path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return false;
+    struct stat st;
+    void *m = MAP_FAILED;
+    if(fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(RecorderHeader))
+        m = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(m == MAP_FAILED) return false;
+    map = (const char *)m;
+    mapped = st.st_size;
+
+    RecorderHeader hdr;
+    memcpy(&hdr, map, sizeof(hdr));
+    size_t data = sizeof(hdr) + (size_t)hdr.nchannel * sizeof(RecorderChannel);
+    if(memcmp(hdr.magic, RECORDER_MAGIC, sizeof(hdr.magic)) || data > mapped ||
+        hdr.record_size < sizeof(double) + hdr.nchannel * sizeof(float) || hdr.record_size % 8){
+        Close();
+        return false;
+    }
+    channels = (const RecorderChannel *)(map + sizeof(hdr));
+    nchannel = hdr.nchannel;
+    records = map + data;
+    record_size = hdr.record_size;
+
+    //A recording that was not closed ends in the zero padding of its last
+    //file chunk.
+    nrecord = (mapped - data) / record_size;
+    if(hdr.nrecord) nrecord = std::min(nrecord, hdr.nrecord);
+    else{
+        while(nrecord > 1 && std::all_of(Record(nrecord - 1), Record(nrecord), [](char c){return c == 0;}))
+            nrecord--;
+    }
+
+    keyframe.clear();
+    bool ok = nrecord > 0;
+    t0 = ok ? Time(0) : 0.0;
+    for(uint64_t i = 0; ok && i < nrecord; i++){
+        double t = Time(i);
+        ok = !i || t > Time(i - 1);
+        while(ok && t0 + keyframe.size() * REPLAY_KEYFRAME_INTERVAL <= t) keyframe.push_back(i);
+    }
+    if(!ok){
+        Close();
+        return false;
+    }
+    path = _path;
+    cur = 0;
+    w = 0.0;
+    return true;
+}
+
+void Replay::Close(){
+    if(map) munmap((void *)map, mapped);
+    map = 0;
+    mapped = 0;
+    nrecord = 0;
+    keyframe.clear();
+    path.clear();
+}
+
+#else
+
+bool Replay::Open(const char *_path){
+    return false;
+}
+
+void Replay::Close(){
+}
+
+#endif
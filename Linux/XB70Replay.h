@@ -0,0 +1,79 @@
+#ifndef __XB70REPLAY_H
+#define __XB70REPLAY_H
+
+#include "XB70Recorder.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+//Playback of a flight data recording (XB70Recorder.h).
+//
+//The recording is mapped read-only; nothing is decoded up front except a
+//keyframe index, the first record of every REPLAY_KEYFRAME_INTERVAL seconds
+//of the recording. Seek finds the records around any time by one index
+//lookup and a binary search within one interval, whatever the length of the
+//recording; during normal playback it only steps forward from the previous
+//position. Values are
+//interpolated linearly between the two records, so the state at a given
+//simulation time depends on nothing but the file: playback is the same on
+//every run and at every time acceleration.
+
+//Keyframe spacing [s] of the recording.
+const double REPLAY_KEYFRAME_INTERVAL = 1.0;
+
+class Replay{
+    public:
+        Replay();
+        ~Replay() {Close();}
+
+        //Maps the recording and builds the keyframe index. Returns false if
+        //the file is missing, is not a recording, has no records or its time
+        //does not increase from record to record. Only available on Linux.
+        bool Open(const char *path);
+        void Close();
+
+        bool IsOpen() const {return map != 0;}
+        const std::string &Path() const {return path;}
+        uint64_t Records() const {return nrecord;}
+        double StartTime() const {return t0;}
+        double EndTime() const {return Time(nrecord - 1);}
+
+        //Index of the channel with this name, or -1.
+        int Channel(const char *name) const;
+
+        //Positions the playback at simt (clamped to the recording).
+        void Seek(double simt);
+
+        //Value of a channel at the Seek time.
+        double Value(int ch) const{
+            const float *a = Values(cur), *b = Values(cur + 1 < nrecord ? cur + 1 : cur);
+            return a[ch] + (b[ch] - a[ch]) * w;
+        }
+
+    private:
+        Replay(const Replay &) = delete;
+        Replay &operator= (const Replay &) = delete;
+
+        const char *Record(uint64_t i) const {return records + i * record_size;}
+        double Time(uint64_t i) const{
+            double t;
+            memcpy(&t, Record(i), sizeof(t));
+            return t;
+        }
+        const float *Values(uint64_t i) const {return (const float *)(Record(i) + sizeof(double));}
+
+        std::string path;
+        const char *map;
+        size_t mapped;
+        const RecorderChannel *channels;
+        uint32_t nchannel;
+        const char *records;
+        uint32_t record_size;
+        uint64_t nrecord;
+        double t0;                      //Time of the first record
+        std::vector<uint64_t> keyframe; //First record at or after t0 + k * REPLAY_KEYFRAME_INTERVAL
+        uint64_t cur;                   //Last record at or before the Seek time
+        double w;                       //Interpolation weight of record cur + 1
+};
+
+#endif //!__XB70REPLAY_H
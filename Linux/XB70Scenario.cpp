@@ -0,0 +1,64 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70Scenario.cpp
+//Base64 for the compact scenario state record
+//
+//==========================================
+
+#include "XB70Scenario.h"
+
+static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+size_t Base64Encode(const void *data, size_t n, char *out){
+    const unsigned char *in = (const unsigned char *)data;
+    char *o = out;
+    for(; n >= 3; n -= 3, in += 3){
+        uint32_t v = in[0] << 16 | in[1] << 8 | in[2];
+        *o++ = BASE64[v >> 18];
+        *o++ = BASE64[v >> 12 & 63];
+        *o++ = BASE64[v >> 6 & 63];
+        *o++ = BASE64[v & 63];
+    }
+    if(n){
+        uint32_t v = in[0] << 16 | (n > 1 ? in[1] << 8 : 0);
+        *o++ = BASE64[v >> 18];
+        *o++ = BASE64[v >> 12 & 63];
+        *o++ = n > 1 ? BASE64[v >> 6 & 63] : '=';
+        *o++ = '=';
+    }
+    *o = '\0';
+    return o - out;
+}
+
+static int Base64Value(char c){
+    if(c >= 'A' && c <= 'Z') return c - 'A';
+    if(c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if(c >= '0' && c <= '9') return c - '0' + 52;
+    if(c == '+') return 62;
+    if(c == '/') return 63;
+    return -1;
+}
+
+long Base64Decode(const char *text, size_t len, void *out, size_t max){
+    if(len % 4) return -1;
+    unsigned char *o = (unsigned char *)out;
+    size_t n = 0;
+    for(size_t i = 0; i < len; i += 4){
+        int pad = (text[i + 3] == '=') + (text[i + 2] == '=');
+        if(pad && i + 4 < len) return -1;
+        int a = Base64Value(text[i]), b = Base64Value(text[i + 1]);
+        int c = pad > 1 ? 0 : Base64Value(text[i + 2]);
+        int d = pad ? 0 : Base64Value(text[i + 3]);
+        if(a < 0 || b < 0 || c < 0 || d < 0) return -1;
+        if(n + 3 - pad > max) return -1;
+        uint32_t v = a << 18 | b << 12 | c << 6 | d;
+        o[n++] = v >> 16;
+        if(pad < 2) o[n++] = v >> 8 & 255;
+        if(pad < 1) o[n++] = v & 255;
+    }
+    return (long)n;
+}
@@ -0,0 +1,254 @@
+#ifndef __XB70SCENARIO_H
+#define __XB70SCENARIO_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//Scenario state parsing and writing.
+//
+//Custom vessel state is one "KEYWORD values" line per item, and the vessel
+//keeps its items in one table. KeywordIndex is a perfect hash over the
+//keywords of such a table, built at compile time: a line is dispatched with
+//one hash of its first word and one keyword compare, however many items
+//there are. ScenarioLine reads the values in place, with std::from_chars:
+//no copy of the line, no format string and no locale. ScenarioWriter is the
+//other direction, std::to_chars into a fixed buffer: doubles in the
+//shortest form that reads back to the same value.
+//
+//In compact form all items go into one record, base64 encoded on a single
+//line. Each item is stored as
+//
+//    uint8 keyword length, keyword, uint8 value bytes, values
+//
+//with int32 and double values in host byte order, so a reader can skip the
+//items it does not know. The same load and save functions serve both forms.
+
+//Keywords are case-insensitive, ASCII only.
+constexpr unsigned char KeywordUpper(char c){
+    return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : (unsigned char)c;
+}
+
+//FNV-1a of the n characters at s.
+constexpr uint32_t KeywordHash(const char *s, size_t n, uint32_t seed){
+    uint32_t h = 2166136261u ^ seed;
+    for(size_t i = 0; i < n; i++) h = (h ^ KeywordUpper(s[i])) * 16777619u;
+    return h;
+}
+
+constexpr size_t KeywordLength(const char *s){
+    size_t n = 0;
+    while(s[n]) n++;
+    return n;
+}
+
+//Slot table of a perfect hash over the keywords of an item table (rows with
+//a const char *keyword). NSLOT is a power of two larger than the table.
+template<size_t NSLOT>
+struct KeywordIndex{
+    static_assert(NSLOT && !(NSLOT & (NSLOT - 1)), "NSLOT must be a power of two");
+
+    bool valid;                 //False if no seed separates the keywords
+    uint32_t seed;
+    signed char slot[NSLOT];    //Row of each hash slot, -1 if empty
+
+    //Row of items whose keyword is the n characters at s, or -1.
+    template<class Item>
+    int Find(const Item *items, const char *s, size_t n) const{
+        int row = slot[KeywordHash(s, n, seed) & (NSLOT - 1)];
+        if(row < 0) return -1;
+        const char *kw = items[row].keyword;
+        for(size_t i = 0; i < n; i++)
+            if(KeywordUpper(kw[i]) != KeywordUpper(s[i])) return -1;
+        return kw[n] == '\0' ? row : -1;
+    }
+};
+
+//Tries seeds until the keywords of items land in distinct slots. Evaluated
+//by the compiler; check valid with a static_assert.
+template<size_t NSLOT, class Item, size_t N>
+constexpr KeywordIndex<NSLOT> MakeKeywordIndex(const Item (&items)[N]){
+    static_assert(N < NSLOT && N < 128, "too many keywords for the index");
+    KeywordIndex<NSLOT> index{};
+    for(uint32_t seed = 0; seed < 65536; seed++){
+        for(size_t k = 0; k < NSLOT; k++) index.slot[k] = -1;
+        size_t i = 0;
+        for(; i < N; i++){
+            size_t k = KeywordHash(items[i].keyword, KeywordLength(items[i].keyword), seed) & (NSLOT - 1);
+            if(index.slot[k] >= 0) break;
+            index.slot[k] = (signed char)i;
+        }
+        if(i == N){
+            index.valid = true;
+            index.seed = seed;
+            return index;
+        }
+    }
+    index.valid = false;
+    return index;
+}
+
+//Longest text line ScenarioWriter builds, and the largest compact record.
+const size_t SCENARIO_LINE_MAX = 256;
+const size_t SCENARIO_RECORD_MAX = 256;
+
+//Cursor over the values of one item: the rest of a text line, or the item's
+//bytes in a compact record. Each read skips the blanks before its field; a
+//read that finds no field of its type returns false, leaves the destination
+//as it was and does not move the cursor.
+class ScenarioLine{
+    public:
+        explicit ScenarioLine(const char *line) : p(line), end(line + strlen(line)), binary(false) {}
+        ScenarioLine(const char *data, size_t n) : p(data), end(data + n), binary(true) {}
+
+        //Next blank-delimited word; n is its length, 0 at the end of the
+        //line. Text only.
+        const char *Word(size_t &n){
+            Skip();
+            const char *w = p;
+            while(p < end && !Blank(*p)) p++;
+            n = p - w;
+            return w;
+        }
+
+        bool Int(int &v){
+            if(!binary) return Number(v);
+            int32_t x;
+            if(!Bytes(&x, sizeof(x))) return false;
+            v = x;
+            return true;
+        }
+        bool Float(double &v) {return binary ? Bytes(&v, sizeof(v)) : Number(v);}
+
+        //Everything left; of a text line without leading and trailing blanks.
+        const char *Rest(size_t &n){
+            Skip();
+            const char *r = p;
+            const char *e = end;
+            if(!binary) while(e > r && Blank(e[-1])) e--;
+            n = e - r;
+            p = end;
+            return r;
+        }
+
+    private:
+        static bool Blank(char c) {return c == ' ' || c == '\t' || c == '\r' || c == '\n';}
+        void Skip() {if(!binary) while(p < end && Blank(*p)) p++;}
+
+        template<class T>
+        bool Number(T &v){
+            Skip();
+            T x;
+            std::from_chars_result r = std::from_chars(p, end, x);
+            if(r.ec != std::errc()) return false;
+            v = x;
+            p = r.ptr;
+            return true;
+        }
+
+        bool Bytes(void *v, size_t n){
+            if((size_t)(end - p) < n) return false;
+            memcpy(v, p, n);
+            p += n;
+            return true;
+        }
+
+        const char *p;
+        const char *end;
+        bool binary;
+};
+
+//Values of one item, as a text line (blank separated) or appended to a
+//compact record. A value that does not fit sets Failed and is left out.
+class ScenarioWriter{
+    public:
+        explicit ScenarioWriter(bool _binary = false) : n(0), binary(_binary), failed(false) {}
+
+        ScenarioWriter &Int(int v){
+            if(binary){
+                int32_t x = v;
+                return Bytes(&x, sizeof(x));
+            }
+            Separate();
+            return Chars(std::to_chars(buf + n, buf + Capacity(), v));
+        }
+
+        ScenarioWriter &Float(double v){
+            if(binary) return Bytes(&v, sizeof(v));
+            Separate();
+            return Chars(std::to_chars(buf + n, buf + Capacity(), v));
+        }
+
+        ScenarioWriter &Text(const char *s, size_t len){
+            if(!binary) Separate();
+            return Bytes(s, len);
+        }
+
+        //Compact record: starts an item, and completes it with the length of
+        //the values written since. Rewind drops everything after mark.
+        size_t BeginItem(const char *keyword){
+            size_t mark = n;
+            size_t len = KeywordLength(keyword);
+            uint8_t h[2] = {(uint8_t)len, 0};
+            if(len > 255) failed = true;
+            Bytes(h, 1);
+            Bytes(keyword, len);
+            Bytes(h + 1, 1);
+            return mark;
+        }
+        void EndItem(size_t mark){
+            if(failed) return;
+            size_t len = n - mark - 2 - (uint8_t)buf[mark];
+            if(len > 255) failed = true;
+            else buf[mark + 1 + (uint8_t)buf[mark]] = (char)len;
+        }
+        void Rewind(size_t mark){
+            n = mark;
+            failed = false;
+        }
+
+        bool Failed() const {return failed;}
+        size_t Size() const {return n;}
+        const char *Data() const {return buf;}
+        //Text form, NUL-terminated.
+        const char *Str(){
+            buf[n] = '\0';
+            return buf;
+        }
+
+    private:
+        //One byte is kept for the NUL of Str.
+        size_t Capacity() const {return sizeof(buf) - 1;}
+        void Separate() {if(n) Bytes(" ", 1);}
+
+        ScenarioWriter &Bytes(const void *v, size_t len){
+            if(len > Capacity() - n) failed = true;
+            else {
+                memcpy(buf + n, v, len);
+                n += len;
+            }
+            return *this;
+        }
+
+        ScenarioWriter &Chars(std::to_chars_result r){
+            if(r.ec != std::errc()) failed = true;
+            else n = r.ptr - buf;
+            return *this;
+        }
+
+        char buf[SCENARIO_LINE_MAX > SCENARIO_RECORD_MAX ? SCENARIO_LINE_MAX : SCENARIO_RECORD_MAX];
+        size_t n;
+        bool binary;
+        bool failed;
+};
+
+//Base64 (RFC 4648, padded) of n bytes at data into out, which holds
+//4 * ((n + 2) / 3) + 1 characters. Returns the length written.
+size_t Base64Encode(const void *data, size_t n, char *out);
+
+//Decodes base64 text of length len into out (room for max bytes). Returns
+//the number of bytes, or -1 if the text is not base64 or does not fit.
+long Base64Decode(const char *text, size_t len, void *out, size_t max);
+
+#endif //!__XB70SCENARIO_H
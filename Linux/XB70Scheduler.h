@@ -0,0 +1,51 @@
+#ifndef __XB70SCHEDULER_H
+#define __XB70SCHEDULER_H
+
+//Multi-rate scheduling of the per-step work of a vessel.
+//
+//Each subsystem has an update period in simulation seconds, 0 for every
+//step. Due returns the subsystems to run in the current step as a bit mask
+//(bit i for subsystem i); the vessel calls them in its own order. All of
+//them run in the first step. After that a reduced-rate subsystem i is
+//offset by i/N of its period, so subsystems with the same rate do not land
+//in the same step, and a step longer than a period does not cause catch-up
+//runs. A step back in time (scenario reload) starts over.
+
+//Flight state queried once per step and shared by the subsystems.
+struct FlightState{
+    double mach;
+    double altitude;            //[m]
+    double dynp;                //Dynamic pressure [Pa]
+    double density;             //Atmospheric density [kg/m^3]
+};
+
+template<int N>
+class Scheduler{
+    public:
+        explicit Scheduler(const double *_period) : period(_period), prev(0.0), started(false) {}
+
+        void Reset() {started = false;}
+
+        unsigned int Due(double simt){
+            bool first = !started || simt < prev;
+            started = true;
+            prev = simt;
+            unsigned int due = 0;
+            for(int i = 0; i < N; i++){
+                if(!first && simt < next[i]) continue;
+                due |= 1u << i;
+                if(first) next[i] = simt + period[i] * (1.0 + (double)i / N);
+                else next[i] += period[i];
+                if(next[i] <= simt) next[i] = simt + period[i];
+            }
+            return due;
+        }
+
+    private:
+        const double *period;           //Per subsystem [s], 0 for every step
+        double next[N];                 //Time of the next run
+        double prev;                    //Time of the previous Due
+        bool started;
+};
+
+#endif //!__XB70SCHEDULER_H
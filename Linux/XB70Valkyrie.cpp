@@ -13,70 +13,358 @@
 
 #define ORBITER_MODULE
 #include "XB70Valkyrie.h"
+#include "XB70AeroTables.h"
+#include "XB70AeroDatabase.h"
+#include "XB70DragTerms.h"
+#include "XB70Engine.h"
+#include "XB70MeshCache.h"
+#include "XB70Profiler.h"
 #include <cstring>
 #include <cstdio>
 #include <cstdint>
 #include <algorithm>
+#include <cmath>
+#include <ctime>
+
+// Aerodynamic coefficient tables, one set per wingtip droop position. The
+// breakpoints are resampled onto uniform grids when the module is loaded (see
+// XB70AeroTables.h); define XB70_EXACT_AERO to evaluate the original
+// breakpoint interpolation instead. Each vessel blends the two positions
+// bracketing its current droop angle into its own tables (XB70Aero).
+//
+// Folding the tips reduces the lifting area, and the folded tips act as
+// additional fins (directional stability). At supersonic speed they also
+// trap the inlet shock under the wing (compression lift).
+
+static const int NDROOP = 3;
+static const double DROOP_ANGLE[NDROOP] = {0*RAD, 25*RAD, 65*RAD};
+
+static const int VLIFT_NABSC = 9;
+static const double VLIFT_AOA[VLIFT_NABSC] = {-180*RAD,-60*RAD,-30*RAD, -15*RAD, 0*RAD,15*RAD,30*RAD,60*RAD,180*RAD};
+static const double VLIFT_CL[NDROOP][VLIFT_NABSC] = {
+    {   0,    -0.56,   -0.56,   -0.16,  0.15,  0.46,  0.56,  0.56,  0.00},    //tips up
+    {   0,    -0.54,   -0.54,   -0.15,  0.15,  0.44,  0.54,  0.54,  0.00},    //25 deg
+    {   0,    -0.50,   -0.50,   -0.14,  0.14,  0.41,  0.50,  0.50,  0.00},    //65 deg
+};
+static const double VLIFT_CM[NDROOP][VLIFT_NABSC] = {
+    {    0,    0.00,   0.00,     0.00,  0.00,  0.00,  0.00,  0.00,  0.00},
+    {    0,    0.00,   0.00,     0.00,  0.00,  0.00,  0.00,  0.00,  0.00},
+    {    0,   -0.01,  -0.01,     0.00,  0.00,  0.00,  0.01,  0.01,  0.00},
+};
+static const double *const VLIFT_COEFFS[NDROOP][2] = {
+    {VLIFT_CL[0], VLIFT_CM[0]}, {VLIFT_CL[1], VLIFT_CM[1]}, {VLIFT_CL[2], VLIFT_CM[2]}};
+
+static const int HLIFT_NABSC = 8;
+static const double HLIFT_BETA[HLIFT_NABSC] = {-180*RAD,-135*RAD,-90*RAD,-45*RAD,45*RAD,90*RAD,135*RAD,180*RAD};
+static const double HLIFT_CL[NDROOP][HLIFT_NABSC] = {
+    {       0,    +0.3,      0,   -0.3,  +0.3,     0,   -0.3,      0},
+    {       0,   +0.36,      0,  -0.36, +0.36,     0,  -0.36,      0},
+    {       0,   +0.45,      0,  -0.45, +0.45,     0,  -0.45,      0},
+};
+static const double *const HLIFT_COEFFS[NDROOP][1] = {{HLIFT_CL[0]}, {HLIFT_CL[1]}, {HLIFT_CL[2]}};
+
+//Compression lift gain (fraction of the lift) per droop position, reached at
+//Mach 2 and faded in from Mach 1.
+static const double COMPRESSION_LIFT[NDROOP] = {0.0, 0.05, 0.12};
+
+const AeroTable<2> vlift_table[NDROOP] = {
+    AeroTable<2>(VLIFT_AOA, VLIFT_COEFFS[0], VLIFT_NABSC, 0.25*RAD),
+    AeroTable<2>(VLIFT_AOA, VLIFT_COEFFS[1], VLIFT_NABSC, 0.25*RAD),
+    AeroTable<2>(VLIFT_AOA, VLIFT_COEFFS[2], VLIFT_NABSC, 0.25*RAD),
+};
+const AeroTable<1> hlift_table[NDROOP] = {
+    AeroTable<1>(HLIFT_BETA, HLIFT_COEFFS[0], HLIFT_NABSC, 0.25*RAD),
+    AeroTable<1>(HLIFT_BETA, HLIFT_COEFFS[1], HLIFT_NABSC, 0.25*RAD),
+    AeroTable<1>(HLIFT_BETA, HLIFT_COEFFS[2], HLIFT_NABSC, 0.25*RAD),
+};
+
+//Difference between droop position k and the tips-up tables. The Mach
+//databases describe the tips-up wing; these increments are added on top.
+template<int NCH>
+static AeroTable<NCH> DroopDelta(const double *x, const double *const *y, const double *const *y0, int n){
+    std::vector<double> d(NCH * n);
+    const double *rows[NCH];
+    for(int k = 0; k < NCH; k++){
+        for(int i = 0; i < n; i++) d[k * n + i] = y[k][i] - y0[k][i];
+        rows[k] = &d[k * n];
+    }
+    return AeroTable<NCH>(x, rows, n, 0.25*RAD);
+}
+
+const AeroTable<2> vlift_delta[NDROOP] = {
+    DroopDelta<2>(VLIFT_AOA, VLIFT_COEFFS[0], VLIFT_COEFFS[0], VLIFT_NABSC),
+    DroopDelta<2>(VLIFT_AOA, VLIFT_COEFFS[1], VLIFT_COEFFS[0], VLIFT_NABSC),
+    DroopDelta<2>(VLIFT_AOA, VLIFT_COEFFS[2], VLIFT_COEFFS[0], VLIFT_NABSC),
+};
+const AeroTable<1> hlift_delta[NDROOP] = {
+    DroopDelta<1>(HLIFT_BETA, HLIFT_COEFFS[0], HLIFT_COEFFS[0], HLIFT_NABSC),
+    DroopDelta<1>(HLIFT_BETA, HLIFT_COEFFS[1], HLIFT_COEFFS[0], HLIFT_NABSC),
+    DroopDelta<1>(HLIFT_BETA, HLIFT_COEFFS[2], HLIFT_COEFFS[0], HLIFT_NABSC),
+};
+
+// Mach-dependent coefficient databases, loaded in InitModule and handed to the
+// airfoils through XB70Aero. If a file is missing the slot stays empty and the
+// callbacks fall back to the tables above.
+//
+// The files are watched while the simulation runs: a database written again
+// is loaded by a clbkPostStep at most TABLE_POLL_INTERVAL later and published
+// to the airfoil callbacks through its TableSlot. A file that does not parse
+// leaves the previous version in place.
+
+static TableSlot<AeroDatabase> vlift_db;
+static TableSlot<AeroDatabase> hlift_db;
+
+// J93 thrust and fuel consumption against Mach number and density altitude,
+// watched like the aerodynamic tables. Without it the engines keep the
+// class config ratings and Isp.
+
+static TableSlot<EngineTable> engine_table;
+
+static const char *const TABLE_DIR = "Config/XB-70_Valkyrie";
+
+//Simulation time [s] between two checks for changed files. A check is a
+//system call, ten times the cost of the rest of clbkPostStep.
+static const double TABLE_POLL_INTERVAL = 0.1;
+
+template<class T, TableSlot<T> *slot>
+static bool LoadTable(const char *path){
+    T *t = T::Load(path);
+    if(!t) return false;
+    slot->Publish(t);
+    return true;
+}
+
+struct WatchedTable{
+    const char *file;           //In TABLE_DIR
+    bool (*load)(const char *path);
+};
+
+static const WatchedTable watched_tables[] = {
+    {"VLift.dat",   LoadTable<AeroDatabase, &vlift_db>},
+    {"HLift.dat",   LoadTable<AeroDatabase, &hlift_db>},
+    {"J93.dat",     LoadTable<EngineTable, &engine_table>},
+};
+
+static FileWatch table_watch;
+static double table_poll_simt = -1e10;
+
+static bool LoadWatchedTable(const WatchedTable &t){
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", TABLE_DIR, t.file);
+    return t.load(path);
+}
+
+//Reloads the tables whose files changed. Called from every vessel's
+//clbkPostStep; looks for changes once per TABLE_POLL_INTERVAL.
+static void PollTables(double simt){
+    if(fabs(simt - table_poll_simt) < TABLE_POLL_INTERVAL) return;
+    table_poll_simt = simt;
+    static std::vector<std::string> changed;
+    changed.clear();
+    if(!table_watch.Poll(changed)) return;
+    for(const WatchedTable &t : watched_tables){
+        if(std::find(changed.begin(), changed.end(), t.file) == changed.end()) continue;
+        if(LoadWatchedTable(t)) oapiWriteLogV("XB70: reloaded %s/%s", TABLE_DIR, t.file);
+        else oapiWriteLogV("XB70: %s/%s not reloaded, keeping the previous version", TABLE_DIR, t.file);
+    }
+}
+
+// Class parameters, read from the class config file by the first
+// clbkSetClassCaps of a session and shared by all vessels.
+
+static XB70Config class_config;
+static bool class_config_loaded = false;
+
+// Drag terms evaluated locally instead of through oapiGetInducedDrag and
+// oapiGetWaveDrag (see XB70DragTerms.h). Both airfoils share the wave drag
+// shape. The induced drag factors are set from the class config with the
+// airfoils.
+
+static InducedDrag vlift_induced(class_config.vlift_aspect, class_config.vlift_efficiency);
+static InducedDrag hlift_induced(class_config.hlift_aspect, class_config.hlift_efficiency);
+static const WaveDrag wave_drag(0.75, 1.0, 1.1, 0.04);
 
 // 1. vertical lift component
 
 void VLiftCoeff (VESSEL *v, double aoa, double M, double Re, void *context, double *cl, double *cm, double *cd)
 {
-	const int nabsc = 9;
-	static const double AOA[nabsc] = {-180*RAD,-60*RAD,-30*RAD, -15*RAD, 0*RAD,15*RAD,30*RAD,60*RAD,180*RAD};
-	static const double CL[nabsc]  = {   0,    -0.56,   -0.56,   -0.16,  0.15,  0.46,  0.56,  0.56,  0.00};
-	static const double CM[nabsc]  = {    0,    0.00,   0.00,     0.00,  0.00,  0.00,  0.00,  0.00,  0.00};
-
-
-	int i;
-	for (i = 0; i < nabsc-1 && AOA[i+1] < aoa; i++);
-	if (i < nabsc - 1) {
-		double f = (aoa - AOA[i]) / (AOA[i + 1] - AOA[i]);
-		*cl = CL[i] + (CL[i + 1] - CL[i]) * f;  // aoa-dependent lift coefficient
-		*cm = CM[i] + (CM[i + 1] - CM[i]) * f;  // aoa-dependent moment coefficient
-	}
-	else {
-		*cl = CL[nabsc - 1];
-		*cm = CM[nabsc - 1];
+	XB70_PROFILE_SCOPE(PROF_VLIFT);
+	const XB70Aero *aero = (const XB70Aero *)context;
+	double c[AeroDatabase::NCOEFF];
+	double comp = aero->compression * (std::min)((std::max)(M - 1.0, 0.0), 1.0);
+	if (const AeroDatabase *vdb = aero->vdb->Get()) {
+		double d[2];
+		vdb->Lookup(aoa, M, Re, c);
+		aero->vlift_delta.Eval(aoa, d);
+		*cl = (c[AeroDatabase::CL] + d[0]) * (1.0 + comp);
+		*cm = c[AeroDatabase::CM] + d[1];
+		*cd = c[AeroDatabase::CD] + vlift_induced(*cl);
+		// tabulated profile + wave drag, plus (lift-)induced drag
+		aero->cl = *cl, aero->cm = *cm, aero->cd = *cd;
+		return;
 	}
+#ifdef XB70_EXACT_AERO
+	aero->vlift.EvalExact(aoa, c);
+#else
+	aero->vlift.Eval(aoa, c);
+#endif
+	*cl = c[0] * (1.0 + comp);  // aoa-dependent lift coefficient, plus compression lift
+	*cm = c[1];  // aoa-dependent moment coefficient
 	double saoa = sin(aoa);
 	double pd = 0.015 + 0.4*saoa*saoa;  // profile drag
-	*cd = pd + oapiGetInducedDrag (*cl, XB70_VLIFT_A, 0.7) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+	*cd = pd + vlift_induced(*cl) + wave_drag(M);
 	// profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
+	aero->cl = *cl, aero->cm = *cm, aero->cd = *cd;
 }
 
-// 2. horizontal lift component (vertical stabilisers and body)
+// 2. horizontal lift component (vertical stabilisers, drooped wingtips and body)
 
 void HLiftCoeff (VESSEL *v, double beta, double M, double Re, void *context, double *cl, double *cm, double *cd)
 {
-	int i;
-	const int nabsc = 8;
-	static const double BETA[nabsc] = {-180*RAD,-135*RAD,-90*RAD,-45*RAD,45*RAD,90*RAD,135*RAD,180*RAD};
-	static const double CL[nabsc]   = {       0,    +0.3,      0,   -0.3,  +0.3,     0,   -0.3,      0};
-	for (i = 0; i < nabsc-1 && BETA[i+1] < beta; i++);
-	if (i < nabsc - 1) {
-		*cl = CL[i] + (CL[i + 1] - CL[i]) * (beta - BETA[i]) / (BETA[i + 1] - BETA[i]);
-	}
-	else {
-		*cl = CL[nabsc - 1];
+	XB70_PROFILE_SCOPE(PROF_HLIFT);
+	const XB70Aero *aero = (const XB70Aero *)context;
+	if (const AeroDatabase *hdb = aero->hdb->Get()) {
+		double c[AeroDatabase::NCOEFF], d;
+		hdb->Lookup(beta, M, Re, c);
+		aero->hlift_delta.Eval(beta, &d);
+		*cl = c[AeroDatabase::CL] + d;
+		*cm = c[AeroDatabase::CM];
+		*cd = c[AeroDatabase::CD] + hlift_induced(*cl);
+		return;
 	}
+#ifdef XB70_EXACT_AERO
+	aero->hlift.EvalExact(beta, cl);
+#else
+	aero->hlift.Eval(beta, cl);
+#endif
 	*cm = 0.0;
-	*cd = 0.015 + oapiGetInducedDrag (*cl, XB70_HLIFT_A, 0.6) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+	*cd = 0.015 + hlift_induced(*cl) + wave_drag(M);
 }
 
 
+//Meshes for each level of detail, written by Linux/Tools/xb70_meshlod. All
+//levels have the same groups, so one animation table drives them all.
+static const char *const LOD_MESH_NAME[XB70_NLOD] = {
+    "XB-70_Valkyrie", "XB-70_Valkyrie_lod1", "XB-70_Valkyrie_lod2",
+};
+
+//Moving parts, indexed by XB70::ActuatorId. Adding an actuator is one entry
+//here plus its animation in DefineAnimations (and a row of scenario_items if
+//its state is saved). The rates are replaced by the class config operating
+//speeds in clbkSetClassCaps.
+ActuatorSpec XB70::actuator_spec[XB70::NACTUATOR] = {
+    //rate                          threshold
+    {class_config.gear_speed,       0.002},
+    {class_config.door_speed,       0.002},
+    {class_config.nosecone_speed,   0.005},
+    {class_config.droop_speed,      0.005},
+};
+
+//Custom scenario state, written in this order. Adding an item is one row
+//here (and NSCENARIOITEM); the keyword index is rebuilt by the compiler.
+//Default Orbiter state, the propellant levels included, goes through
+//ParseScenarioLineEx and SaveDefaultState.
+constexpr XB70::ScenarioItem XB70::scenario_items[XB70::NSCENARIOITEM] = {
+    //GEAR/DOOR/NOSECONE <status> <position>
+    {"GEAR",
+        [](XB70 &v, ScenarioLine &values){v.LoadActuator(ACT_GEAR, values);},
+        [](const XB70 &v, ScenarioWriter &values){return v.SaveActuator(ACT_GEAR, values);}},
+    {"DOOR",
+        [](XB70 &v, ScenarioLine &values){v.LoadActuator(ACT_DOOR, values);},
+        [](const XB70 &v, ScenarioWriter &values){return v.SaveActuator(ACT_DOOR, values);}},
+    {"NOSECONE",
+        [](XB70 &v, ScenarioLine &values){v.LoadActuator(ACT_NOSECONE, values);},
+        [](const XB70 &v, ScenarioWriter &values){return v.SaveActuator(ACT_NOSECONE, values);}},
+    //DROOP <mode> <commanded position> <position>
+    {"DROOP",
+        [](XB70 &v, ScenarioLine &values){
+            int mode = DROOP_AUTO, pos = 0;
+            double proc = 0.0;
+            values.Int(mode) && values.Int(pos) && values.Float(proc);
+            Actuator &a = v.actuators[ACT_DROOP];
+            a.proc = std::min(1.0, std::max(0.0, proc));
+            v.droop_pos = std::min(NDROOP - 1, std::max(0, pos));
+            v.SetDroopMode((mode >= DROOP_AUTO && mode <= DROOP_DOWN) ? (DroopMode)mode : DROOP_AUTO);
+            v.MoveActuator(ACT_DROOP, DROOP_ANGLE[v.droop_pos] / DROOP_ANGLE[NDROOP - 1]);
+            v.SetAnimation(a.anim, a.proc);
+            a.shown = a.proc;
+            v.UpdateDroopAero();
+        },
+        [](const XB70 &v, ScenarioWriter &values){
+            values.Int(v.droop_mode).Int(v.droop_pos).Float(v.actuators[ACT_DROOP].proc);
+            return true;
+        }},
+    //REPLAY <recording>, to the end of the line
+    {"REPLAY",
+        [](XB70 &v, ScenarioLine &values){
+            size_t n;
+            const char *path = values.Rest(n);
+            if(n) v.StartReplay(std::string(path, n).c_str());
+        },
+        [](const XB70 &v, ScenarioWriter &values){
+            if(!v.replay.IsOpen()) return false;
+            values.Text(v.replay.Path().data(), v.replay.Path().size());
+            return true;
+        }},
+    //XB70STATE <base64 record of the items above>, written by clbkSaveState
+    //in compact mode
+    {"XB70STATE",
+        [](XB70 &v, ScenarioLine &values){v.LoadCompactState(values);},
+        [](const XB70 &, ScenarioWriter &){return false;}},
+};
+
+constexpr KeywordIndex<XB70::NSCENARIOSLOT> XB70::scenario_index = MakeKeywordIndex<XB70::NSCENARIOSLOT>(XB70::scenario_items);
+
 //Constructor
-XB70::XB70(OBJHANDLE hVessel, int flightmodel) : VESSEL4(hVessel, flightmodel){
+XB70::XB70(OBJHANDLE hVessel, int flightmodel) : VESSEL4(hVessel, flightmodel),
+    aero(vlift_table[0], vlift_delta[0], hlift_table[0], hlift_delta[0]), scheduler(subsystem_period){
     
-    valky_mesh = oapiLoadMesh("XB-70_Valkyrie");
+    //Full detail always; reduced levels as far as they are installed.
+    lod_mesh[0] = AcquireSharedMesh(LOD_MESH_NAME[0]);
+    nlod = 1;
+    while(nlod < XB70_NLOD && (lod_mesh[nlod] = AcquireSharedMesh(LOD_MESH_NAME[nlod]))) nlod++;
+
+    lod_shown = 0;
+
+    visual = 0;
+
+    tex_full = false;
+    compact_state = false;
 
-    landing_gear_proc = 0.0;
+    engine.Set(class_config.dry_thrust, class_config.afterburner_thrust, class_config.isp);
+
+    engine_max0 = engine_isp = 0.0;
+
+    flight = FlightState();
+
+    for(int i = 0; i < NACTUATOR; i++){
+        actuators[i].status = ACT_AT0;
+        actuators[i].proc = 0.0;
+        actuators[i].shown = 0.0;
+        actuators[i].target = 0.0;
+        actuators[i].anim = 0;
+    }
 
-    door_proc = 0.0;
+    actuators_moving = 0;
 
-    landing_gear_status = GEAR_DOWN;
+    droop_mode = DROOP_AUTO;
 
-    door_status = DOOR_CLOSED;
+    droop_pos = 0;
+
+    touchdown_set = TDSET_NONE;
+
+    touchdown_interpolate = TOUCHDOWN_INTERPOLATE;
+
+    touchdown_proc = 0.0;
+
+    touchdown_travel = 0.0;
+    for(int i = 0; i < ntdvtx_geardown; i++) tdvtx_transit[i] = tdvtx_geardown[i];
+    for(int i = 0; i < 3; i++)
+        touchdown_travel = std::max(touchdown_travel, length(tdvtx_gearstowed[i] - tdvtx_geardown[i].pos));
+
+    lvl = 0.0;
+
+    lvlcontrailcanards = 0.0;
 
     DefineAnimations();
 
@@ -85,267 +373,152 @@ XB70::XB70(OBJHANDLE hVessel, int flightmodel) : VESSEL4(hVessel, flightmodel){
 //Destructor
 XB70::~XB70(){
     
-    oapiDeleteMesh(valky_mesh);
+    if(recorder.IsOpen()){
+        uint64_t n = recorder.Close();
+        oapiWriteLogV("XB70: %s flight data: %llu records, %u dropped", GetName(), (unsigned long long)n, recorder.Dropped());
+    }
+    if(tex_full) ReleaseFullTextures(lod_mesh[0]);
+    for(int k = 0; k < nlod; k++) ReleaseSharedMesh(lod_mesh[k]);
 
-    this->VESSEL4::~VESSEL4();
 }
 
-void XB70::DefineAnimations(void){
+//Update period [s] of each clbkPostStep subsystem, indexed by
+//XB70::SubsystemId; 0 runs it every step. The sound barrier window is 0.002
+//Mach wide, too narrow to sample at a reduced rate.
+const double XB70::subsystem_period[XB70::NSUBSYSTEM] = {
+    TABLE_POLL_INTERVAL,                    //tables
+    ENGINE_UPDATE_INTERVAL,                 //engine rating
+    0.0,                                    //engine Isp (throttle)
+    0.1,                                    //droop schedule
+    0.0,                                    //actuators
+    0.0,                                    //sound barrier
+    1.0,                                    //canard contrails
+    0.1,                                    //level of detail
+    0.0,                                    //flight data recorder (decimated in steps)
+};
+
+//Flight data recorder channels. Adding one is one row here; RecorderChannels
+//in the class config picks them by name, in any order.
+const XB70::RecorderChannelSpec XB70::recorder_channel_spec[] = {
+    //name          unit        value
+    {"mach",        "",         [](const XB70 &v){return v.flight.mach;}},
+    {"alt",         "m",        [](const XB70 &v){return v.flight.altitude;}},
+    {"dynp",        "Pa",       [](const XB70 &v){return v.flight.dynp;}},
+    {"rho",         "kg/m3",    [](const XB70 &v){return v.flight.density;}},
+    {"tas",         "m/s",      [](const XB70 &v){return v.GetAirspeed();}},
+    {"aoa",         "deg",      [](const XB70 &v){return v.GetAOA() * DEG;}},
+    {"beta",        "deg",      [](const XB70 &v){return v.GetSlipAngle() * DEG;}},
+    {"pitch",       "deg",      [](const XB70 &v){return v.GetPitch() * DEG;}},
+    {"bank",        "deg",      [](const XB70 &v){return v.GetBank() * DEG;}},
+    {"cl",          "",         [](const XB70 &v){return v.aero.cl;}},
+    {"cm",          "",         [](const XB70 &v){return v.aero.cm;}},
+    {"cd",          "",         [](const XB70 &v){return v.aero.cd;}},
+    {"elevator",    "",         [](const XB70 &v){return v.GetControlSurfaceLevel(AIRCTRL_ELEVATOR);}},
+    {"elevtrim",    "",         [](const XB70 &v){return v.GetControlSurfaceLevel(AIRCTRL_ELEVATORTRIM);}},
+    {"aileron",     "",         [](const XB70 &v){return v.GetControlSurfaceLevel(AIRCTRL_AILERON);}},
+    {"rudder",      "",         [](const XB70 &v){return v.GetControlSurfaceLevel(AIRCTRL_RUDDER);}},
+    {"throttle",    "",         [](const XB70 &v){return v.GetThrusterGroupLevel(THGROUP_MAIN);}},
+    {"sndbarrier",  "",         [](const XB70 &v){return v.lvl;}},
+    {"contrails",   "",         [](const XB70 &v){return v.lvlcontrailcanards;}},
+    {"thrust",      "N",        [](const XB70 &v){return v.GetThrusterGroupLevel(THGROUP_MAIN) * v.engine.reheat_thrust * XB70_NENGINE;}},
+    {"gear",        "",         [](const XB70 &v){return v.actuators[ACT_GEAR].proc;}},
+    {"door",        "",         [](const XB70 &v){return v.actuators[ACT_DOOR].proc;}},
+    {"nosecone",    "",         [](const XB70 &v){return v.actuators[ACT_NOSECONE].proc;}},
+    {"droop",       "deg",      [](const XB70 &v){return v.GetDroopAngle();}},
+    {"fuel",        "kg",       [](const XB70 &v){return v.GetFuelMass();}},
+    {"mass",        "kg",       [](const XB70 &v){return v.GetMass();}},
+};
+
+//Recorder channel of each replay target, indexed by XB70::ReplayTarget.
+const char *const XB70::replay_channel_name[XB70::NREPLAYTARGET] = {
+    "gear", "door", "nosecone", "droop",
+    "elevator", "elevtrim", "aileron", "rudder",
+    "throttle", "sndbarrier", "contrails",
+};
+
+//Control surfaces of RPL_ELEVATOR onwards.
+static const AIRCTRL_TYPE replay_ctrl_type[] = {AIRCTRL_ELEVATOR, AIRCTRL_ELEVATORTRIM, AIRCTRL_AILERON, AIRCTRL_RUDDER};
+
+//Initial state of each animation, indexed by XB70::AnimId. Control surfaces
+//rest at mid range.
+const double XB70::anim_initial[XB70::NANIM] = {
+    0.0, 0.0, 0.0, 0.0,                     //gear, door, nose cone, droop
+    0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5,      //control surfaces
+};
+
+//Animation components. Adding one is one row here (and NANIMCOMP). Group
+//Ids come from XB70_mesh_groups.h, generated from the mesh, so a group the
+//mesh does not have is a compile error. The mesh has no nose cone group yet:
+//ANIM_NOSECONE exists (its state is saved) but moves nothing.
+static constexpr AnimComponentSpec anim_component_spec[] = {
+    //anim                  state0 state1  groups                                                                                  pivot                                        axis         angle
 
     //Left landing gear
-    
-    static unsigned int FrontLandingGearGrp[3] = {Front_landing_gear_Id, Front_landing_gear_door1_Id, Front_wheels_landing_gear_Id};
-    static MGROUP_ROTATE FrontLandingGear_Rotate(
-        0,
-        FrontLandingGearGrp,
-        3,
-        (Front_landing_gear_rotation_Location),
-        _V(1, 0, 0),
-        (float)(95*RAD)
-    );
-
-    static unsigned int FrontLandingGearDoorGrp[1] = {Front_landing_gear_door2_Id};
-    static MGROUP_ROTATE FrontLandingGearDoor(
-        0,
-        FrontLandingGearDoorGrp,
-        1,
-        (Front_landing_gear_second_door_Location),
-        _V(0, 0, 1),
-        (float)(100*RAD)
-    );
-
-    anim_landing_gear = CreateAnimation(0.0);
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.5, &FrontLandingGear_Rotate);
-    AddAnimationComponent(anim_landing_gear, 0.4, 1, &FrontLandingGearDoor);
-    
-    static unsigned int RearLeftWheels[1] = {Rear_wheels_rear_left_landing_gear_Id};
-    static MGROUP_ROTATE RearLeftWheelsRotate(
-        0,
-        RearLeftWheels,
-        1,
-        (Axis_left_landing_gear2_Location),
-        _V(0, 1, 0),
-        (float)(-90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.3, &RearLeftWheelsRotate);
-
-    static MGROUP_ROTATE RearLeftWheelsRotate2(
-        0,
-        RearLeftWheels,
-        1,
-        (Axis_left_landing_gear2_Location),
-        _V(0, 0, 1),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0.3, 0.6, &RearLeftWheelsRotate2);
-
-    static unsigned int StowLandingLeftGearGrp[2] = {Rear_left_landing_gear_Id, Rear_wheels_rear_left_landing_gear_Id};
-    static MGROUP_ROTATE StowLandingLeftGear(
-        0,
-        StowLandingLeftGearGrp,
-        2,
-        (Axis_left_landing_gear_Location),
-        _V(1, 0, 0),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0.6, 0.9, &StowLandingLeftGear);
-
-    static unsigned int RearLandingGearDoorsGrp[1] = {Rear_landing_gear_doors_Id};
-    static MGROUP_ROTATE RearLandingGearDoors(
-        0,
-        RearLandingGearDoorsGrp,
-        1,
-        (Rear_landing_gear_rotation_doors1_Location),
-        _V(1, 0, 0),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear,
-    0.9, 1, &RearLandingGearDoors);
-
-    static unsigned int RearLeftLandingGearMainDoorGrp[1] = {Rear_landing_gear_left_door_Id};
-    static MGROUP_ROTATE RearLeftLandingGearMainDoor(
-        0,
-        RearLeftLandingGearMainDoorGrp,
-        1,
-        (Rear_landing_gear_doors1_Location),
-        _V(0, 0, 1),
-        (float)(-110*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0.9, 1, &RearLeftLandingGearMainDoor);
+    {XB70::ANIM_GEAR,       0.0,   0.5,    3, {Front_landing_gear_Id, Front_landing_gear_door_Id, Front_wheels_landing_gear_Id}, Front_landing_gear_rotation_Location,        {1, 0, 0},   (float)(95*RAD)},
+    {XB70::ANIM_GEAR,       0.0,   0.3,    2, {Front_wheels_rear_left_landing_gear_Id, Rear_wheels_rear_left_landing_gear_Id},    Axis_left_landing_gear2_Location,            {0, 1, 0},   (float)(-90*RAD)},
+    {XB70::ANIM_GEAR,       0.3,   0.6,    2, {Front_wheels_rear_left_landing_gear_Id, Rear_wheels_rear_left_landing_gear_Id},    Axis_left_landing_gear2_Location,            {0, 0, 1},   (float)(90*RAD)},
+    {XB70::ANIM_GEAR,       0.6,   0.9,    3, {Rear_left_landing_gear_Id, Front_wheels_rear_left_landing_gear_Id, Rear_wheels_rear_left_landing_gear_Id},
+                                                                                                                                   Axis_left_landing_gear_Location,             {1, 0, 0},   (float)(90*RAD)},
+    {XB70::ANIM_GEAR,       0.9,   1.0,    1, {Rear_landing_gears_doors_Id},                                                       Rear_landing_gear_rotation_doors1_Location,  {1, 0, 0},   (float)(90*RAD)},
 
     //Right landing gear
-
-    static unsigned int RearRightWheels[1] = {Rear_wheels_rear_right_landing_gear_Id};
-    static MGROUP_ROTATE RearRightWheelsRotate(
-        0,
-        RearRightWheels,
-        1,
-        (Axis_right_landing_gear2_Location),
-        _V(0, 1, 0),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0, 0.3, &RearRightWheelsRotate);
-
-    static MGROUP_ROTATE RearRightWheelsRotate2(
-        0,
-        RearRightWheels,
-        1,
-        (Axis_right_landing_gear2_Location),
-        _V(0, 0, 1),
-        (float)(-90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0.3, 0.6, &RearRightWheelsRotate2);
-
-    static unsigned int StowLandingRightGearGrp[2] = {Rear_right_landing_gear_Id, Rear_wheels_rear_right_landing_gear_Id};
-    static MGROUP_ROTATE StowLandingRightGear(
-        0,
-        StowLandingRightGearGrp,
-        2,
-        (Axis_right_landing_gear_Location),
-        _V(1, 0, 0),
-        (float)(90*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0.6, 0.9, &StowLandingRightGear);
-
-    static unsigned int RearRightLandingGearMainDoorGrp[1] = {Rear_landing_gear_right_door_Id};
-    static MGROUP_ROTATE RearRightLandingGearMainDoor(
-        0,
-        RearRightLandingGearMainDoorGrp,
-        1,
-        (Rear_landing_gear_doors2_Location),
-        _V(0, 0, 1),
-        (float)(110*RAD)
-    );
-
-    AddAnimationComponent(anim_landing_gear, 0.9, 1, &RearRightLandingGearMainDoor);
+    {XB70::ANIM_GEAR,       0.0,   0.3,    2, {Front_wheels_rear_right_landing_gear_Id, Rear_wheels_rear_right_landing_gear_Id},  Axis_right_landing_gear2_Location,           {0, 1, 0},   (float)(90*RAD)},
+    {XB70::ANIM_GEAR,       0.3,   0.6,    2, {Front_wheels_rear_right_landing_gear_Id, Rear_wheels_rear_right_landing_gear_Id},  Axis_right_landing_gear2_Location,           {0, 0, 1},   (float)(-90*RAD)},
+    {XB70::ANIM_GEAR,       0.6,   0.9,    3, {Rear_right_landing_gear_Id, Front_wheels_rear_right_landing_gear_Id, Rear_wheels_rear_right_landing_gear_Id},
+                                                                                                                                   Axis_right_landing_gear_Location,            {1, 0, 0},   (float)(90*RAD)},
 
     //Open/close door
+    {XB70::ANIM_DOOR,       0.0,   1.0,    1, {Door_Id},                                                                           {-1.3062, 0.8235, 19.5891},                  {0, 1, 0},   (float)(2.9670)},
+
+    //Wingtip droop (0 to 65 degrees)
+    {XB70::ANIM_DROOP,      0.0,   1.0,    1, {Delta_wing_left_Id},                                                                Axis_left_wing_Location,                     {0, 0, 1},   (float)(65*RAD)},
+    {XB70::ANIM_DROOP,      0.0,   1.0,    1, {Delta_wing_right_Id},                                                               Axis_right_wing_Location,                    {0, 0, 1},   (float)(-65*RAD)},
+
+    //Control surfaces
+    {XB70::ANIM_ELEVATORTRIM, 0.0, 1.0,    2, {hlaileron_Id, hraileron_Id},                                                        {-0.0793, 0.3068, -25.0097},                 {1, 0, 0},   (float)(0.2094)},
+    {XB70::ANIM_LAILERON,   0.0,   1.0,    1, {hlaileron_Id},                                                                      {-8.6631, 0.3068, -25.1881},                 {1, 0, 0},   (float)(-0.4188)},
+    {XB70::ANIM_RAILERON,   0.0,   1.0,    1, {hraileron_Id},                                                                      {8.5085, 0.3068, -25.2312},                  {1, 0, 0},   (float)(0.4188)},
+    {XB70::ANIM_ELEVATOR,   0.0,   1.0,    2, {hlaileron_Id, hraileron_Id},                                                        {-0.0793, 0.3068, -25.0097},                 {1, 0, 0},   (float)(0.4188)},
+    {XB70::ANIM_CANARDS,    0.0,   1.0,    1, {Canards_Id},                                                                        {0.0977, 1.4979, 15.5177},                   {1, 0, 0},   (float)(0.2617)},
+    {XB70::ANIM_LRUDDER,    0.0,   1.0,    1, {LRudder_Id},                                                                        LRudder_axis_Location,                       {0, 1, 0},   (float)(0.2094)},
+    {XB70::ANIM_RRUDDER,    0.0,   1.0,    1, {RRudder_Id},                                                                        RRudder_axis_Location,                       {0, 1, 0},   (float)(0.2094)},
+};
+
+//True if every component names between 1 and ANIM_MAXGRP groups that exist
+//in the mesh and a valid animation.
+static constexpr bool AnimComponentsValid(const AnimComponentSpec *spec, int n){
+    for(int i = 0; i < n; i++){
+        if(spec[i].anim < 0 || spec[i].anim >= XB70::NANIM) return false;
+        if(spec[i].ngrp < 1 || spec[i].ngrp > (UINT)ANIM_MAXGRP) return false;
+        for(UINT g = 0; g < spec[i].ngrp; g++)
+            if(spec[i].grp[g] >= MESH_NGROUP) return false;
+    }
+    return true;
+}
+
+static_assert(sizeof(anim_component_spec) / sizeof(anim_component_spec[0]) == XB70::NANIMCOMP,
+    "XB70::NANIMCOMP does not match anim_component_spec");
+static_assert(AnimComponentsValid(anim_component_spec, XB70::NANIMCOMP),
+    "anim_component_spec references a mesh group or animation that does not exist");
+
+//Builds the animations from anim_component_spec, once per level of detail
+//mesh. The transforms and their group lists live in the instance;
+//anim_components is reserved up front so the pointers handed to
+//AddAnimationComponent stay valid.
+void XB70::DefineAnimations(void){
+
+    for(int i = 0; i < NANIM; i++) anims[i] = CreateAnimation(anim_initial[i]);
+    for(int i = 0; i < NACTUATOR; i++) actuators[i].anim = anims[i];
 
-    static unsigned int DoorOpenGrp[1] = {Door_Id};
-    static MGROUP_ROTATE DoorOpen(
-        0,
-        DoorOpenGrp,
-        1,
-        _V(-1.3062, 0.8235, 19.5891),
-        _V(0, 1, 0),
-        (float)(2.9670)
-    );
-
-    anim_door = CreateAnimation(0.0);
-
-    AddAnimationComponent(anim_door, 0, 1, &DoorOpen);
-
-
-    ///////Nose cone
-
-    static unsigned int NoseConeGrp[1] = {Nose_cone_Id};
-    static MGROUP_ROTATE NoseCone(
-        0,
-        NoseConeGrp,
-        1,
-        (Axis_nosecone_Location),
-        _V(1, 0, 0),
-        (float)(10*RAD)
-    );
-
-    anim_nosecone = CreateAnimation(0.0);
-    AddAnimationComponent(anim_nosecone, 0, 1, &NoseCone);
-
-
-    //////Control surfaces   
-
-    static unsigned int ElevatorTrimGrp[2] = {hlaileron_Id, hraileron_Id};
-    static MGROUP_ROTATE ElevatorTrim(
-        0,
-        ElevatorTrimGrp,
-        2,
-        _V(-0.0793, 0.3068, -25.0097),
-        _V(1, 0, 0),
-        (float)(0.2094)
-    );
-    anim_elevatortrim = CreateAnimation(0.5);
-    AddAnimationComponent(anim_elevatortrim, 0, 1, &ElevatorTrim);
-
-    static unsigned int LeftAileronGrp[1] = {hlaileron_Id};
-    static MGROUP_ROTATE LAileron(
-        0,
-        LeftAileronGrp,
-        1,
-        _V(-8.6631, 0.3068, -25.1881),
-        _V(1, 0, 0),
-        (float)(-0.4188)
-    );
-    anim_laileron = CreateAnimation(0.5);
-    AddAnimationComponent(anim_laileron, 0, 1, &LAileron);
-
-    static unsigned int RightAileronGrp[1] = {hraileron_Id};
-    static MGROUP_ROTATE RAileron(
-        0,
-        RightAileronGrp,
-        1,
-        _V(8.5085, 0.3068, -25.2312),
-        _V(1, 0, 0),
-        (float)(0.4188)
-    );
-    anim_raileron = CreateAnimation(0.5);
-    AddAnimationComponent(anim_raileron, 0, 1, &RAileron);
-
-    static unsigned int ElevatorGrp[2] = {hlaileron_Id, hraileron_Id};
-    static MGROUP_ROTATE Elevator(
-        0,
-        ElevatorGrp,
-        2,
-        _V(-0.0793, 0.3068, -25.0097),
-        _V(1, 0, 0),
-        (float)(0.4188)
-    );
-    anim_elevator = CreateAnimation(0.5);
-    AddAnimationComponent(anim_elevator, 0, 1, &Elevator);
-
-    static unsigned int CanardsGrp[1] = {Canards_Id};
-    static MGROUP_ROTATE Canards(
-        0,
-        CanardsGrp,
-        1,
-        _V(0.0977, 1.4979, 15.5177),
-        _V(1, 0, 0),
-        (float)(0.2617)
-    );
-    anim_canards = CreateAnimation(0.5);
-    AddAnimationComponent(anim_canards, 0, 1, &Canards);
-
-    static unsigned int LRudderGrp[1] = {LRudder_Id};
-    static MGROUP_ROTATE LRudder(
-        0,
-        LRudderGrp,
-        1,
-        (LRudder_axis_Location),
-        _V(0, 1, 0),
-        (float)(0.2094)
-    );
-    anim_lrudder = CreateAnimation(0.5);
-    AddAnimationComponent(anim_lrudder, 0, 1, &LRudder);
-
-    static unsigned int RRudderGrp[1] = {RRudder_Id};
-    static MGROUP_ROTATE RRudder(
-        0,
-        RRudderGrp,
-        1,
-        (RRudder_axis_Location),
-        _V(0, 1, 0),
-        (float)(0.2094)
-    );
-    anim_rrudder = CreateAnimation(0.5);
-    AddAnimationComponent(anim_rrudder, 0, 1, &RRudder);
+    anim_components.reserve(NANIMCOMP * nlod);
+    for(int i = 0; i < NANIMCOMP; i++){
+        const AnimComponentSpec &spec = anim_component_spec[i];
+        for(UINT g = 0; g < spec.ngrp; g++) anim_groups[i][g] = spec.grp[g];
+        for(int k = 0; k < nlod; k++){
+            anim_components.emplace_back(k, anim_groups[i], spec.ngrp, spec.ref, spec.axis, spec.angle);
+            AddAnimationComponent(anims[spec.anim], spec.state0, spec.state1, &anim_components.back());
+        }
+    }
 }
 
 
@@ -353,33 +526,48 @@ void XB70::DefineAnimations(void){
 // Set the capabilities of the vessel class
 void XB70::clbkSetClassCaps(FILEHANDLE cfg){
 
+    //Class parameters: the config file is read by the first vessel only.
+    if(!class_config_loaded){
+        class_config.Read(cfg);
+        class_config_loaded = true;
+        const double rate[NACTUATOR] = {class_config.gear_speed, class_config.door_speed,
+            class_config.nosecone_speed, class_config.droop_speed};
+        for(int i = 0; i < NACTUATOR; i++) actuator_spec[i].rate = rate[i];
+        vlift_induced = InducedDrag(class_config.vlift_aspect, class_config.vlift_efficiency);
+        hlift_induced = InducedDrag(class_config.hlift_aspect, class_config.hlift_efficiency);
+    }
+    const XB70Config &c = class_config;
+
     //Define thrusters
-    THRUSTER_HANDLE th_main[6];
     THGROUP_HANDLE thg_main;
 
     //Physical vessel resources
-    SetSize(XB70_SIZE);
-    SetEmptyMass(XB70_EMPTYMASS);
-    SetCrossSections(XB70_CS);
-    SetPMI(XB70_PMI);
-    SetMaxWheelbrakeForce(25e5);
-    ShiftCentreOfMass(_V(0, -0.8294, 0));
-    ShiftCG(_V(0, -0.8294, 0));
-    SetWingEffectiveness(2.5);
-    SetRotDrag(_V(5, 5, 2.5));
+    SetSize(c.size);
+    SetEmptyMass(c.empty_mass);
+    SetCrossSections(c.cs);
+    SetPMI(c.pmi);
+    SetMaxWheelbrakeForce(c.wheelbrake_force);
+    ShiftCentreOfMass(c.cg_shift);
+    ShiftCG(c.cg_shift);
+    SetWingEffectiveness(c.wing_effectiveness);
+    SetRotDrag(c.rot_drag);
     SetNosewheelSteering(true);
 
     //Propellant resources
-    PROPELLANT_HANDLE JP6 = CreatePropellantResource(XB70_FUELMASS);
-
-    //Define main engine
-    th_main[0] = CreateThruster(_V(-3.6722, -0.8294, -25.5365), _V(0, 0, 1), XB70_AFTERBRNTH, JP6, XB70_ISP);
-    th_main[1] = CreateThruster(_V(-2.2222, -0.8294, -25.5401), _V(0, 0, 1), XB70_AFTERBRNTH, JP6, XB70_ISP);
-    th_main[2] = CreateThruster(_V(-0.8022, -0.8294, -25.5437), _V(0, 0, 1), XB70_AFTERBRNTH, JP6, XB70_ISP);
-    th_main[3] = CreateThruster(_V(0.6378, -0.8294, -25.5473), _V(0, 0, 1), XB70_AFTERBRNTH, JP6, XB70_ISP);
-    th_main[4] = CreateThruster(_V(2.0678, -0.8294, -25.5509), _V(0, 0, 1), XB70_AFTERBRNTH, JP6, XB70_ISP);
-    th_main[5] = CreateThruster(_V(3.5278, -0.8294, -25.5545), _V(0, 0, 1), XB70_AFTERBRNTH, JP6, XB70_ISP);
-    thg_main = CreateThrusterGroup(th_main, 6, THGROUP_MAIN);
+    PROPELLANT_HANDLE JP6 = CreatePropellantResource(c.fuel_mass);
+
+    //Define main engine. The ratings and Isp are replaced by the engine table
+    //values in UpdateEngineRating and UpdateEngineIsp.
+    engine.Set(c.dry_thrust, c.afterburner_thrust, c.isp);
+    engine_max0 = engine.reheat_thrust;
+    engine_isp = engine.Isp(0.0);
+    const VECTOR3 engine_pos[XB70_NENGINE] = {
+        {-3.6722, -0.8294, -25.5365}, {-2.2222, -0.8294, -25.5401}, {-0.8022, -0.8294, -25.5437},
+        {0.6378, -0.8294, -25.5473}, {2.0678, -0.8294, -25.5509}, {3.5278, -0.8294, -25.5545},
+    };
+    for(int i = 0; i < XB70_NENGINE; i++)
+        th_main[i] = CreateThruster(engine_pos[i], _V(0, 0, 1), engine_max0, JP6, engine_isp);
+    thg_main = CreateThrusterGroup(th_main, XB70_NENGINE, THGROUP_MAIN);
 
     SURFHANDLE exhaust_tex = oapiRegisterExhaustTexture("Exhaust");
 
@@ -391,8 +579,12 @@ void XB70::clbkSetClassCaps(FILEHANDLE cfg){
     AddExhaust(th_main[5], 15, 1, (ENG5_Location), _V(0, 0, -1));
 
 
-    //Add a mesh for the visual
-    AddMesh(valky_mesh);
+    //Add the meshes for the visual, one per level of detail; UpdateLod shows
+    //one of them at a time.
+    for(int k = 0; k < nlod; k++){
+        AddMesh(lod_mesh[k]);
+        SetMeshVisibilityMode(k, k == lod_shown ? MESHVIS_EXTERNAL : MESHVIS_NEVER);
+    }
 
     //Sound speed barrier visual effect
     static PARTICLESTREAMSPEC soundbarrierpart = {
@@ -416,148 +608,481 @@ void XB70::clbkSetClassCaps(FILEHANDLE cfg){
     AddParticleStream(&canard_contrails, (Right_canard_contrail_Location), dir, &lvlcontrailcanards);
 
 
-    hwing = CreateAirfoil3(LIFT_VERTICAL, _V(0, -0.8294, 0), VLiftCoeff, 0, XB70_VLIFT_C, (XB70_VLIFT_S*2), XB70_VLIFT_A);
+    aero.vdb = &vlift_db;
+    aero.hdb = &hlift_db;
+
+    hwing = CreateAirfoil3(LIFT_VERTICAL, _V(0, -0.8294, 0), VLiftCoeff, &aero, c.vlift_chord, c.vlift_area, c.vlift_aspect);
 
-	CreateAirfoil3 (LIFT_HORIZONTAL, (Vertical_tails_Location), HLiftCoeff, 0, XB70_HLIFT_C, (XB70_HLIFT_S*2), XB70_HLIFT_A);
+	CreateAirfoil3 (LIFT_HORIZONTAL, (Vertical_tails_Location), HLiftCoeff, &aero, c.hlift_chord, c.hlift_area, c.hlift_aspect);
 	// vertical stabiliser and body lift and drag components
     
     
-	hlaileron = CreateControlSurface3 (AIRCTRL_AILERON, (18.37/2), 1.7, _V(-7.6463, 0.3196, -26.8960), AIRCTRL_AXIS_AUTO, 1.0, anim_raileron);
-	hraileron = CreateControlSurface3 (AIRCTRL_AILERON, (18.37/2), 1.7, _V(7.4547, 0.3174, -26.8053), AIRCTRL_AXIS_AUTO, 1.0, anim_laileron);
+	hlaileron = CreateControlSurface3 (AIRCTRL_AILERON, c.aileron_area, c.aileron_dcl, _V(-7.6463, 0.3196, -26.8960), AIRCTRL_AXIS_AUTO, 1.0, anims[ANIM_RAILERON]);
+	hraileron = CreateControlSurface3 (AIRCTRL_AILERON, c.aileron_area, c.aileron_dcl, _V(7.4547, 0.3174, -26.8053), AIRCTRL_AXIS_AUTO, 1.0, anims[ANIM_LAILERON]);
 
-    canards = CreateControlSurface3(AIRCTRL_ELEVATOR, 38.61, 1.7, _V(-0.0440, 1.4532, 14.7854),AIRCTRL_AXIS_AUTO, 1.0, anim_canards);
+    canards = CreateControlSurface3(AIRCTRL_ELEVATOR, c.canard_area, c.canard_dcl, _V(-0.0440, 1.4532, 14.7854),AIRCTRL_AXIS_AUTO, 1.0, anims[ANIM_CANARDS]);
 
-    CreateControlSurface3 (AIRCTRL_ELEVATOR, 36.74, 1.7, _V(-0.0833, 0.3068, -26.6097), AIRCTRL_AXIS_AUTO, 1.0, anim_elevator);
+    CreateControlSurface3 (AIRCTRL_ELEVATOR, c.elevator_area, c.elevator_dcl, _V(-0.0833, 0.3068, -26.6097), AIRCTRL_AXIS_AUTO, 1.0, anims[ANIM_ELEVATOR]);
 	CreateControlSurface3 
-    (AIRCTRL_ELEVATORTRIM, 36.74, 1.7, _V(-0.0833, 0.3068, -26.6097), AIRCTRL_AXIS_AUTO, 1.0, anim_elevatortrim);
+    (AIRCTRL_ELEVATORTRIM, c.elevator_area, c.elevator_dcl, _V(-0.0833, 0.3068, -26.6097), AIRCTRL_AXIS_AUTO, 1.0, anims[ANIM_ELEVATORTRIM]);
 
-    CreateControlSurface3(AIRCTRL_RUDDER, 17.76, 1.7, (LRudder_Location), AIRCTRL_AXIS_AUTO, 1.0, 
-    anim_lrudder);
-    CreateControlSurface3(AIRCTRL_RUDDER, 17.76, 1.7, (RRudder_Location), AIRCTRL_AXIS_AUTO, 1.0, anim_rrudder);
+    CreateControlSurface3(AIRCTRL_RUDDER, c.rudder_area, c.rudder_dcl, (LRudder_Location), AIRCTRL_AXIS_AUTO, 1.0, 
+    anims[ANIM_LRUDDER]);
+    CreateControlSurface3(AIRCTRL_RUDDER, c.rudder_area, c.rudder_dcl, (RRudder_Location), AIRCTRL_AXIS_AUTO, 1.0, anims[ANIM_RRUDDER]);
+
+    //Touchdown points for the default (gear down) state; clbkLoadStateEx
+    //replaces them if the scenario says otherwise.
+    UpdateTouchdownPoints();
+
+    compact_state = c.compact_state;
+    if(c.flight_recorder) StartRecorder();
 
 }
 
 
-//Load landing gear status from scenario file
+//Custom state from the scenario file: each line is dispatched on its first
+//word through scenario_index.
 void XB70::clbkLoadStateEx(FILEHANDLE scn, void *vs){
     
+    XB70_PROFILE_SCOPE(PROF_LOADSTATE);
+    static_assert(scenario_index.valid, "scenario_items keywords are not distinct");
     char *line;
 
     while(oapiReadScenario_nextline(scn, line)){
-        if(!strncasecmp(line, "GEAR", 4)){
-            sscanf(line+4, "%d%lf", (int *)&landing_gear_status, &landing_gear_proc);
-            SetAnimation(anim_landing_gear, landing_gear_proc);
-        } else if (!strncasecmp(line, "DOOR", 4)){
-            sscanf(line+4, "%d%lf", (int *)&door_status, &door_proc);
-            SetAnimation(anim_door, door_proc);
-        } else {
-            ParseScenarioLineEx(line, vs);
-        }
+        ScenarioLine values(line);
+        size_t n;
+        const char *kw = values.Word(n);
+        int i = n ? scenario_index.Find(scenario_items, kw, n) : -1;
+        if(i >= 0) scenario_items[i].load(*this, values);
+        else ParseScenarioLineEx(line, vs);
     }
 }
 
+//One line per item, or with compact_state one XB70STATE record holding
+//every item that fits in it (the others still get their line).
 void XB70::clbkSaveState(FILEHANDLE scn){
 
-    char cbuf[256];
+    XB70_PROFILE_SCOPE(PROF_SAVESTATE);
+    ScenarioWriter record(true);
 
     SaveDefaultState(scn);
-    sprintf(cbuf, "%d %0.4f", landing_gear_status, landing_gear_proc);
-    oapiWriteScenario_string(scn, "GEAR", cbuf);
-    
-    sprintf(cbuf, "%d %0.4f", door_status, door_proc);
-    oapiWriteScenario_string(scn, "DOOR", cbuf);
+    for(const ScenarioItem &item : scenario_items){
+        if(compact_state){
+            size_t mark = record.BeginItem(item.keyword);
+            bool saved = item.save(*this, record);
+            if(saved) record.EndItem(mark);
+            if(saved && !record.Failed()) continue;
+            record.Rewind(mark);
+            if(!saved) continue;
+        }
+        ScenarioWriter line;
+        if(item.save(*this, line) && !line.Failed())
+            oapiWriteScenario_string(scn, (char *)item.keyword, (char *)line.Str());
+    }
+    if(record.Size()){
+        char text[4 * ((SCENARIO_RECORD_MAX + 2) / 3) + 1];
+        Base64Encode(record.Data(), record.Size(), text);
+        oapiWriteScenario_string(scn, (char *)"XB70STATE", text);
+    }
+}
+
+//<status> <position>; a missing or invalid status reads as ACT_AT0.
+void XB70::LoadActuator(int id, ScenarioLine &values){
+    Actuator &a = actuators[id];
+    int status = ACT_AT0;
+    double proc = 0.0;
+    values.Int(status) && values.Float(proc);
+    a.proc = std::min(1.0, std::max(0.0, proc));
+    ActivateActuator(id, (status >= ACT_AT0 && status <= ACT_TO1) ? status : ACT_AT0);
+    SetAnimation(a.anim, a.proc);
+    a.shown = a.proc;
+    if(id == ACT_GEAR) UpdateTouchdownPoints();
+}
+
+bool XB70::SaveActuator(int id, ScenarioWriter &values) const{
+    values.Int(actuators[id].status).Float(actuators[id].proc);
+    return true;
+}
+
+//Dispatches the items of a compact record as if each had its own line.
+//Items this version does not know are skipped, and so is an XB70STATE item
+//inside the record, which would only re-enter here on binary data; a
+//damaged record is ignored.
+void XB70::LoadCompactState(ScenarioLine &values){
+    size_t n;
+    const char *text = values.Word(n);
+    char record[SCENARIO_RECORD_MAX];
+    long size = Base64Decode(text, n, record, sizeof(record));
+    if(size < 0){
+        oapiWriteLogV("XB70: damaged XB70STATE record ignored");
+        return;
+    }
+    const unsigned char *p = (const unsigned char *)record, *end = p + size;
+    //Each length byte is only read once it is known to be in the record.
+    while(end - p >= 2 && end - p >= 2 + p[0] && end - p >= 2 + p[0] + p[1 + p[0]]){
+        const char *kw = (const char *)p + 1;
+        size_t kwlen = p[0];
+        const char *data = kw + kwlen + 1;
+        size_t len = p[1 + kwlen];
+        int i = scenario_index.Find(scenario_items, kw, kwlen);
+        if(i >= 0 && strcmp(scenario_items[i].keyword, "XB70STATE")){
+            ScenarioLine item(data, len);
+            scenario_items[i].load(*this, item);
+        }
+        p = (const unsigned char *)data + len;
+    }
 }
 
 
 /////////////Logic for gear and door
 
 void XB70::SetGearDown(void){
+    LandingGearStatus landing_gear_status = GetLandingGearStatus();
     ActivateLandingGear((landing_gear_status == GEAR_DOWN || landing_gear_status == GEAR_DEPLOYING) ?
         GEAR_STOWING : GEAR_DEPLOYING);
 }
 
 void XB70::CloseDoor(void){
+    DoorStatus door_status = GetDoorStatus();
     ActivateDoor((door_status == DOOR_CLOSED || door_status == DOOR_CLOSING) ?
         DOOR_OPENING : DOOR_CLOSING);
 }
 
 void XB70::DeployNoseCone(void){
+    NoseConeStatus nosecone_status = GetNoseConeStatus();
     ActivateNoseCone((nosecone_status == NOSEC_DEPLOYED || nosecone_status == NOSEC_DEPLOYING) ?
     NOSEC_STOWING : NOSEC_DEPLOYING);
 }
 
 void XB70::ActivateNoseCone(NoseConeStatus action){
-    nosecone_status = action;
+    ActivateActuator(ACT_NOSECONE, action);
 }
 
 void XB70::ActivateLandingGear(LandingGearStatus action){
-    landing_gear_status = action;
+    ActivateActuator(ACT_GEAR, action);
 }
 
 void XB70::ActivateDoor(DoorStatus actiondoor){
-    door_status = actiondoor;
+    ActivateActuator(ACT_DOOR, actiondoor);
+}
+
+void XB70::ActivateActuator(int id, int action){
+    actuators[id].status = action;
+    actuators[id].target = (action == ACT_AT1 || action == ACT_TO1) ? 1.0 : 0.0;
+    if(action >= ACT_TO0) actuators_moving |= 1u << id;
+    else actuators_moving &= ~(1u << id);
+}
+
+//Sends an actuator to an intermediate position.
+void XB70::MoveActuator(int id, double target){
+    Actuator &a = actuators[id];
+    a.target = target;
+    if(a.proc == target){
+        a.status = target >= 1.0 ? ACT_AT1 : ACT_AT0;
+        actuators_moving &= ~(1u << id);
+    } else {
+        a.status = target < a.proc ? ACT_TO0 : ACT_TO1;
+        actuators_moving |= 1u << id;
+    }
+}
+
+/////////////Wingtip droop
+
+void XB70::SetDroopMode(DroopMode mode){
+    droop_mode = mode;
+    if(mode != DROOP_AUTO){
+        droop_pos = mode - DROOP_UP;
+        MoveActuator(ACT_DROOP, DROOP_ANGLE[droop_pos] / DROOP_ANGLE[NDROOP - 1]);
+    }
+}
+
+void XB70::CycleDroopMode(void){
+    SetDroopMode((DroopMode)((droop_mode + 1) % (DROOP_DOWN + 1)));
+}
+
+double XB70::GetDroopAngle(void) const{
+    return actuators[ACT_DROOP].proc * DROOP_ANGLE[NDROOP - 1];
+}
+
+//Automatic schedule: tips up below Mach 0.95, half down (25 deg) through the
+//transonic range, fully down (65 deg) above Mach 1.45. Each boundary has a
+//0.05 Mach hysteresis band so the tips do not hunt around it.
+void XB70::UpdateDroopSchedule(void){
+    if(droop_mode != DROOP_AUTO) return;
+
+    static const double MACH_DOWN[NDROOP - 1] = {0.95, 1.45};
+    double M = flight.mach;
+    int pos = droop_pos;
+    if(pos < NDROOP - 1 && M > MACH_DOWN[pos]) pos++;
+    else if(pos > 0 && M < MACH_DOWN[pos - 1] - 0.05) pos--;
+    if(pos != droop_pos){
+        droop_pos = pos;
+        MoveActuator(ACT_DROOP, DROOP_ANGLE[pos] / DROOP_ANGLE[NDROOP - 1]);
+    }
+}
+
+//Blends the per-position tables bracketing the current droop angle into the
+//vessel's airfoil tables. Called when the droop animation is updated, i.e.
+//at most once per actuator threshold step.
+void XB70::UpdateDroopAero(void){
+    double angle = GetDroopAngle();
+    int k = 0;
+    while(k < NDROOP - 2 && angle > DROOP_ANGLE[k + 1]) k++;
+    double w = std::min(1.0, std::max(0.0, (angle - DROOP_ANGLE[k]) / (DROOP_ANGLE[k + 1] - DROOP_ANGLE[k])));
+
+    aero.vlift.Blend(vlift_table[k], vlift_table[k + 1], w);
+    aero.vlift_delta.Blend(vlift_delta[k], vlift_delta[k + 1], w);
+    aero.hlift.Blend(hlift_table[k], hlift_table[k + 1], w);
+    aero.hlift_delta.Blend(hlift_delta[k], hlift_delta[k + 1], w);
+    aero.compression = COMPRESSION_LIFT[k] + (COMPRESSION_LIFT[k + 1] - COMPRESSION_LIFT[k]) * w;
 }
 
 ///////////Giving life to animations
 
 void XB70::clbkPostStep(double simt, double simdt, double mjd){
-    UpdateLandingGearAnimation(simdt);
-    UpdateNoseConeAnimation(simdt);
-    UpdateDoorAnimation(simdt);
-    lvl = UpdateLvlSndBarrier();
-    lvlcontrailcanards = UpdateLvlCanardsEffect();
+    XB70_PROFILE_SCOPE(PROF_POSTSTEP);
+    unsigned int due = scheduler.Due(simt);
+    //The table reloads and the recorder read the flight state during a
+    //replay too.
+    flight.mach = GetMachNumber();
+    flight.altitude = GetAltitude();
+    flight.dynp = GetDynPressure();
+    flight.density = GetAtmDensity();
+    if(replay.IsOpen()){
+        //The recording stands in for everything but the table reloads and
+        //the level of detail.
+        ReplayStep(simt);
+        due &= (1u << SUB_TABLES) | (1u << SUB_LOD);
+    }
+
+    if(due & (1u << SUB_TABLES)) PollTables(simt);
+    if(due & (1u << SUB_ENGINE_RATING)) UpdateEngineRating();
+    if(due & (1u << SUB_ENGINE_ISP)) UpdateEngineIsp();
+    if(due & (1u << SUB_DROOP)) UpdateDroopSchedule();
+    if(due & (1u << SUB_ACTUATORS)) UpdateActuators(simdt);
+    if(due & (1u << SUB_SNDBARRIER)) lvl = UpdateLvlSndBarrier();
+    if(due & (1u << SUB_CONTRAILS)) lvlcontrailcanards = UpdateLvlCanardsEffect();
+    if(due & (1u << SUB_LOD)) UpdateLod();
+    if(due & (1u << SUB_RECORDER)) RecordStep(simt);
+#ifdef XB70_PROFILE
+    ProfileOverlay(simt);
+#endif
 }
 
 //////////////////////////Functions for gear, door, and Mach 1 contrail effect.
 
-void XB70::UpdateLandingGearAnimation(double simdt) {
-    if (landing_gear_status >= GEAR_DEPLOYING) {
-        double da = simdt * LANDING_GEAR_OPERATING_SPEED;
-        if (landing_gear_status == GEAR_DEPLOYING) {
-            if (landing_gear_proc > 0.0) landing_gear_proc = std::max(0.0, landing_gear_proc - da);
-            else landing_gear_status = GEAR_DOWN;
-            SetTouchdownPoints(tdvtx_geardown, ntdvtx_geardown);
-        } else {
-            if (landing_gear_proc < 1.0) landing_gear_proc = std::min(1.0, landing_gear_proc + da);
-            else landing_gear_status = GEAR_UP;
-            SetTouchdownPoints(tdvtx_gearup, ntdvtx_gearup);
+//Advances the travelling actuators only; with all parts idle this is a
+//single test. SetAnimation is called once a part has moved by its threshold
+//and when it reaches its end position.
+void XB70::UpdateActuators(double simdt) {
+    if (!actuators_moving) return;
+    for (int i = 0; i < NACTUATOR; i++) {
+        if (!(actuators_moving & (1u << i))) continue;
+        Actuator &a = actuators[i];
+        const ActuatorSpec &spec = actuator_spec[i];
+        bool arrived = StepActuator(a, spec, simdt);
+        if (arrived) actuators_moving &= ~(1u << i);
+        if (arrived || fabs(a.proc - a.shown) >= spec.threshold) {
+            SetAnimation(a.anim, a.proc);
+            a.shown = a.proc;
+            if (i == ACT_DROOP) UpdateDroopAero();
         }
-        SetAnimation(anim_landing_gear, landing_gear_proc);
+        if (i == ACT_GEAR) UpdateTouchdownPoints();
     }
 }
 
-void XB70::UpdateDoorAnimation(double simdt) {
-    if (door_status >= DOOR_CLOSING) {
-        double da = simdt * LANDING_GEAR_OPERATING_SPEED;
-        if (door_status == DOOR_CLOSING) {
-            if (door_proc > 0.0) door_proc = std::max(0.0, door_proc - da);
-            else door_status = DOOR_CLOSED;
-        } else {
-            if (door_proc < 1.0) door_proc = std::min(1.0, door_proc + da);
-            else door_status = DOOR_OPEN;
-        }
-        SetAnimation(anim_door,door_proc);
+//Applies the touchdown points for the current gear state, but only when the
+//set actually changes: the gear-down set while the gear is down or deploying,
+//the gear-up set while it is up or stowing. In interpolated mode the three
+//gear points follow landing_gear_proc during travel and are re-applied only
+//after moving TOUCHDOWN_UPDATE_DIST.
+void XB70::UpdateTouchdownPoints(void){
+    int landing_gear_status = actuators[ACT_GEAR].status;
+    double landing_gear_proc = actuators[ACT_GEAR].proc;
+    bool moving = (landing_gear_status >= GEAR_DEPLOYING);
+
+    if (touchdown_interpolate && moving) {
+        if (touchdown_set == TDSET_TRANSIT &&
+            fabs(landing_gear_proc - touchdown_proc) * touchdown_travel < TOUCHDOWN_UPDATE_DIST) return;
+        for (int i = 0; i < 3; i++)
+            tdvtx_transit[i].pos = tdvtx_geardown[i].pos + (tdvtx_gearstowed[i] - tdvtx_geardown[i].pos) * landing_gear_proc;
+        SetTouchdownPoints(tdvtx_transit, ntdvtx_geardown);
+        touchdown_set = TDSET_TRANSIT;
+        touchdown_proc = landing_gear_proc;
+        return;
+    }
+
+    bool down = (landing_gear_status == GEAR_DOWN || landing_gear_status == GEAR_DEPLOYING);
+    TouchdownSet set = down ? TDSET_GEARDOWN : TDSET_GEARUP;
+    if (set == touchdown_set) return;
+    if (down) SetTouchdownPoints(tdvtx_geardown, ntdvtx_geardown);
+    else SetTouchdownPoints(tdvtx_gearup, ntdvtx_gearup);
+    touchdown_set = set;
+}
+
+//Shows the mesh level that matches the vessel's apparent radius on screen
+//(the camera aperture is the vertical half angle). From the cockpit, or
+//anywhere inside the vessel's radius, it is always the full mesh. The full
+//textures follow the first level switch, with the same hysteresis.
+void XB70::UpdateLod(void){
+    VECTOR3 cam, pos;
+    oapiCameraGlobalPos(&cam);
+    GetGlobalPos(pos);
+    double dist = length(cam - pos);
+    int lod = 0;
+    bool full = true;
+    if (dist > class_config.size) {
+        DWORD w, h;
+        oapiGetViewportSize(&w, &h);
+        double pixels = class_config.size / (dist * tan(oapiCameraAperture())) * 0.5 * h;
+        while (lod < nlod - 1 && pixels < LOD_PIXELS[lod] * (lod < lod_shown ? 1.0 + LOD_HYSTERESIS : 1.0)) lod++;
+        full = pixels >= LOD_PIXELS[0] * (tex_full ? 1.0 : 1.0 + LOD_HYSTERESIS);
     }
+    SetTextureDetail(full || !class_config.texture_streaming);
+    if (lod == lod_shown) return;
+    SetMeshVisibilityMode(lod_shown, MESHVIS_NEVER);
+    SetMeshVisibilityMode(lod, MESHVIS_EXTERNAL);
+    lod_shown = lod;
+}
+
+//Re-rates the engines for the current Mach number and density altitude.
+void XB70::UpdateEngineRating(void){
+    const EngineTable *table = engine_table.Get();
+    if (table) engine.Set(*table, flight.mach, DensityAltitude(flight.density),
+        class_config.dry_thrust, class_config.afterburner_thrust);
+    if (fabs(engine.reheat_thrust - engine_max0) <= ENGINE_TOLERANCE * engine_max0) return;
+    for (int i = 0; i < XB70_NENGINE; i++) SetThrusterMax0(th_main[i], engine.reheat_thrust);
+    engine_max0 = engine.reheat_thrust;
+}
+
+//Sets the Isp that burns the dry and reheat fuel flows of the thrust at the
+//current throttle level.
+void XB70::UpdateEngineIsp(void){
+    double isp = engine.Isp(GetThrusterGroupLevel(THGROUP_MAIN));
+    if (fabs(isp - engine_isp) <= ENGINE_TOLERANCE * isp) return;
+    for (int i = 0; i < XB70_NENGINE; i++) SetThrusterIsp(th_main[i], isp);
+    engine_isp = isp;
 }
 
-void XB70::UpdateNoseConeAnimation(double simdt){
+//Opens FlightData/<vessel>-<date>-<time>.fdr with the channels listed in
+//the class config (all if none). Unknown names are logged and skipped.
+void XB70::StartRecorder(void){
+    const int nspec = sizeof(recorder_channel_spec) / sizeof(recorder_channel_spec[0]);
+    recorder_channels.clear();
+    char names[sizeof(class_config.recorder_channels)];
+    strcpy(names, class_config.recorder_channels);
+    for(char *name = strtok(names, " \t,"); name; name = strtok(0, " \t,")){
+        int i = 0;
+        while(i < nspec && strcasecmp(name, recorder_channel_spec[i].name)) i++;
+        if(i < nspec) recorder_channels.push_back(i);
+        else oapiWriteLogV("XB70: unknown flight data channel %s", name);
+    }
+    if(recorder_channels.empty())
+        for(int i = 0; i < nspec; i++) recorder_channels.push_back(i);
+
+    std::vector<RecorderChannel> channels(recorder_channels.size());
+    for(size_t k = 0; k < channels.size(); k++){
+        const RecorderChannelSpec &spec = recorder_channel_spec[recorder_channels[k]];
+        snprintf(channels[k].name, sizeof(channels[k].name), "%s", spec.name);
+        snprintf(channels[k].unit, sizeof(channels[k].unit), "%s", spec.unit);
+    }
+
+    char path[256], stamp[32];
+    time_t now = time(0);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+    snprintf(path, sizeof(path), "FlightData/%s-%s.fdr", GetName(), stamp);
+    if(recorder.Open(path, channels, class_config.recorder_decimation))
+        oapiWriteLogV("XB70: recording %d channels to %s", (int)channels.size(), path);
+    else
+        oapiWriteLogV("XB70: cannot record flight data to %s", path);
+}
 
-    if (nosecone_status >= NOSEC_DEPLOYING) {
-            double da = simdt * LANDING_GEAR_OPERATING_SPEED;
-            if (nosecone_status == NOSEC_DEPLOYING) {
-                if (nosecone_proc > 0.0) nosecone_proc = std::max(0.0, nosecone_proc - da);
-                else nosecone_status = NOSEC_DEPLOYED;
-            } else {
-                if (nosecone_proc < 1.0) nosecone_proc = std::min(1.0, nosecone_proc + da);
-                else nosecone_status = NOSEC_STOWED;
-            }
-            SetAnimation(anim_nosecone, nosecone_proc);
+//Samples the recorder channels into the next record, if one is due.
+void XB70::RecordStep(double simt){
+    float *value = recorder.Begin(simt);
+    if(!value) return;
+    for(int i : recorder_channels) *value++ = (float)recorder_channel_spec[i].get(*this);
+    recorder.Commit();
+}
+
+//Plays a flight data recording from the next step on: the vessel shows the
+//recorded actuator positions, control surfaces, throttle and particle levels
+//at the current simulation time. Channels the recording lacks stay as they
+//are.
+bool XB70::StartReplay(const char *path){
+    if(!replay.Open(path)){
+        oapiWriteLogV("XB70: cannot replay %s", path);
+        return false;
+    }
+    int n = 0;
+    for(int t = 0; t < NREPLAYTARGET; t++)
+        if((replay_channel[t] = replay.Channel(replay_channel_name[t])) >= 0) n++;
+    for(int t = 0; t < NREPLAYTARGET; t++) replay_value[t] = NAN;
+    actuators_moving = 0;
+    oapiWriteLogV("XB70: replaying %s, %.1f to %.1f s, %d of %d channels", path,
+        replay.StartTime(), replay.EndTime(), n, (int)NREPLAYTARGET);
+    return true;
+}
+
+//Back to simulation: actuators caught in travel finish it.
+void XB70::StopReplay(void){
+    replay.Close();
+    for(int i = 0; i < NACTUATOR; i++)
+        if(actuators[i].status >= ACT_TO0) MoveActuator(i, actuators[i].status == ACT_TO1 ? 1.0 : 0.0);
+}
+
+//Drives the vessel from the recording at simt. As in simulation, only the
+//actuators that move are updated, and they are shown with the same
+//thresholds; their status follows the direction of the recorded movement.
+void XB70::ReplayStep(double simt){
+    replay.Seek(simt);
+    for(int i = 0; i < NACTUATOR; i++){
+        if(replay_channel[i] < 0) continue;
+        Actuator &a = actuators[i];
+        double proc = replay.Value(replay_channel[i]);
+        if(i == ACT_DROOP) proc /= DROOP_ANGLE[NDROOP - 1];
+        proc = std::min(1.0, std::max(0.0, proc));
+        if(proc == a.proc) continue;
+        if(proc <= 0.0 || proc >= 1.0) a.status = proc >= 1.0 ? ACT_AT1 : ACT_AT0;
+        else a.status = proc > a.proc ? ACT_TO1 : ACT_TO0;
+        a.proc = a.target = proc;
+        if(fabs(a.proc - a.shown) >= actuator_spec[i].threshold || (a.proc != a.shown && a.status < ACT_TO0)){
+            SetAnimation(a.anim, a.proc);
+            a.shown = a.proc;
+            if(i == ACT_DROOP) UpdateDroopAero();
         }
+        if(i == ACT_GEAR) UpdateTouchdownPoints();
+    }
+    //The rest is only passed on once it moved by REPLAY_TOLERANCE.
+    for(int t = RPL_ELEVATOR; t < NREPLAYTARGET; t++){
+        if(replay_channel[t] < 0) continue;
+        double value = replay.Value(replay_channel[t]);
+        if(fabs(value - replay_value[t]) < REPLAY_TOLERANCE) continue;
+        replay_value[t] = value;
+        if(t <= RPL_RUDDER) SetControlSurfaceLevel(replay_ctrl_type[t - RPL_ELEVATOR], value);
+        else if(t == RPL_THROTTLE) SetThrusterGroupLevel(THGROUP_MAIN, value);
+        else if(t == RPL_SNDBARRIER) lvl = value;
+        else lvlcontrailcanards = value;
+    }
+}
+
+//Puts the full textures or the mip tails on the full-detail mesh of the
+//visual. The reduced levels always keep the mip tails of their templates.
+//Acquiring the full textures loads them synchronously (see XB70MeshCache.h).
+void XB70::SetTextureDetail(bool full){
+    if (full == tex_full || !visual) return;
+    DEVMESHHANDLE devmesh = GetDevMesh(visual, 0);
+    if (!devmesh) return;
+    if (full) AcquireFullTextures(lod_mesh[0]);
+    DWORD n = MeshTextureCount(lod_mesh[0]);
+    for (DWORD i = 1; i <= n; i++) oapiSetTexture(devmesh, i, MeshTexture(lod_mesh[0], i, full));
+    if (!full) ReleaseFullTextures(lod_mesh[0]);
+    tex_full = full;
 }
 
 double XB70::UpdateLvlSndBarrier(){
     
-    double machnumber = GetMachNumber();
+    double machnumber = flight.mach;
 
     if((machnumber >= 0.999) && (machnumber <= 1.001)){
         return 1.0;
@@ -568,8 +1093,8 @@ double XB70::UpdateLvlSndBarrier(){
 
 double XB70::UpdateLvlCanardsEffect(){
 
-    double machnumber = GetMachNumber();
-    double altitude = GetAltitude();
+    double machnumber = flight.mach;
+    double altitude = flight.altitude;
 
     if((machnumber > 2) && (altitude > 15000)){
         return 1.0;
@@ -581,6 +1106,22 @@ double XB70::UpdateLvlCanardsEffect(){
 
 int XB70::clbkConsumeBufferedKey(int key, bool down, char *kstate){
 
+    XB70_PROFILE_SCOPE(PROF_KEY);
+#ifdef XB70_PROFILE
+    if(key == OAPI_KEY_P && down){
+        ToggleProfileOverlay();
+        return 1;
+    }
+#endif
+    //During a replay the recording moves the parts; R hands the aircraft
+    //back to the simulation where the replay stands.
+    if(replay.IsOpen()){
+        if(key == OAPI_KEY_R && down){
+            StopReplay();
+            return 1;
+        }
+        return 0;
+    }
     if(key == OAPI_KEY_G && down){
         SetGearDown();
         return 1;
@@ -593,16 +1134,47 @@ int XB70::clbkConsumeBufferedKey(int key, bool down, char *kstate){
         DeployNoseCone();
         return 1;
     }
+    if(key == OAPI_KEY_W && down){
+        CycleDroopMode();
+        return 1;
+    }
     return 0;
 }
 
 
+//The visual is built from the mesh templates, so it starts with the mip
+//tails; UpdateLod loads the full textures when they are needed.
+void XB70::clbkVisualCreated(VISHANDLE vis, int refcount){
+    visual = vis;
+    tex_full = false;
+    UpdateLod();
+}
+
+void XB70::clbkVisualDestroyed(VISHANDLE vis, int refcount){
+    if(tex_full) ReleaseFullTextures(lod_mesh[0]);
+    tex_full = false;
+    visual = 0;
+}
+
 DLLCLBK void InitModule(MODULEHANDLE hModule){
 
+    for(const WatchedTable &t : watched_tables) LoadWatchedTable(t);
+    table_watch.Watch(TABLE_DIR);
+
 }
 
 DLLCLBK void ExitModule(MODULEHANDLE *hModule){
 
+    table_watch.Close();
+    table_poll_simt = -1e10;
+    vlift_db.Clear();
+    hlift_db.Clear();
+    engine_table.Clear();
+
+    //Read the class config again in the next session.
+    class_config = XB70Config();
+    class_config_loaded = false;
+
 }
 
 
@@ -619,5 +1191,8 @@ DLLCLBK VESSEL *ovcInit(OBJHANDLE hvessel, int flightmodel){
 DLLCLBK void ovcExit(VESSEL *vessel){
     
     if(vessel) delete(XB70*)vessel;
+#ifdef XB70_PROFILE
+    ProfileDump();
+#endif
 
 }
\ No newline at end of file
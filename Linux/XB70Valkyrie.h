@@ -6,37 +6,21 @@
 #include "Orbitersdk.h"
 #include "VesselAPI.h"
 #include "XB70_mesh_definitions.h"
-
-//Vessel parameters
-const double XB70_SIZE = 22.8;  //Mean radius in meters.
-
-const double XB70_EMPTYMASS = 115031; //Empty mass in kg.
-
-const double XB70_FUELMASS = 140000; //Fuel mass in kg.
-
-const double XB70_ISP = 2e4; //Fuel-specific impulse in m/s.
-
-const double XB70_MAXMAINTH = 89e3; //Max main thrust in kN.
-
-const double XB70_AFTERBRNTH = 30e4;//120e3; //Max afterburner thrust.
-
-const double LANDING_GEAR_OPERATING_SPEED = 0.06;
-
-const VECTOR3 XB70_CS = {181.48, 642.24, 46.93};
-
-const VECTOR3 XB70_PMI = {245.53, 260.68, 46.93};
-
-const double XB70_VLIFT_C = 23.94; //Chord lenght in meters;
-
-const double XB70_VLIFT_S = 585.07; //Wing area in m^2;
-
-const double XB70_VLIFT_A = 1.751; //Wing aspect ratio;
-
-const double XB70_HLIFT_C = 2.79; //Chord lenght in meters;
-
-const double XB70_HLIFT_S = 17.76; //Wing area in m^2;
-
-const double XB70_HLIFT_A = 1; //Wing aspect ratio;
+#include "XB70Actuators.h"
+#include "XB70Animations.h"
+#include "XB70AeroTables.h"
+#include "XB70Config.h"
+#include "XB70Engine.h"
+#include "XB70HotReload.h"
+#include "XB70Recorder.h"
+#include "XB70Replay.h"
+#include "XB70Scenario.h"
+#include "XB70Scheduler.h"
+#include <vector>
+
+class AeroDatabase;
+
+//Vessel parameters: see XB70Config.h (defaults) and the class config file.
 
 /*
 const double wing_area = 585.0;                    //wing area [sq. m]
@@ -90,13 +74,122 @@ static TOUCHDOWNVTX tdvtx_gearup[ntdvtx_gearup] = {
     {(TDP_pitot_probe_Location), 5e6, 5e6, 3.0},
 };
 
+//Airfoil coefficient callbacks
+
+void VLiftCoeff(VESSEL *v, double aoa, double M, double Re, void *context, double *cl, double *cm, double *cd);
+void HLiftCoeff(VESSEL *v, double beta, double M, double Re, void *context, double *cl, double *cm, double *cd);
+
+//Per-vessel aerodynamic state, handed to both airfoils as the CreateAirfoil3
+//context. The droop-dependent parts are blended from the per-position tables
+//when the wingtips move (XB70::UpdateDroopAero), never inside the callbacks.
+struct XB70Aero{
+    XB70Aero(const AeroTable<2> &vl, const AeroTable<2> &vld, const AeroTable<1> &hl, const AeroTable<1> &hld) :
+        vdb(0), hdb(0), vlift(vl), vlift_delta(vld), hlift(hl), hlift_delta(hld), compression(0.0),
+        cl(0.0), cm(0.0), cd(0.0) {}
+
+    const TableSlot<AeroDatabase> *vdb;    //Mach databases; empty to use the built-in tables
+    const TableSlot<AeroDatabase> *hdb;
+    AeroTable<2> vlift;             //Built-in CL/CM vs AoA at the current droop
+    AeroTable<2> vlift_delta;       //Droop increment added to the vdb lookup
+    AeroTable<1> hlift;             //Built-in CL vs beta at the current droop
+    AeroTable<1> hlift_delta;       //Droop increment added to the hdb lookup
+    double compression;             //Compression lift gain, reached at Mach 2
+    mutable double cl, cm, cd;      //Last VLiftCoeff result, for the flight recorder
+};
+
+//Gear contact points with the gear retracted (raised to the belly line).
+//Used to interpolate the first three tdvtx_geardown points during gear travel.
+static const VECTOR3 tdvtx_gearstowed[3] = {
+    {TDP_Front_landing_gear_Location.x, TDP_Front_Location.y, TDP_Front_landing_gear_Location.z},
+    {TDP_Rear_right_landing_gear_Location.x, TDP_Rear_right_Location.y, TDP_Rear_right_landing_gear_Location.z},
+    {TDP_Rear_left_landing_gear_Location.x, TDP_Rear_left_Location.y, TDP_Rear_left_landing_gear_Location.z},
+};
+
+//Mesh levels of detail (see XB70Valkyrie.cpp for the mesh names). Level k+1
+//replaces level k once the vessel's apparent radius drops below
+//LOD_PIXELS[k] pixels; switching back needs LOD_HYSTERESIS more.
+const int XB70_NLOD = 3;
+
+const double LOD_PIXELS[XB70_NLOD - 1] = {120.0, 25.0};
+
+const double LOD_HYSTERESIS = 0.15;
+
+//Engines. The thrust ratings follow Mach number and density altitude, which
+//change slowly: the engine table is evaluated every ENGINE_UPDATE_INTERVAL
+//[s] (subsystem_period). The Isp follows the throttle (dry or reheat fuel flow). Either is only
+//passed to the thrusters once it changed by more than ENGINE_TOLERANCE
+//(relative).
+const int XB70_NENGINE = 6;
+
+const double ENGINE_UPDATE_INTERVAL = 0.5;
+
+const double ENGINE_TOLERANCE = 0.005;
+
+//Smallest change of a replayed control surface, throttle or particle level
+//passed on to the vessel.
+const double REPLAY_TOLERANCE = 1e-3;
+
+//Interpolate the gear contact points during gear travel instead of switching
+//between the gear-down and gear-up sets at the start of the travel.
+const bool TOUCHDOWN_INTERPOLATE = false;
+
+//Minimum gear contact point movement [m] before the interpolated touchdown
+//points are re-applied.
+const double TOUCHDOWN_UPDATE_DIST = 0.05;
+
 //XB70 class interface
 
 class XB70: public VESSEL4{
     public:
-        enum LandingGearStatus{GEAR_DOWN, GEAR_UP, GEAR_DEPLOYING, GEAR_STOWING} landing_gear_status;
-        enum DoorStatus{DOOR_CLOSED, DOOR_OPEN, DOOR_CLOSING, DOOR_OPENING} door_status;
-        enum NoseConeStatus{NOSEC_DEPLOYED, NOSEC_STOWED, NOSEC_DEPLOYING, NOSEC_STOWING} nosecone_status;
+        //Same values as ActuatorStatus
+        enum LandingGearStatus{GEAR_DOWN, GEAR_UP, GEAR_DEPLOYING, GEAR_STOWING};
+        enum DoorStatus{DOOR_CLOSED, DOOR_OPEN, DOOR_CLOSING, DOOR_OPENING};
+        enum NoseConeStatus{NOSEC_DEPLOYED, NOSEC_STOWED, NOSEC_DEPLOYING, NOSEC_STOWING};
+
+        //Moving parts, indices into actuator_spec and actuators
+        enum ActuatorId{ACT_GEAR, ACT_DOOR, ACT_NOSECONE, ACT_DROOP, NACTUATOR};
+
+        //Mesh animations. The actuator animations come first, in ActuatorId order.
+        enum AnimId{ANIM_GEAR, ANIM_DOOR, ANIM_NOSECONE, ANIM_DROOP,
+            ANIM_ELEVATORTRIM, ANIM_LAILERON, ANIM_RAILERON, ANIM_ELEVATOR, ANIM_CANARDS,
+            ANIM_LRUDDER, ANIM_RRUDDER, NANIM};
+
+        //Rows of anim_component_spec (XB70Valkyrie.cpp)
+        static const int NANIMCOMP = 18;
+
+        //Work done in clbkPostStep, in call order. Rates in subsystem_period.
+        enum SubsystemId{SUB_TABLES, SUB_ENGINE_RATING, SUB_ENGINE_ISP, SUB_DROOP, SUB_ACTUATORS,
+            SUB_SNDBARRIER, SUB_CONTRAILS, SUB_LOD, SUB_RECORDER, NSUBSYSTEM};
+
+        //Flight data recorder channels: one row of recorder_channel_spec
+        //(XB70Valkyrie.cpp) each, selected by name in the class config.
+        struct RecorderChannelSpec{
+            const char *name;
+            const char *unit;
+            double (*get)(const XB70 &v);
+        };
+
+        //Custom scenario state: one row of scenario_items (XB70Valkyrie.cpp)
+        //per keyword. load reads the item's values, save writes them and
+        //returns false if the item has no state to keep. Both work on text
+        //lines and on the compact XB70STATE record alike.
+        struct ScenarioItem{
+            const char *keyword;
+            void (*load)(XB70 &v, ScenarioLine &values);
+            bool (*save)(const XB70 &v, ScenarioWriter &values);
+        };
+        static const int NSCENARIOITEM = 6;
+        static const size_t NSCENARIOSLOT = 16;     //Keyword index slots, a power of two
+
+        //What a replay drives, each from the recorder channel of the same
+        //row of replay_channel_name. The actuators come first, in ActuatorId
+        //order, then the control surfaces in replay_ctrl_type order.
+        enum ReplayTarget{RPL_GEAR, RPL_DOOR, RPL_NOSECONE, RPL_DROOP,
+            RPL_ELEVATOR, RPL_ELEVTRIM, RPL_AILERON, RPL_RUDDER,
+            RPL_THROTTLE, RPL_SNDBARRIER, RPL_CONTRAILS, NREPLAYTARGET};
+
+        //Wingtip droop: automatic Mach schedule or a fixed position (0, 25, 65 deg)
+        enum DroopMode{DROOP_AUTO, DROOP_UP, DROOP_MID, DROOP_DOWN};
 
         XB70(OBJHANDLE hVessel, int flightmodel);
         virtual ~XB70();
@@ -108,9 +201,37 @@ class XB70: public VESSEL4{
         void CloseDoor(void);
         void ActivateNoseCone(NoseConeStatus action);
         void DeployNoseCone(void);
-        void UpdateLandingGearAnimation(double);
-        void UpdateDoorAnimation(double);
-        void UpdateNoseConeAnimation(double);
+        void ActivateActuator(int id, int action);
+        void MoveActuator(int id, double target);
+        void SetDroopMode(DroopMode mode);
+        void CycleDroopMode(void);
+        void UpdateDroopSchedule(void);
+        void UpdateDroopAero(void);
+        DroopMode GetDroopMode(void) const {return droop_mode;}
+        double GetDroopAngle(void) const;
+        void UpdateActuators(double);
+        LandingGearStatus GetLandingGearStatus(void) const {return (LandingGearStatus)actuators[ACT_GEAR].status;}
+        DoorStatus GetDoorStatus(void) const {return (DoorStatus)actuators[ACT_DOOR].status;}
+        NoseConeStatus GetNoseConeStatus(void) const {return (NoseConeStatus)actuators[ACT_NOSECONE].status;}
+        void LoadActuator(int id, ScenarioLine &values);
+        bool SaveActuator(int id, ScenarioWriter &values) const;
+        void LoadCompactState(ScenarioLine &values);
+        void SetCompactState(bool compact) {compact_state = compact;}
+        bool GetCompactState(void) const {return compact_state;}
+        void UpdateTouchdownPoints(void);
+        void UpdateLod(void);
+        void UpdateEngineRating(void);
+        void UpdateEngineIsp(void);
+        void StartRecorder(void);
+        void RecordStep(double simt);
+        bool StartReplay(const char *path);
+        void StopReplay(void);
+        void ReplayStep(double simt);
+        bool IsReplaying(void) const {return replay.IsOpen();}
+        const EngineState &GetEngineState(void) const {return engine;}
+        int GetLod(void) const {return lod_shown;}
+        void SetTextureDetail(bool full);
+        bool GetTextureDetail(void) const {return tex_full;}
         double UpdateLvlSndBarrier();
         double UpdateLvlCanardsEffect();
 
@@ -119,29 +240,63 @@ class XB70: public VESSEL4{
         void clbkSaveState(FILEHANDLE scn)override;
         void clbkPostStep(double, double, double)override;
         int clbkConsumeBufferedKey(int, bool, char *)override;
+        void clbkVisualCreated(VISHANDLE vis, int refcount)override;
+        void clbkVisualDestroyed(VISHANDLE vis, int refcount)override;
 
         double lvl;
         double lvlcontrailcanards;
     
     private:
-        unsigned int anim_landing_gear;
-        unsigned int anim_door;
-        unsigned int anim_nosecone;
-        unsigned int anim_elevatortrim;
-        unsigned int anim_laileron;
-        unsigned int anim_raileron;
-        unsigned int anim_elevator;
-        unsigned int anim_canards;
-        unsigned int anim_lrudder;
-        unsigned int anim_rrudder;
-
-        double landing_gear_proc;
-        double door_proc;
-        double nosecone_proc;
+        static ActuatorSpec actuator_spec[NACTUATOR];   //Rates from the class config
+        Actuator actuators[NACTUATOR];
+        unsigned int actuators_moving;  //Bit i set while actuators[i] travels
+
+        DroopMode droop_mode;
+        int droop_pos;                  //Commanded droop position, index into DROOP_ANGLE
+        XB70Aero aero;
+
+        static const double subsystem_period[NSUBSYSTEM];
+        Scheduler<NSUBSYSTEM> scheduler;
+        FlightState flight;             //Queried once per step, before the subsystems run
+
+        static const ScenarioItem scenario_items[NSCENARIOITEM];
+        static const KeywordIndex<NSCENARIOSLOT> scenario_index;
+        bool compact_state;             //Save the custom state as one XB70STATE record
+
+        static const RecorderChannelSpec recorder_channel_spec[];
+        Recorder recorder;
+        std::vector<int> recorder_channels;     //Rows of recorder_channel_spec, in record order
+
+        static const char *const replay_channel_name[NREPLAYTARGET];
+        Replay replay;
+        int replay_channel[NREPLAYTARGET];      //Channel of the recording, -1 if not recorded
+        double replay_value[NREPLAYTARGET];     //Last value applied (control surfaces onwards)
+
+        static const double anim_initial[NANIM];
+        unsigned int anims[NANIM];      //Animation handles, indexed by AnimId
+        std::vector<MGROUP_ROTATE> anim_components;    //Reserved once, never reallocated
+        UINT anim_groups[NANIMCOMP][ANIM_MAXGRP];
+
+        //Touchdown point set currently applied, so SetTouchdownPoints is only
+        //called on real transitions.
+        enum TouchdownSet{TDSET_NONE, TDSET_GEARDOWN, TDSET_GEARUP, TDSET_TRANSIT} touchdown_set;
+        bool touchdown_interpolate;
+        double touchdown_proc;          //landing_gear_proc of the last transit update
+        double touchdown_travel;        //Largest gear contact point travel [m]
+        TOUCHDOWNVTX tdvtx_transit[ntdvtx_geardown];
+
+        THRUSTER_HANDLE th_main[XB70_NENGINE];
+        EngineState engine;             //Operating point of each engine
+        double engine_max0;             //Rating currently set on the thrusters
+        double engine_isp;              //Isp currently set on the thrusters
 
         AIRFOILHANDLE hwing;
         CTRLSURFHANDLE hlaileron, hraileron, canards;
-        MESHHANDLE valky_mesh;
+        MESHHANDLE lod_mesh[XB70_NLOD]; //Shared templates, see AcquireSharedMesh
+        int nlod;                       //Levels loaded; mesh index k is level k
+        int lod_shown;
+        VISHANDLE visual;
+        bool tex_full;                  //Full textures on the visual (else mip tails)
 
 };
 
@@ -3,6 +3,7 @@
 
 
 #include "Orbitersdk.h"
+#include "XB70_mesh_groups.h"
 
 #ifndef __XB70_MESH_DEFINITIONS_H
 #define __XB70_MESH_DEFINITIONS_H
@@ -16,39 +17,9 @@
     const int TXIDX_Aileron_dds = 6;
     constexpr auto MESH_NAME = "XB-70_Valkyrie";
 
-    const UINT Wing_detail1_Id = 0;
-    const UINT Windows_Id = 1;
-    const UINT Rear_wheels_rear_left_landing_gear_Id = 2;
-    const UINT Rear_left_landing_gear_Id = 3;
-    const UINT Pitot_probes_Id = 4;
-    const UINT Pitot_probe_Id = 5;
-    const UINT Front_wheels_landing_gear_Id = 6;
-    const UINT Front_landing_gear_Id = 7;
-    const UINT Fixed_canards_Id = 8;
-    const UINT Engines_Id = 9;
-    const UINT Engine_intake_Id = 10;
-    const UINT detail1_Id = 11;
-    const UINT Delta_wing_Id = 12;
-    const UINT Door_Id = 13;
-    const UINT Window_left_Id = 14;
-    const UINT Window_right_Id = 15;
-    const UINT Cylinder_Id = 16;
-    const UINT Canards_Id = 17;
-    const UINT Vertical_tails_Id = 18;
-    const UINT Delta_wing_right_Id = 19;
-    const UINT Delta_wing_left_Id = 20;
-    const UINT hraileron_Id = 21;
-    const UINT hlaileron_Id = 22;
-    const UINT RRudder_Id = 23;
-    const UINT LRudder_Id = 24;
-    const UINT Nose_cone_Id = 25;
-    const UINT Front_landing_gear_door2_Id = 26;
-    const UINT Front_landing_gear_door1_Id = 27;
-    const UINT Rear_landing_gear_doors_Id = 28;
-    const UINT Rear_landing_gear_left_door_Id = 29;
-    const UINT Rear_landing_gear_right_door_Id = 30;
-    const UINT Rear_wheels_rear_right_landing_gear_Id = 31;
-    const UINT Rear_right_landing_gear_Id = 32;
+    // Group Ids are generated from the mesh itself (XB70_mesh_groups.h). The
+    // locations below are the Blender object origins and empties.
+
     constexpr VECTOR3 Wing_detail1_Location =     {-0.0805, 1.0640, -19.7714};
     constexpr VECTOR3 Windows_Location =     {-0.0337, 2.2353, 21.7742};
     constexpr VECTOR3 Rear_wheels_rear_left_landing_gear_Location =     {-3.3236, -2.9489, -12.5063};
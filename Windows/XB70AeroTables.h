@@ -0,0 +1,129 @@
+#ifndef __XB70AEROTABLES_H
+#define __XB70AEROTABLES_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//Uniform-grid coefficient table.
+//
+//The airfoil callbacks are evaluated by Orbiter for every airfoil on every
+//sub-step, so the breakpoint tables used by VLiftCoeff/HLiftCoeff are resampled
+//once, at module load, onto a fixed-step grid. A lookup is then a scale, a
+//clamp and one multiply-add per channel, with no search and no branches.
+//
+//The grid step is the largest step that puts every breakpoint on a grid node
+//(bounded below by minstep), so for the piecewise-linear data used here the
+//resampled table reproduces the breakpoint interpolation exactly, outside
+//the breakpoints too: like the scan, a lookup below the first breakpoint
+//extrapolates the first interval and one above the last holds its value.
+//
+//NCH channels (e.g. CL and CM) share the same abscissa and are stored
+//interleaved per cell as {value, slope} pairs.
+//
+//(std::min)/(std::max) are parenthesised to survive the windows.h macros.
+
+template<int NCH>
+class AeroTable{
+    public:
+        AeroTable(const double *x, const double *const *y, int n, double minstep);
+
+        //O(1) lookup on the uniform grid.
+        inline void Eval(double x, double *out) const;
+
+        //Original breakpoint scan, kept as the reference for accuracy checks.
+        void EvalExact(double x, double *out) const;
+
+        int NumCells() const {return ncell;}
+        double Step() const {return step;}
+
+    private:
+        std::vector<double> bx;         //Breakpoints
+        std::vector<double> by;         //Breakpoint values, NCH per breakpoint
+        std::vector<double> cell;       //{value, slope} * NCH per cell, plus one pad cell
+        double x0;
+        double step;
+        double inv_step;
+        double umax;
+        int ncell;
+};
+
+template<int NCH>
+AeroTable<NCH>::AeroTable(const double *x, const double *const *y, int n, double minstep) :
+    bx(x, x + n), by(n * NCH){
+
+    for(int i = 0; i < n; i++)
+        for(int k = 0; k < NCH; k++)
+            by[i * NCH + k] = y[k][i];
+
+    //Largest step that divides every breakpoint interval (floating-point gcd).
+    double tol = minstep * 1e-3;
+    double g = 0.0;
+    for(int i = 1; i < n; i++){
+        double a = (std::max)(g, x[i] - x[i - 1]);
+        double b = (std::min)(g, x[i] - x[i - 1]);
+        while(b > tol){
+            double r = std::fmod(a, b);
+            if(b - r < tol) r = 0.0;
+            a = b;
+            b = r;
+        }
+        g = a;
+    }
+    step = (std::max)(g, minstep);
+
+    x0 = x[0];
+    ncell = (int)((x[n - 1] - x0) / step + 0.5);
+    inv_step = 1.0 / step;
+    umax = (double)ncell;
+
+    //ncell regular cells plus one pad cell with zero slope, so that a lookup
+    //at the upper bound (u == ncell) needs no special case.
+    cell.resize((ncell + 1) * 2 * NCH);
+    double node[NCH], next[NCH];
+    EvalExact(x0, node);
+    for(int i = 0; i < ncell; i++){
+        EvalExact(x0 + (i + 1) * step, next);
+        for(int k = 0; k < NCH; k++){
+            cell[(i * NCH + k) * 2]     = node[k];
+            cell[(i * NCH + k) * 2 + 1] = next[k] - node[k];
+            node[k] = next[k];
+        }
+    }
+    for(int k = 0; k < NCH; k++){
+        cell[(ncell * NCH + k) * 2]     = node[k];
+        cell[(ncell * NCH + k) * 2 + 1] = 0.0;
+    }
+}
+
+template<int NCH>
+inline void AeroTable<NCH>::Eval(double x, double *out) const{
+    //u is clamped above only, where the pad cell holds the last value.
+    //Below the grid the index stays at cell 0 and f < 0 extrapolates it.
+    //NaN passes the min, selects cell 0 and comes out as NaN, as from the
+    //scan.
+    double u = (std::min)((x - x0) * inv_step, umax);
+    int i = (int)(u > 0.0 ? u : 0.0);
+    double f = u - (double)i;
+    const double *c = &cell[i * 2 * NCH];
+    for(int k = 0; k < NCH; k++)
+        out[k] = c[2 * k] + c[2 * k + 1] * f;
+}
+
+template<int NCH>
+void AeroTable<NCH>::EvalExact(double x, double *out) const{
+    int n = (int)bx.size();
+    int i;
+    for (i = 0; i < n-1 && bx[i+1] < x; i++);
+    if (i < n - 1) {
+        double f = (x - bx[i]) / (bx[i + 1] - bx[i]);
+        for(int k = 0; k < NCH; k++)
+            out[k] = by[i * NCH + k] + (by[(i + 1) * NCH + k] - by[i * NCH + k]) * f;
+    }
+    else {
+        for(int k = 0; k < NCH; k++)
+            out[k] = by[(n - 1) * NCH + k];
+    }
+}
+
+#endif //!__XB70AEROTABLES_H
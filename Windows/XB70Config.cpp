@@ -0,0 +1,72 @@
+//Copyright (c) Matías Saibene
+//Licenced under the MIT Licence
+
+//==========================================
+//          ORBITER MODULE: XB70-Valkyrie
+//
+//XB70Config.cpp
+//Vessel class parameters from the class config file
+//
+//==========================================
+
+#include "XB70Config.h"
+#include <cstddef>
+
+namespace{
+
+enum ItemType{ITEM_FLOAT, ITEM_VEC};
+
+struct ConfigItem{
+    const char *key;
+    ItemType type;
+    size_t offset;              //Member of XB70Config
+};
+
+//Config file keys, as in Linux/XB70Config.cpp. Keys the Orbiter core reads
+//itself (MaxFuel, MaxMainThrust, ...) are avoided, so the core does not
+//build a second propellant resource or thruster from them.
+const ConfigItem config_items[] = {
+    {"Size",                    ITEM_FLOAT, offsetof(XB70Config, size)},
+    {"EmptyMass",               ITEM_FLOAT, offsetof(XB70Config, empty_mass)},
+    {"FuelMass",                ITEM_FLOAT, offsetof(XB70Config, fuel_mass)},
+    {"CrossSections",           ITEM_VEC,   offsetof(XB70Config, cs)},
+    {"WheelbrakeForce",         ITEM_FLOAT, offsetof(XB70Config, wheelbrake_force)},
+
+    {"EngineIsp",               ITEM_FLOAT, offsetof(XB70Config, isp)},
+    {"DryThrust",               ITEM_FLOAT, offsetof(XB70Config, dry_thrust)},
+
+    {"GearOperatingSpeed",      ITEM_FLOAT, offsetof(XB70Config, gear_speed)},
+    {"DoorOperatingSpeed",      ITEM_FLOAT, offsetof(XB70Config, door_speed)},
+
+    {"VLiftChord",              ITEM_FLOAT, offsetof(XB70Config, vlift_chord)},
+    {"VLiftArea",               ITEM_FLOAT, offsetof(XB70Config, vlift_area)},
+    {"VLiftAspectRatio",        ITEM_FLOAT, offsetof(XB70Config, vlift_aspect)},
+    {"VLiftEfficiency",         ITEM_FLOAT, offsetof(XB70Config, vlift_efficiency)},
+    {"HLiftChord",              ITEM_FLOAT, offsetof(XB70Config, hlift_chord)},
+    {"HLiftArea",               ITEM_FLOAT, offsetof(XB70Config, hlift_area)},
+    {"HLiftAspectRatio",        ITEM_FLOAT, offsetof(XB70Config, hlift_aspect)},
+    {"HLiftEfficiency",         ITEM_FLOAT, offsetof(XB70Config, hlift_efficiency)},
+
+    {"AileronArea",             ITEM_FLOAT, offsetof(XB70Config, aileron_area)},
+    {"AileronDCl",              ITEM_FLOAT, offsetof(XB70Config, aileron_dcl)},
+    {"CanardArea",              ITEM_FLOAT, offsetof(XB70Config, canard_area)},
+    {"CanardDCl",               ITEM_FLOAT, offsetof(XB70Config, canard_dcl)},
+    {"ElevatorArea",            ITEM_FLOAT, offsetof(XB70Config, elevator_area)},
+    {"ElevatorDCl",             ITEM_FLOAT, offsetof(XB70Config, elevator_dcl)},
+};
+
+} //namespace
+
+int XB70Config::Read(FILEHANDLE cfg){
+    int found = 0;
+    for(const ConfigItem &item : config_items){
+        char *member = (char *)this + item.offset;
+        bool ok = false;
+        switch(item.type){
+            case ITEM_FLOAT: ok = oapiReadItem_float(cfg, (char *)item.key, *(double *)member); break;
+            case ITEM_VEC:   ok = oapiReadItem_vec(cfg, (char *)item.key, *(VECTOR3 *)member); break;
+        }
+        if(ok) found++;
+    }
+    return found;
+}
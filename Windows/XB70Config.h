@@ -0,0 +1,46 @@
+#ifndef __XB70CONFIG_H
+#define __XB70CONFIG_H
+
+#include "OrbiterAPI.h"
+
+//Vessel class parameters.
+//
+//The part of Linux/XB70Config.h this module uses, under the same keys of the
+//class config file (Config/Vessels/XB-70_Valkyrie.cfg). The defaults are
+//this module's own values, which differ from the Linux tuning. The file is
+//read once per class, by the first clbkSetClassCaps, and all vessels share
+//the result.
+
+struct XB70Config{
+    //Physical parameters
+    double size = 22.8;                         //Mean radius [m]
+    double empty_mass = 115031;                 //[kg]
+    double fuel_mass = 140000;                  //JP-6 capacity [kg]
+    VECTOR3 cs = {199.5443, 585.7, 33.2172};    //Cross sections [m^2]
+    double wheelbrake_force = 25e5;             //[N]
+
+    //Engines (six, one thruster each). This module has no engine table or
+    //afterburner: the thrusters are rated at the dry thrust with a fixed Isp.
+    double isp = 2e4;                           //Fuel-specific impulse [m/s]
+    double dry_thrust = 89e3;                   //Thrust of each engine [N]
+
+    //Actuator operating speeds [1/s]
+    double gear_speed = 0.25;
+    double door_speed = 0.25;
+
+    //Airfoils: chord [m], reference area [m^2], aspect ratio and span
+    //efficiency (induced drag)
+    double vlift_chord = 23.94, vlift_area = 585.07, vlift_aspect = 1.751, vlift_efficiency = 1;
+    double hlift_chord = 5.01, hlift_area = 21.74, hlift_aspect = 1, hlift_efficiency = 0.6;
+
+    //Control surfaces: area of each surface [m^2] and lift gradient
+    double aileron_area = 18.37, aileron_dcl = 1.7;
+    double canard_area = 38.61, canard_dcl = 1.7;
+    double elevator_area = 36.74, elevator_dcl = 1.7;  //Elevator and elevator trim
+
+    //Reads the items cfg contains over the current values. Returns the
+    //number of items found.
+    int Read(FILEHANDLE cfg);
+};
+
+#endif //!__XB70CONFIG_H
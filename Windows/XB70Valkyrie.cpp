@@ -13,34 +13,51 @@
 
 #define ORBITER_MODULE
 #include "XB70Valkyrie.h"
+#include "XB70AeroTables.h"
+#include "XB70_mesh_groups.h"
 #include <cstring>
 #include <cstdio>
 #include <cstdint>
 #include <algorithm>
 
 
+// Aerodynamic coefficient tables. The breakpoints are resampled onto uniform
+// grids when the module is loaded (see XB70AeroTables.h); define
+// XB70_EXACT_AERO to evaluate the original breakpoint interpolation instead.
+
+static const int VLIFT_NABSC = 7;
+static const double VLIFT_AOA[VLIFT_NABSC] = {  -4*RAD, -2*RAD,  0*RAD,  2*RAD,  4*RAD, 6*RAD, 8*RAD,};
+static const double VLIFT_CL[VLIFT_NABSC]  = {   -0.14,  -0.11,  -0.02,   0.06,   0.13,  0.20,  0.28,};
+static const double VLIFT_CM[VLIFT_NABSC]  = {    0.02,      0,      0,      0,      0,     0, -0.01,};
+static const double *const VLIFT_COEFFS[2] = {VLIFT_CL, VLIFT_CM};
+
+static const int HLIFT_NABSC = 8;
+static const double HLIFT_BETA[HLIFT_NABSC] = {-180*RAD,-135*RAD,-90*RAD,-45*RAD,45*RAD,90*RAD,135*RAD,180*RAD};
+static const double HLIFT_CL[HLIFT_NABSC]   = {       0,    +0.3,      0,   -0.3,  +0.3,     0,   -0.3,      0};
+static const double *const HLIFT_COEFFS[1] = {HLIFT_CL};
+
+const AeroTable<2> vlift_table(VLIFT_AOA, VLIFT_COEFFS, VLIFT_NABSC, 0.25*RAD);
+const AeroTable<1> hlift_table(HLIFT_BETA, HLIFT_COEFFS, HLIFT_NABSC, 0.25*RAD);
+
+//Class parameters (XB70Config.h), read by the first clbkSetClassCaps.
+static XB70Config class_config;
+static bool class_config_loaded = false;
+
 // 1. vertical lift component (code from DeltaGlider)
 
 void VLiftCoeff (VESSEL *v, double aoa, double M, double Re, void *context, double *cl, double *cm, double *cd)
 {
-	const int nabsc = 7;
-	static const double AOA[nabsc] = {  -4*RAD, -2*RAD,  0*RAD,  2*RAD,  4*RAD, 6*RAD, 8*RAD,};
-	static const double CL[nabsc]  = {   -0.14,  -0.11,  -0.02,   0.06,   0.13,  0.20,  0.28,};
-	static const double CM[nabsc]  = {    0.02,      0,      0,      0,      0,     0, -0.01,};
-	int i;
-	for (i = 0; i < nabsc-1 && AOA[i+1] < aoa; i++);
-	if (i < nabsc - 1) {
-		double f = (aoa - AOA[i]) / (AOA[i + 1] - AOA[i]);
-		*cl = CL[i] + (CL[i + 1] - CL[i]) * f;  // aoa-dependent lift coefficient
-		*cm = CM[i] + (CM[i + 1] - CM[i]) * f;  // aoa-dependent moment coefficient
-	}
-	else {
-		*cl = CL[nabsc - 1];
-		*cm = CM[nabsc - 1];
-	}
+	double c[2];
+#ifdef XB70_EXACT_AERO
+	vlift_table.EvalExact(aoa, c);
+#else
+	vlift_table.Eval(aoa, c);
+#endif
+	*cl = c[0];  // aoa-dependent lift coefficient
+	*cm = c[1];  // aoa-dependent moment coefficient
 	double saoa = sin(aoa);
 	double pd = 0.015 + 0.4*saoa*saoa;  // profile drag
-	*cd = pd + oapiGetInducedDrag (*cl, XB70_VLIFT_A, 1) + oapiGetWaveDrag (M, 0.6, 0.75, 0.8, 0.95);
+	*cd = pd + oapiGetInducedDrag (*cl, class_config.vlift_aspect, class_config.vlift_efficiency) + oapiGetWaveDrag (M, 0.6, 0.75, 0.8, 0.95);
 	// profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
 }
 
@@ -48,19 +65,13 @@ void VLiftCoeff (VESSEL *v, double aoa, double M, double Re, void *context, doub
 
 void HLiftCoeff (VESSEL *v, double beta, double M, double Re, void *context, double *cl, double *cm, double *cd)
 {
-	int i;
-	const int nabsc = 8;
-	static const double BETA[nabsc] = {-180*RAD,-135*RAD,-90*RAD,-45*RAD,45*RAD,90*RAD,135*RAD,180*RAD};
-	static const double CL[nabsc]   = {       0,    +0.3,      0,   -0.3,  +0.3,     0,   -0.3,      0};
-	for (i = 0; i < nabsc-1 && BETA[i+1] < beta; i++);
-	if (i < nabsc - 1) {
-		*cl = CL[i] + (CL[i + 1] - CL[i]) * (beta - BETA[i]) / (BETA[i + 1] - BETA[i]);
-	}
-	else {
-		*cl = CL[nabsc - 1];
-	}
+#ifdef XB70_EXACT_AERO
+	hlift_table.EvalExact(beta, cl);
+#else
+	hlift_table.Eval(beta, cl);
+#endif
 	*cm = 0.0;
-	*cd = 0.015 + oapiGetInducedDrag (*cl, XB70_HLIFT_A, 0.6) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+	*cd = 0.015 + oapiGetInducedDrag (*cl, class_config.hlift_aspect, class_config.hlift_efficiency) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
 }
 
 
@@ -90,7 +101,7 @@ XB70::~XB70(){
 void XB70::DefineAnimations(void){
 
     //Landing gear
-    static unsigned int FrontLandingGearGrp[3] = {10, 11, 12};
+    static unsigned int FrontLandingGearGrp[3] = {Front_landing_gear_Id, Front_landing_gear_door_Id, Front_wheels_landing_gear_Id};
     static MGROUP_ROTATE FrontLandingGear_Rotate(
         0,
         FrontLandingGearGrp,
@@ -100,7 +111,11 @@ void XB70::DefineAnimations(void){
         (float)(2.2689)
     );
 
-    static unsigned int RearLandingGearGrp[7] = {13, 14, 19, 20, 21, 22, 23};
+    static unsigned int RearLandingGearGrp[7] = {
+        Front_wheels_rear_left_landing_gear_Id, Front_wheels_rear_right_landing_gear_Id,
+        Rear_landing_gears_doors_Id, Rear_left_landing_gear_Id, Rear_right_landing_gear_Id,
+        Rear_wheels_rear_left_landing_gear_Id, Rear_wheels_rear_right_landing_gear_Id
+    };
     static MGROUP_ROTATE RearLandingGear_Rotate(
         0,
         RearLandingGearGrp,
@@ -110,7 +125,7 @@ void XB70::DefineAnimations(void){
         (float)(1.6057)
     );
 
-    static unsigned int DoorOpenGrp[1] = {6};
+    static unsigned int DoorOpenGrp[1] = {Door_Id};
     static MGROUP_ROTATE DoorOpen(
         0,
         DoorOpenGrp,
@@ -129,7 +144,7 @@ void XB70::DefineAnimations(void){
 
     AddAnimationComponent(anim_door, 0, 1, &DoorOpen);
 
-    static unsigned int ElevatorTrimGrp[2] = {29, 30};
+    static unsigned int ElevatorTrimGrp[2] = {hlaileron_Id, hraileron_Id};
     static MGROUP_ROTATE ElevatorTrim(
         0,
         ElevatorTrimGrp,
@@ -141,7 +156,7 @@ void XB70::DefineAnimations(void){
     anim_elevatortrim = CreateAnimation(0.5);
     AddAnimationComponent(anim_elevatortrim, 0, 1, &ElevatorTrim);
 
-    static unsigned int LeftAileronGrp[1] = {29};
+    static unsigned int LeftAileronGrp[1] = {hlaileron_Id};
     static MGROUP_ROTATE LAileron(
         0,
         LeftAileronGrp,
@@ -153,7 +168,7 @@ void XB70::DefineAnimations(void){
     anim_laileron = CreateAnimation(0.5);
     AddAnimationComponent(anim_laileron, 0, 1, &LAileron);
 
-    static unsigned int RightAileronGrp[1] = {30};
+    static unsigned int RightAileronGrp[1] = {hraileron_Id};
     static MGROUP_ROTATE RAileron(
         0,
         RightAileronGrp,
@@ -165,7 +180,7 @@ void XB70::DefineAnimations(void){
     anim_raileron = CreateAnimation(0.5);
     AddAnimationComponent(anim_raileron, 0, 1, &RAileron);
 
-    static unsigned int ElevatorGrp[2] = {29, 30};
+    static unsigned int ElevatorGrp[2] = {hlaileron_Id, hraileron_Id};
     static MGROUP_ROTATE Elevator(
         0,
         ElevatorGrp,
@@ -177,7 +192,7 @@ void XB70::DefineAnimations(void){
     anim_elevator = CreateAnimation(0.5);
     AddAnimationComponent(anim_elevator, 0, 1, &Elevator);
 
-    static unsigned int CanardsGrp[1] = {1};
+    static unsigned int CanardsGrp[1] = {Canards_Id};
     static MGROUP_ROTATE Canards(
         0,
         CanardsGrp,
@@ -195,26 +210,33 @@ void XB70::DefineAnimations(void){
 // Set the capabilities of the vessel class
 void XB70::clbkSetClassCaps(FILEHANDLE cfg){
 
+    //Class parameters: the config file is read by the first vessel only.
+    if(!class_config_loaded){
+        class_config.Read(cfg);
+        class_config_loaded = true;
+    }
+    const XB70Config &c = class_config;
+
     //Define thrusters
     THRUSTER_HANDLE th_main[6];
     THGROUP_HANDLE thg_main;
 
     //Physical vessel resources
-    SetSize(XB70_SIZE);
-    SetEmptyMass(XB70_EMPTYMASS);
-    SetCrossSections(XB70_CS);
-    SetMaxWheelbrakeForce(25e5);
+    SetSize(c.size);
+    SetEmptyMass(c.empty_mass);
+    SetCrossSections(c.cs);
+    SetMaxWheelbrakeForce(c.wheelbrake_force);
 
     //Propellant resources
-    PROPELLANT_HANDLE JP6 = CreatePropellantResource(XB70_FUELMASS);
+    PROPELLANT_HANDLE JP6 = CreatePropellantResource(c.fuel_mass);
 
     //Define main engine
-    th_main[0] = CreateThruster(_V(-3.6722, -0.8294, -25.5365), _V(0, 0, 1), XB70_MAXMAINTH, JP6, XB70_ISP);
-    th_main[1] = CreateThruster(_V(-2.2222, -0.8294, -25.5401), _V(0, 0, 1), XB70_MAXMAINTH, JP6, XB70_ISP);
-    th_main[2] = CreateThruster(_V(-0.8022, -0.8294, -25.5437), _V(0, 0, 1), XB70_MAXMAINTH, JP6, XB70_ISP);
-    th_main[3] = CreateThruster(_V(0.6378, -0.8294, -25.5473), _V(0, 0, 1), XB70_MAXMAINTH, JP6, XB70_ISP);
-    th_main[4] = CreateThruster(_V(2.0678, -0.8294, -25.5509), _V(0, 0, 1), XB70_MAXMAINTH, JP6, XB70_ISP);
-    th_main[5] = CreateThruster(_V(3.5278, -0.8294, -25.5545), _V(0, 0, 1), XB70_MAXMAINTH, JP6, XB70_ISP);
+    th_main[0] = CreateThruster(_V(-3.6722, -0.8294, -25.5365), _V(0, 0, 1), c.dry_thrust, JP6, c.isp);
+    th_main[1] = CreateThruster(_V(-2.2222, -0.8294, -25.5401), _V(0, 0, 1), c.dry_thrust, JP6, c.isp);
+    th_main[2] = CreateThruster(_V(-0.8022, -0.8294, -25.5437), _V(0, 0, 1), c.dry_thrust, JP6, c.isp);
+    th_main[3] = CreateThruster(_V(0.6378, -0.8294, -25.5473), _V(0, 0, 1), c.dry_thrust, JP6, c.isp);
+    th_main[4] = CreateThruster(_V(2.0678, -0.8294, -25.5509), _V(0, 0, 1), c.dry_thrust, JP6, c.isp);
+    th_main[5] = CreateThruster(_V(3.5278, -0.8294, -25.5545), _V(0, 0, 1), c.dry_thrust, JP6, c.isp);
     thg_main = CreateThrusterGroup(th_main, 6, THGROUP_MAIN);
 
     SURFHANDLE exhaust_tex = oapiRegisterExhaustTexture("Exhaust");
@@ -244,21 +266,21 @@ void XB70::clbkSetClassCaps(FILEHANDLE cfg){
 
     //Code from DeltaGlider
 
-    hwing = CreateAirfoil3 (LIFT_VERTICAL, _V(-0.0958, 0.0574, -11.9142), VLiftCoeff, 0, XB70_VLIFT_C, XB70_VLIFT_S, XB70_VLIFT_A);
+    hwing = CreateAirfoil3 (LIFT_VERTICAL, _V(-0.0958, 0.0574, -11.9142), VLiftCoeff, 0, c.vlift_chord, c.vlift_area, c.vlift_aspect);
 	// wing and body lift+drag components
 
-	CreateAirfoil3 (LIFT_HORIZONTAL, _V(0.0789, 1.8259, -24.2352), HLiftCoeff, 0, XB70_HLIFT_C, XB70_HLIFT_S, XB70_HLIFT_A);
+	CreateAirfoil3 (LIFT_HORIZONTAL, _V(0.0789, 1.8259, -24.2352), HLiftCoeff, 0, c.hlift_chord, c.hlift_area, c.hlift_aspect);
 	// vertical stabiliser and body lift and drag components
     
     
-	hlaileron = CreateControlSurface3 (AIRCTRL_AILERON, 18.37, 1.7, _V(-7.6463, 0.3196, -26.8960), AIRCTRL_AXIS_XPOS, 1.0, anim_raileron);
-	hraileron = CreateControlSurface3 (AIRCTRL_AILERON, 18.37, 1.7, _V(7.4547, 0.3174, -26.8053), AIRCTRL_AXIS_XNEG, 1.0, anim_laileron);
+	hlaileron = CreateControlSurface3 (AIRCTRL_AILERON, c.aileron_area, c.aileron_dcl, _V(-7.6463, 0.3196, -26.8960), AIRCTRL_AXIS_XPOS, 1.0, anim_raileron);
+	hraileron = CreateControlSurface3 (AIRCTRL_AILERON, c.aileron_area, c.aileron_dcl, _V(7.4547, 0.3174, -26.8053), AIRCTRL_AXIS_XNEG, 1.0, anim_laileron);
 
-    canards = CreateControlSurface3(AIRCTRL_ELEVATOR, 38.61, 1.7, _V(-0.0440, 1.4532, 14.7854),AIRCTRL_AXIS_XPOS, 1.0, anim_canards);
+    canards = CreateControlSurface3(AIRCTRL_ELEVATOR, c.canard_area, c.canard_dcl, _V(-0.0440, 1.4532, 14.7854),AIRCTRL_AXIS_XPOS, 1.0, anim_canards);
 
-    CreateControlSurface3 (AIRCTRL_ELEVATOR, 36.74, 1.7, _V(-0.0833, 0.3068, -26.6097), AIRCTRL_AXIS_XPOS, 1.0, anim_elevator);
+    CreateControlSurface3 (AIRCTRL_ELEVATOR, c.elevator_area, c.elevator_dcl, _V(-0.0833, 0.3068, -26.6097), AIRCTRL_AXIS_XPOS, 1.0, anim_elevator);
 	CreateControlSurface3 
-    (AIRCTRL_ELEVATORTRIM, 36.74, 1.7, _V(-0.0833, 0.3068, -26.6097), AIRCTRL_AXIS_XPOS, 1.0, anim_elevatortrim);
+    (AIRCTRL_ELEVATORTRIM, c.elevator_area, c.elevator_dcl, _V(-0.0833, 0.3068, -26.6097), AIRCTRL_AXIS_XPOS, 1.0, anim_elevatortrim);
 }
 
 
@@ -325,7 +347,7 @@ void XB70::clbkPostStep(double simt, double simdt, double mjd){
 
 void XB70::UpdateLandingGearAnimation(double simdt) {
     if (landing_gear_status >= GEAR_DEPLOYING) {
-        double da = simdt * LANDING_GEAR_OPERATING_SPEED;
+        double da = simdt * class_config.gear_speed;
         if (landing_gear_status == GEAR_DEPLOYING) {
             if (landing_gear_proc > 0.0) landing_gear_proc = max(0.0, landing_gear_proc - da);
             else landing_gear_status = GEAR_DOWN;
@@ -341,7 +363,7 @@ void XB70::UpdateLandingGearAnimation(double simdt) {
 
 void XB70::UpdateDoorAnimation(double simdt) {
     if (door_status >= DOOR_CLOSING) {
-        double da = simdt * LANDING_GEAR_OPERATING_SPEED;
+        double da = simdt * class_config.door_speed;
         if (door_status == DOOR_CLOSING) {
             if (door_proc > 0.0) door_proc = max(0.0, door_proc - da);
             else door_status = DOOR_CLOSED;
@@ -5,36 +5,7 @@
 #include "OrbiterAPI.h"
 #include "Orbitersdk.h"
 #include "VesselAPI.h"
-
-//Vessel parameters
-const double XB70_SIZE = 22.8;  //Mean radius in meters.
-
-const double XB70_EMPTYMASS = 115031; //Empty mass in kg.
-
-const double XB70_FUELMASS = 140000; //Fuel mass in kg.
-
-const double XB70_ISP = 2e4; //Fuel-specific impulse in m/s.
-
-const double XB70_MAXMAINTH = 89e3; //Max main thrust in kN.
-
-const double XB70_AFTERBRNTH = 120e3; //Max afterburner thrust.
-
-const double LANDING_GEAR_OPERATING_SPEED = 0.25;
-
-const VECTOR3 XB70_CS = {199.5443, 585.7, 33.2172};
-
-const double XB70_VLIFT_C = 23.94; //Chord lenght in m.
-
-const double XB70_VLIFT_S = 585.07; //Wing area in m^2.
-
-const double XB70_VLIFT_A = 1.751; //Wing aspect ratio.
-
-const double XB70_HLIFT_C = 5.01;
-
-const double XB70_HLIFT_S = 21.74;
-
-const double XB70_HLIFT_A = 1;
-
+#include "XB70Config.h"
 
 //Define touchdown points
 //For gear down
@@ -0,0 +1,96 @@
+// Generated by Linux/Tools/xb70_meshdefs from Meshes/XB-70_Valkyrie.msh.
+// Do not edit: regenerate it whenever the mesh changes.
+
+
+#include "Orbitersdk.h"
+
+#ifndef __XB70_MESH_GROUPS_H
+#define __XB70_MESH_GROUPS_H
+
+    constexpr UINT MESH_NGROUP = 26;
+
+    constexpr UINT Canards_Id = 0;
+    constexpr UINT Static_Cylinder_Id = 1;
+    constexpr UINT Static_Delta_wing_Id = 2;
+    constexpr UINT Delta_wing_left_Id = 3;
+    constexpr UINT Delta_wing_right_Id = 4;
+    constexpr UINT Door_Id = 5;
+    constexpr UINT Static_Engine_intake_Id = 6;
+    constexpr UINT Static_Engines_Id = 7;
+    constexpr UINT Static_White_metal_Id = 8;
+    constexpr UINT Front_landing_gear_Id = 9;
+    constexpr UINT Front_landing_gear_door_Id = 10;
+    constexpr UINT Front_wheels_landing_gear_Id = 11;
+    constexpr UINT Front_wheels_rear_left_landing_gear_Id = 12;
+    constexpr UINT Front_wheels_rear_right_landing_gear_Id = 13;
+    constexpr UINT LRudder_Id = 14;
+    constexpr UINT Static_Black_metal_Id = 15;
+    constexpr UINT RRudder_Id = 16;
+    constexpr UINT Rear_landing_gears_doors_Id = 17;
+    constexpr UINT Rear_left_landing_gear_Id = 18;
+    constexpr UINT Rear_right_landing_gear_Id = 19;
+    constexpr UINT Rear_wheels_rear_left_landing_gear_Id = 20;
+    constexpr UINT Rear_wheels_rear_right_landing_gear_Id = 21;
+    constexpr UINT Static_Aileron_Id = 22;
+    constexpr UINT Static_Glass_Id = 23;
+    constexpr UINT hlaileron_Id = 24;
+    constexpr UINT hraileron_Id = 25;
+
+    //Bounding box centres, in mesh coordinates.
+    constexpr VECTOR3 Canards_Centre = {-0.0434, 1.4869, 14.4550};
+    constexpr VECTOR3 Static_Cylinder_Centre = {-0.0795, 0.6651, 1.7039};
+    constexpr VECTOR3 Static_Delta_wing_Centre = {-0.0757, 0.0178, -9.6551};
+    constexpr VECTOR3 Delta_wing_left_Centre = {-12.7399, 0.2048, -20.7223};
+    constexpr VECTOR3 Delta_wing_right_Centre = {12.6058, 0.2032, -20.6935};
+    constexpr VECTOR3 Door_Centre = {-1.1841, 0.8608, 19.2021};
+    constexpr VECTOR3 Static_Engine_intake_Centre = {-0.0395, -1.1773, -10.4334};
+    constexpr VECTOR3 Static_Engines_Centre = {-0.0735, -0.8328, -25.3570};
+    constexpr VECTOR3 Static_White_metal_Centre = {-0.0559, 0.4512, 18.0431};
+    constexpr VECTOR3 Front_landing_gear_Centre = {-0.1310, -3.2771, 1.6637};
+    constexpr VECTOR3 Front_landing_gear_door_Centre = {-0.1066, -2.8527, 2.8075};
+    constexpr VECTOR3 Front_wheels_landing_gear_Centre = {-0.1268, -4.3340, 2.0856};
+    constexpr VECTOR3 Front_wheels_rear_left_landing_gear_Centre = {-3.5235, -4.3411, -11.4736};
+    constexpr VECTOR3 Front_wheels_rear_right_landing_gear_Centre = {3.4564, -4.3429, -12.9257};
+    constexpr VECTOR3 LRudder_Centre = {-4.5631, 2.8731, -27.4452};
+    constexpr VECTOR3 Static_Black_metal_Centre = {-0.0827, 0.2245, 2.4324};
+    constexpr VECTOR3 RRudder_Centre = {4.4207, 2.8731, -27.4678};
+    constexpr VECTOR3 Rear_landing_gears_doors_Centre = {-0.0495, -2.8796, -11.9408};
+    constexpr VECTOR3 Rear_left_landing_gear_Centre = {-3.5292, -2.6971, -12.2029};
+    constexpr VECTOR3 Rear_right_landing_gear_Centre = {3.4646, -2.6940, -12.2231};
+    constexpr VECTOR3 Rear_wheels_rear_left_landing_gear_Centre = {-3.5332, -4.3427, -12.9216};
+    constexpr VECTOR3 Rear_wheels_rear_right_landing_gear_Centre = {3.4583, -4.3583, -11.5034};
+    constexpr VECTOR3 Static_Aileron_Centre = {-0.0621, 2.6878, -23.7725};
+    constexpr VECTOR3 Static_Glass_Centre = {-0.0229, 1.4607, 21.6420};
+    constexpr VECTOR3 hlaileron_Centre = {-7.6340, 0.3022, -26.7418};
+    constexpr VECTOR3 hraileron_Centre = {7.4559, 0.2997, -26.6344};
+
+    constexpr const char *MESH_GROUP_LABEL[MESH_NGROUP] = {
+        "Canards",
+        "Static_Cylinder",
+        "Static_Delta_wing",
+        "Delta_wing_left",
+        "Delta_wing_right",
+        "Door",
+        "Static_Engine_intake",
+        "Static_Engines",
+        "Static_White_metal",
+        "Front_landing_gear",
+        "Front_landing_gear_door",
+        "Front_wheels_landing_gear",
+        "Front_wheels_rear_left_landing_gear",
+        "Front_wheels_rear_right_landing_gear",
+        "LRudder",
+        "Static_Black_metal",
+        "RRudder",
+        "Rear_landing_gears_doors",
+        "Rear_left_landing_gear",
+        "Rear_right_landing_gear",
+        "Rear_wheels_rear_left_landing_gear",
+        "Rear_wheels_rear_right_landing_gear",
+        "Static_Aileron",
+        "Static_Glass",
+        "hlaileron",
+        "hraileron",
+    };
+
+#endif